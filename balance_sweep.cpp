@@ -0,0 +1,438 @@
+#include "balance_sweep.h"
+#include "content_catalog.h"
+#include "scenario.h"
+#include "simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// Every configuration interns its own variants, so no sweep can exceed
+// one content table; fitsCatalog() applies the exact limit.
+const long long MAX_CONFIGURATIONS = CONTENT_ID_LIMIT;
+
+// Content-file keys a sweep may vary, per kind.
+bool setField(Weapon& w, const std::string& key, double v) {
+    if (key == "attack") w.physicalAttack = static_cast<int>(std::lround(v));
+    else if (key == "accuracy") w.accuracy = static_cast<float>(v);
+    else if (key == "range") w.range = static_cast<float>(v);
+    else if (key == "hits") w.numberOfAttacks = static_cast<int>(std::lround(v));
+    else return false;
+    return true;
+}
+
+bool setField(Armor& a, const std::string& key, double v) {
+    if (key == "dr") a.damageResistance = static_cast<int>(std::lround(v));
+    else if (key == "dt") a.damageThreshold = static_cast<int>(std::lround(v));
+    else if (key == "evasion") a.evasion = static_cast<float>(v);
+    else if (key == "magdef") a.magicalDefense = static_cast<int>(std::lround(v));
+    else return false;
+    return true;
+}
+
+bool setField(Spell& s, const std::string& key, double v) {
+    if (key == "attack") s.magicalAttack = static_cast<int>(std::lround(v));
+    else if (key == "cost") s.mpCost = static_cast<int>(std::lround(v));
+    else if (key == "range") s.range = static_cast<float>(v);
+    else if (key == "duration") s.duration = static_cast<int>(std::lround(v));
+    else if (key == "aoe") s.aoe = static_cast<int>(std::lround(v));
+    else return false;
+    return true;
+}
+
+bool knownKey(const std::string& kind, const std::string& key) {
+    if (kind == "weapon") {
+        Weapon w;
+        return setField(w, key, 0.0);
+    }
+    if (kind == "armor") {
+        Armor a;
+        return setField(a, key, 0.0);
+    }
+    Spell s("", 0, 0, 0.0f, 0, "None", 0, "Debuff");
+    return setField(s, key, 0.0);
+}
+
+bool parseNumber(const std::string& text, double& out) {
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+
+// "low..high:step" or a single value.
+bool parseRange(const std::string& text, std::vector<double>& values) {
+    values.clear();
+    size_t dots = text.find("..");
+    if (dots == std::string::npos) {
+        double v;
+        if (!parseNumber(text, v)) return false;
+        values.push_back(v);
+        return true;
+    }
+    size_t colon = text.find(':', dots);
+    double low, high, step;
+    if (colon == std::string::npos || !parseNumber(text.substr(0, dots), low) ||
+        !parseNumber(text.substr(dots + 2, colon - dots - 2), high) || !parseNumber(text.substr(colon + 1), step)) {
+        return false;
+    }
+    if (step <= 0.0 || high < low) return false;
+    // Index-based so float steps do not drift past `high`.
+    for (long long i = 0; low + i * step <= high + step * 1e-9; ++i) {
+        values.push_back(low + i * step);
+        if (static_cast<long long>(values.size()) > MAX_CONFIGURATIONS) return false;
+    }
+    return true;
+}
+
+// Wald's sequential test of p0 against p1 on `wins` of `n` Bernoulli trials:
+// -1 accepts p0, +1 accepts p1, 0 wants more samples.
+int sprt(long long wins, long long n, double p0, double p1, double alpha, double beta) {
+    p0 = std::min(std::max(p0, 1e-3), 1.0 - 1e-3);
+    p1 = std::min(std::max(p1, 1e-3), 1.0 - 1e-3);
+    double llr = wins * std::log(p1 / p0) + (n - wins) * std::log((1.0 - p1) / (1.0 - p0));
+    if (llr >= std::log((1.0 - beta) / alpha)) return 1;
+    if (llr <= std::log(beta / (1.0 - alpha))) return -1;
+    return 0;
+}
+
+SweepVerdict judge(long long wins, long long n, const SweepOptions& o) {
+    int lower = sprt(wins, n, o.bandLow - o.indifference, o.bandLow + o.indifference, o.alpha, o.beta);
+    int upper = sprt(wins, n, o.bandHigh - o.indifference, o.bandHigh + o.indifference, o.alpha, o.beta);
+    if (lower < 0) return SweepVerdict::TooWeak;
+    if (upper > 0) return SweepVerdict::TooStrong;
+    if (lower > 0 && upper < 0) return SweepVerdict::InBand;
+    return SweepVerdict::Undecided;
+}
+
+const char* verdictName(SweepVerdict verdict) {
+    switch (verdict) {
+    case SweepVerdict::InBand: return "in band";
+    case SweepVerdict::TooWeak: return "too weak";
+    case SweepVerdict::TooStrong: return "too strong";
+    default: return "undecided";
+    }
+}
+
+// Each configuration interns one variant of every swept definition. False
+// with `error` set when that needs more ids of a kind than its table has
+// left.
+bool fitsCatalog(const SweepSpec& spec, std::string& error) {
+    const ContentCatalog& catalog = contentCatalog();
+    const char* kinds[] = { "weapon", "armor", "spell" };
+    const int used[] = { catalog.weaponCount(), catalog.armorCount(), catalog.spellCount() };
+    long long configurations = spec.configurationCount();
+    for (int k = 0; k < 3; ++k) {
+        std::vector<std::string> names;
+        for (const SweepAxis& axis : spec.axes) {
+            if (axis.kind == kinds[k] && std::find(names.begin(), names.end(), axis.name) == names.end()) {
+                names.push_back(axis.name);
+            }
+        }
+        long long needed = configurations * static_cast<long long>(names.size());
+        long long free = CONTENT_ID_LIMIT - used[k];
+        if (needed > free) {
+            error = std::to_string(configurations) + " configurations need " + std::to_string(needed) + " new " +
+                kinds[k] + " definitions, but only " + std::to_string(free) + " " + kinds[k] + " ids are free";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Swaps every use of one definition for another.
+struct Replacement {
+    int kind;       // 0 weapon, 1 armor, 2 spell
+    uint16_t from;
+    uint16_t to;
+};
+
+struct ConfigProgress {
+    long long claimed = 0;
+    long long battles = 0;
+    long long wins = 0;
+    SweepVerdict verdict = SweepVerdict::Undecided;
+    bool settled = false;
+};
+
+} // namespace
+
+bool SweepSpec::parse(const std::string& text, std::string& error) {
+    std::istringstream in(text);
+    std::string line;
+    std::vector<std::string> words;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        auto fail = [&](const std::string& why) {
+            error = "line " + std::to_string(lineNumber) + ": " + why;
+            return false;
+        };
+        if (!tokenizeContentLine(line, words, error)) return fail(error);
+        if (words.empty()) continue;
+        if (words.size() < 3) return fail("expected a kind, a name and at least one key=range");
+        const std::string& kind = words[0];
+        if (kind != "weapon" && kind != "armor" && kind != "spell") return fail("cannot sweep '" + kind + "'");
+
+        for (size_t i = 2; i < words.size(); ++i) {
+            size_t eq = words[i].find('=');
+            if (eq == std::string::npos) return fail("expected key=range, got '" + words[i] + "'");
+            SweepAxis axis;
+            axis.kind = kind;
+            axis.name = words[1];
+            axis.key = words[i].substr(0, eq);
+            if (!knownKey(kind, axis.key)) return fail("cannot sweep '" + axis.key + "' of a " + kind);
+            if (!parseRange(words[i].substr(eq + 1), axis.values)) {
+                return fail("bad range for " + axis.key + ": '" + words[i].substr(eq + 1) + "'");
+            }
+            axes.push_back(axis);
+        }
+    }
+    if (configurationCount() > MAX_CONFIGURATIONS) {
+        error = "more than " + std::to_string(MAX_CONFIGURATIONS) + " configurations";
+        return false;
+    }
+    return fitsCatalog(*this, error);
+}
+
+bool SweepSpec::loadFile(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    if (!parse(text.str(), error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+long long SweepSpec::configurationCount() const {
+    long long count = 1;
+    for (const SweepAxis& axis : axes) {
+        count *= static_cast<long long>(axis.values.size());
+        if (count > MAX_CONFIGURATIONS) return MAX_CONFIGURATIONS + 1;
+    }
+    return count;
+}
+
+bool runSweep(const SweepSpec& spec, const SweepOptions& options, SweepResult& result, std::string& error) {
+    auto build = [&options]() {
+        if (options.scenario) return options.scenario->instantiate();
+        if (options.skirmishUnits > 0) return buildSkirmishScenario(options.skirmishUnits);
+        return buildDefaultScenario();
+    };
+    // Building once up front also loads the built-in content the names refer
+    // to, which may leave fewer ids free than when the spec was parsed.
+    build();
+    if (!fitsCatalog(spec, error)) return false;
+
+    // Axes naming the same definition vary it together.
+    ContentCatalog& catalog = contentCatalog();
+    struct Target {
+        int kind;
+        std::string name;
+        int original;
+        std::vector<int> axes;
+    };
+    std::vector<Target> targets;
+    for (int a = 0; a < static_cast<int>(spec.axes.size()); ++a) {
+        const SweepAxis& axis = spec.axes[a];
+        int kind = axis.kind == "weapon" ? 0 : axis.kind == "armor" ? 1 : 2;
+        auto same = [&](const Target& t) { return t.kind == kind && t.name == axis.name; };
+        auto found = std::find_if(targets.begin(), targets.end(), same);
+        if (found == targets.end()) {
+            int original = kind == 0 ? catalog.findWeapon(axis.name)
+                : kind == 1 ? catalog.findArmor(axis.name) : catalog.findSpell(axis.name);
+            if (original < 0) {
+                error = "no " + axis.kind + " named \"" + axis.name + "\"";
+                return false;
+            }
+            targets.push_back(Target{ kind, axis.name, original, {} });
+            found = targets.end() - 1;
+        }
+        found->axes.push_back(a);
+    }
+
+    // Intern each configuration's variants once; variants keep the original
+    // name, so findWeapon and friends still return the original.
+    long long configCount = spec.configurationCount();
+    std::vector<std::vector<Replacement>> replacements(configCount);
+    result = SweepResult();
+    result.axes = spec.axes;
+    result.options = options;
+    result.outcomes.resize(configCount);
+    for (long long c = 0; c < configCount; ++c) {
+        std::vector<double>& values = result.outcomes[c].values;
+        long long rest = c;
+        for (const SweepAxis& axis : spec.axes) {
+            values.push_back(axis.values[rest % axis.values.size()]);
+            rest /= static_cast<long long>(axis.values.size());
+        }
+        for (const Target& t : targets) {
+            int variant;
+            if (t.kind == 0) {
+                Weapon w = catalog.weapon(static_cast<WeaponId>(t.original));
+                for (int a : t.axes) setField(w, spec.axes[a].key, values[a]);
+                variant = catalog.intern(w);
+            }
+            else if (t.kind == 1) {
+                Armor armor = catalog.armor(static_cast<ArmorId>(t.original));
+                for (int a : t.axes) setField(armor, spec.axes[a].key, values[a]);
+                variant = catalog.intern(armor);
+            }
+            else {
+                Spell s = catalog.spell(static_cast<SpellId>(t.original));
+                for (int a : t.axes) setField(s, spec.axes[a].key, values[a]);
+                variant = catalog.intern(s);
+            }
+            replacements[c].push_back(Replacement{ t.kind, static_cast<uint16_t>(t.original), static_cast<uint16_t>(variant) });
+        }
+    }
+
+    int threads = options.threads;
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    std::mutex lock;
+    std::vector<ConfigProgress> progress(configCount);
+
+    // Under `lock`: the unsettled configuration with the fewest battles
+    // claimed, or -1 when every configuration is settled or at the cap.
+    auto claim = [&](long long& first, long long& last) {
+        long long best = -1;
+        for (long long c = 0; c < configCount; ++c) {
+            const ConfigProgress& p = progress[c];
+            if (p.settled || p.claimed >= options.maxBattles) continue;
+            if (best < 0 || p.claimed < progress[best].claimed) best = c;
+        }
+        if (best < 0) return best;
+        first = progress[best].claimed;
+        last = std::min(first + std::max(options.battlesPerClaim, 1), options.maxBattles);
+        progress[best].claimed = last;
+        return best;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            auto battle = build();
+            BattleState opening;
+            battle->saveState(opening);
+
+            // What each unit carried before any replacement.
+            std::vector<WeaponId> weapons;
+            std::vector<ArmorId> armors;
+            std::vector<std::vector<SpellId>> spells;
+            for (Combatant* unit : battle->units) {
+                weapons.push_back(unit->getWeaponId());
+                armors.push_back(unit->getArmorId());
+                spells.emplace_back(unit->getSpells().begin(), unit->getSpells().end());
+            }
+            auto equip = [&](const std::vector<Replacement>& config) {
+                auto swap = [&config](int kind, uint16_t id) {
+                    for (const Replacement& r : config) {
+                        if (r.kind == kind && r.from == id) return r.to;
+                    }
+                    return id;
+                };
+                for (size_t u = 0; u < battle->units.size(); ++u) {
+                    Combatant* unit = battle->units[u];
+                    unit->equipWeapon(swap(0, weapons[u]));
+                    unit->equipArmor(swap(1, armors[u]));
+                    for (size_t s = 0; s < spells[u].size(); ++s) unit->replaceSpell(static_cast<int>(s), swap(2, spells[u][s]));
+                }
+            };
+
+            while (true) {
+                long long first = 0, last = 0, config;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    config = claim(first, last);
+                }
+                if (config < 0) break;
+
+                equip(replacements[config]);
+                long long wins = 0;
+                for (long long i = first; i < last; ++i) {
+                    battle->restoreState(opening);
+                    battle->manager.getRng().reseed(options.seed, static_cast<uint64_t>(i));
+                    if (runHeadlessBattle(*battle) == "Good Guys") wins++;
+                }
+
+                std::lock_guard<std::mutex> guard(lock);
+                ConfigProgress& p = progress[config];
+                p.battles += last - first;
+                p.wins += wins;
+                p.verdict = judge(p.wins, p.battles, options);
+                p.settled = p.verdict != SweepVerdict::Undecided;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (long long c = 0; c < configCount; ++c) {
+        SweepOutcome& outcome = result.outcomes[c];
+        outcome.battles = progress[c].battles;
+        outcome.wins = progress[c].wins;
+        outcome.verdict = progress[c].verdict;
+        result.battles += outcome.battles;
+    }
+    double centre = (options.bandLow + options.bandHigh) / 2.0;
+    std::stable_sort(result.outcomes.begin(), result.outcomes.end(), [centre](const SweepOutcome& a, const SweepOutcome& b) {
+        return std::abs(a.winRate() - centre) < std::abs(b.winRate() - centre);
+    });
+    return true;
+}
+
+void SweepResult::print() const {
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    std::cout << "=== BALANCE SWEEP ===\n"
+        << "Configurations: " << outcomes.size() << ", battles: " << battles << " in " << seconds << "s\n"
+        << std::fixed << std::setprecision(1)
+        << "Target band:    Good Guys win " << options.bandLow * 100.0 << "% to " << options.bandHigh * 100.0
+        << "% (+/- " << options.indifference * 100.0 << "% indifference, at most " << options.maxBattles
+        << " battles each)\n";
+
+    std::cout << std::right << std::setw(5) << "Rank";
+    for (const SweepAxis& axis : axes) std::cout << "  " << std::setw(std::max<int>(8, axis.label().size())) << axis.label();
+    std::cout << std::setw(9) << "Battles" << std::setw(8) << "Win%" << std::setw(16) << "95% CI" << "  Verdict\n";
+
+    for (size_t r = 0; r < outcomes.size(); ++r) {
+        const SweepOutcome& o = outcomes[r];
+        std::cout << std::setw(5) << r + 1;
+        for (size_t a = 0; a < axes.size(); ++a) {
+            std::cout << "  " << std::setw(std::max<int>(8, axes[a].label().size())) << std::setprecision(2) << o.values[a];
+        }
+        // Wilson score interval.
+        double n = static_cast<double>(o.battles), p = o.winRate(), z = 1.96;
+        double low = 0.0, high = 0.0;
+        if (n > 0) {
+            double centre = (p + z * z / (2 * n)) / (1 + z * z / n);
+            double half = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+            low = centre - half;
+            high = centre + half;
+        }
+        std::ostringstream interval;
+        interval << std::fixed << std::setprecision(1) << low * 100.0 << "-" << high * 100.0 << "%";
+        std::cout << std::setw(9) << o.battles << std::setprecision(1) << std::setw(8) << p * 100.0
+            << std::setw(16) << interval.str() << "  " << verdictName(o.verdict) << "\n";
+    }
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
@@ -0,0 +1,92 @@
+#ifndef BALANCE_SWEEP_H
+#define BALANCE_SWEEP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "battle_file.h"
+
+// ==========================================
+// Balance Sweep
+// ==========================================
+// A sweep varies fields of existing weapon, armor and spell definitions and
+// plays headless battles for every combination. It is written in the
+// content-file format, with a range in place of each swept value:
+//   weapon "Iron Sword"  attack=30..70:10 accuracy=0.8..1.0:0.1
+//   spell  "Fireball"    cost=10..20:5
+// `low..high:step` visits low, low+step, ... up to high; a plain value pins
+// the field for every configuration. Each configuration replaces the named
+// definition on every unit that uses it.
+
+// One swept field.
+struct SweepAxis {
+    std::string kind;       // "weapon", "armor" or "spell"
+    std::string name;
+    std::string key;        // Content-file key, e.g. "attack"
+    std::vector<double> values;
+
+    std::string label() const { return name + "." + key; }
+};
+
+struct SweepSpec {
+    std::vector<SweepAxis> axes;
+
+    // Adds the axes in `text`. On a malformed line, or when the
+    // configurations would need more content ids than the catalog has free,
+    // stops and describes it in `error`.
+    bool parse(const std::string& text, std::string& error);
+    bool loadFile(const std::string& path, std::string& error);
+    // Number of combinations: the product of every axis' value count.
+    long long configurationCount() const;
+};
+
+struct SweepOptions {
+    // Target band for the Good Guys' win rate, and the half-width of the
+    // zone around each edge where either answer is acceptable.
+    double bandLow = 0.45;
+    double bandHigh = 0.55;
+    double indifference = 0.05;
+    // SPRT error rates: declaring a configuration outside the band when it
+    // sits at the near edge inside it (alpha), and the reverse (beta).
+    double alpha = 0.05;
+    double beta = 0.05;
+    long long maxBattles = 2000;        // Per configuration; undecided ones stop here
+    int battlesPerClaim = 32;
+    int threads = 0;                    // 0 = one per hardware thread
+    uint64_t seed = 0;
+    int skirmishUnits = 0;              // Per team; 0 = the default scenario
+    const BattleFileView* scenario = nullptr;   // Overrides both builders
+};
+
+enum class SweepVerdict : uint8_t { InBand, TooWeak, TooStrong, Undecided };
+
+struct SweepOutcome {
+    std::vector<double> values;     // One per axis
+    long long battles = 0;
+    long long wins = 0;
+    SweepVerdict verdict = SweepVerdict::Undecided;
+
+    double winRate() const { return battles > 0 ? static_cast<double>(wins) / battles : 0.0; }
+};
+
+struct SweepResult {
+    std::vector<SweepAxis> axes;
+    std::vector<SweepOutcome> outcomes;     // Closest to the band's centre first
+    SweepOptions options;
+    long long battles = 0;
+    double seconds = 0.0;
+
+    void print() const;
+};
+
+// Plays every configuration of `spec` in parallel. Battle i of each
+// configuration uses RNG stream i of the seed, so configurations are
+// compared on the same dice. Workers always pick the configuration with
+// the fewest battles claimed that is still undecided; after each finished
+// claim, a pair of SPRTs at the band edges may settle it early, so battles
+// concentrate on the borderline configurations. Returns false with
+// `error` set if a swept definition cannot be found or its variants would
+// not fit in the catalog.
+bool runSweep(const SweepSpec& spec, const SweepOptions& options, SweepResult& result, std::string& error);
+
+#endif
@@ -0,0 +1,123 @@
+#include "battle_action.h"
+
+namespace {
+
+bool itemUseful(const Item& item, const Combatant& target) {
+    if (item.category == ItemCategory::Healing) return target.getHP() < target.getMaxHP();
+    if (item.category == ItemCategory::RestoreMP) return target.getMP() < target.getMaxMP();
+    return true;
+}
+
+} // namespace
+
+void legalActions(BattleManager& battle, Grid& grid, Combatant* actor, std::vector<BattleAction>& out) {
+    size_t first = out.size();
+    const std::pmr::vector<Combatant*>& participants = battle.getParticipants();
+    int count = static_cast<int>(participants.size());
+
+    for (int slot = 0; slot < count; ++slot) {
+        Combatant* target = participants[slot];
+        if (!target->isAlive()) continue;
+        bool isAlly = target->getTeamId() == actor->getTeamId();
+
+        if (!isAlly && actor->checkRange(*target, actor->getWeapon().range)) {
+            BattleAction action;
+            action.type = ActionType::Attack;
+            action.target = slot;
+            out.push_back(action);
+        }
+
+        int spellCount = static_cast<int>(actor->getSpells().size());
+        for (int i = 0; i < spellCount; ++i) {
+            const Spell& spell = actor->getSpell(i);
+            bool wantsAlly = spell.category == SpellCategory::Buff;
+            if (isAlly != wantsAlly || actor->getMP() < spell.mpCost) continue;
+            if (!actor->checkRange(*target, spell.range)) continue;
+            BattleAction action;
+            action.type = ActionType::Spell;
+            action.target = slot;
+            action.index = i;
+            out.push_back(action);
+        }
+
+        const auto& inventory = actor->getInventory();
+        for (int i = 0; i < static_cast<int>(inventory.size()); ++i) {
+            const Item& item = actor->getItem(i);
+            bool wantsAlly = item.category != ItemCategory::Debuff;
+            if (isAlly != wantsAlly || inventory[i].quantity <= 0) continue;
+            if (!itemUseful(item, *target) || !actor->checkRange(*target, item.range)) continue;
+            BattleAction action;
+            action.type = ActionType::Item;
+            action.target = slot;
+            action.index = i;
+            out.push_back(action);
+        }
+    }
+
+    if (!actor->isGuarding()) {
+        BattleAction action;
+        action.type = ActionType::Guard;
+        out.push_back(action);
+    }
+
+    if (actor->getX() != -1) {
+        static const int stepX[] = { 0, 0, 1, -1 };
+        static const int stepY[] = { 1, -1, 0, 0 };
+        for (int i = 0; i < 4; ++i) {
+            int x = actor->getX() + stepX[i];
+            int y = actor->getY() + stepY[i];
+            if (x < 0 || x >= grid.getWidth() || y < 0 || y >= grid.getHeight()) continue;
+            if (grid.getCombatantAt(x, y) || grid.getEnterCost(x, y) < 0) continue;
+            BattleAction action;
+            action.type = ActionType::Move;
+            action.dx = stepX[i];
+            action.dy = stepY[i];
+            out.push_back(action);
+        }
+    }
+
+    if (out.size() == first) out.push_back(BattleAction());
+}
+
+bool applyAction(Combatant* actor, const BattleAction& action, BattleManager& battle, Grid& grid) {
+    const std::pmr::vector<Combatant*>& participants = battle.getParticipants();
+    switch (action.type) {
+    case ActionType::Attack:
+        if (!actor->attack(*participants[action.target], grid, battle.getRng())) return false;
+        actor->addTicks(COST_ATTACK);
+        return true;
+    case ActionType::Guard:
+        actor->guard();
+        actor->addTicks(COST_GUARD);
+        return true;
+    case ActionType::Move: {
+        int cost = grid.moveCombatant(actor, action.dx, action.dy);
+        if (cost == 0) return false;
+        actor->addTicks(cost);
+        return true;
+    }
+    case ActionType::Spell:
+        if (!actor->castSpell(*participants[action.target], action.index, grid)) return false;
+        actor->addTicks(COST_SPELL);
+        return true;
+    case ActionType::Item:
+        if (!actor->useItem(*participants[action.target], action.index)) return false;
+        actor->addTicks(COST_ITEM);
+        return true;
+    case ActionType::Wait:
+        actor->addTicks(COST_MOVE_BASE);
+        return true;
+    case ActionType::Panic: {
+        int cost = grid.moveCombatant(actor, action.dx, action.dy);
+        if (cost == 0) return false;
+        if (!actor->hasFled()) actor->regainMorale(2);
+        actor->addTicks(cost);
+        return true;
+    }
+    }
+    return false;
+}
+
+void playTurn(Combatant* actor, const BattleAction& action, BattleManager& battle, Grid& grid) {
+    if (!applyAction(actor, action, battle, grid)) actor->addTicks(COST_MOVE_BASE);
+}
@@ -0,0 +1,44 @@
+#ifndef BATTLE_ACTION_H
+#define BATTLE_ACTION_H
+
+#include <cstdint>
+#include <vector>
+#include "rpg_system.h"
+
+// ==========================================
+// BattleAction: one complete turn choice
+// ==========================================
+// Panic is the forced retreat of a broken unit (a step that also restores
+// morale); legalActions never offers it.
+enum class ActionType : uint8_t { Attack, Guard, Move, Spell, Item, Wait, Panic };
+
+struct BattleAction {
+    ActionType type = ActionType::Wait;
+    int target = -1;    // Participant slot (Attack, Spell, Item)
+    int index = 0;      // Spell or item index
+    int dx = 0;         // Step (Move, Panic)
+    int dy = 0;
+
+    bool operator==(const BattleAction& other) const {
+        return type == other.type && target == other.target && index == other.index &&
+            dx == other.dx && dy == other.dy;
+    }
+    bool operator!=(const BattleAction& other) const { return !(*this == other); }
+};
+
+// Appends every action `actor` can take right now that would succeed: attacks
+// and debuffs on living enemies in range, buffs and restoratives on allies
+// that can use them, guarding, and steps onto free, passable cells. Wait is
+// offered only when nothing else is possible.
+void legalActions(BattleManager& battle, Grid& grid, Combatant* actor, std::vector<BattleAction>& out);
+
+// Performs `action` for `actor` the way the console menu does, tick cost
+// included. Returns false (and spends nothing) if the action was refused.
+bool applyAction(Combatant* actor, const BattleAction& action, BattleManager& battle, Grid& grid);
+
+// Plays a whole turn: applies `action`, and if it is refused (a step into
+// an occupied or impassable cell) the unit loses COST_MOVE_BASE ticks, the
+// way the AI always has. Recorded turns are replayed through this.
+void playTurn(Combatant* actor, const BattleAction& action, BattleManager& battle, Grid& grid);
+
+#endif
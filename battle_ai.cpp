@@ -0,0 +1,108 @@
+#include "battle_ai.h"
+#include "pathfinding.h"
+#include <cmath>
+
+Combatant* getNearestEnemy(Combatant* actor, Grid& grid) {
+    static const int goodTeam = internTeam("Good Guys");
+    static const int badTeam = internTeam("Bad Guys");
+    int targetTeam = (actor->getTeamId() == goodTeam) ? badTeam : goodTeam;
+    return grid.nearestOfTeam(actor->getX(), actor->getY(), targetTeam);
+}
+
+// Steps toward the closest enemy by walking cost on the team's shared distance
+// field, preferring the straight-line step toward `target` when it is as good.
+// Falls back to that straight step when no free neighbour gets closer.
+static BattleAction stepTowardEnemies(Combatant* actor, Combatant* target, Grid& grid) {
+    int dx = target->getX() - actor->getX();
+    int dy = target->getY() - actor->getY();
+    BattleAction action;
+    action.type = ActionType::Move;
+    action.dx = (std::abs(dx) > std::abs(dy)) ? ((dx > 0) ? 1 : -1) : 0;
+    action.dy = (action.dx == 0) ? ((dy > 0) ? 1 : -1) : 0;
+
+    Pathfinder& paths = grid.getPathfinder();
+    int stepX, stepY;
+    if (paths.bestStep(paths.distanceToTeam(target->getTeamId()), actor->getX(), actor->getY(), action.dx, action.dy, stepX, stepY)) {
+        action.dx = stepX;
+        action.dy = stepY;
+    }
+    return action;
+}
+
+BattleAction chooseAIAction(Combatant* actor, Grid& grid) {
+    emitEvent(actor->getEventSink(), CombatEventType::AIThinking, actor);
+    Combatant* target = getNearestEnemy(actor, grid);
+
+    if (!target) {
+        emitEvent(actor->getEventSink(), CombatEventType::AIWaiting, actor);
+        return BattleAction();
+    }
+
+    BattleAction action;
+    action.target = target->getSlot();
+
+    // Priority 1: Cast Spell
+    for (size_t i = 0; i < actor->getSpells().size(); ++i) {
+        const Spell& spell = actor->getSpell(static_cast<int>(i));
+        if (actor->getMP() >= spell.mpCost) {
+            if (actor->checkRange(*target, spell.range)) {
+                action.type = ActionType::Spell;
+                action.index = static_cast<int>(i);
+                return action;
+            }
+            else {
+                emitEvent(actor->getEventSink(), CombatEventType::AIMoving, actor, target, 0, 0,
+                    static_cast<uint8_t>(EventSource::Spell));
+                return stepTowardEnemies(actor, target, grid);
+            }
+        }
+    }
+
+    // Priority 2: Attack
+    if (actor->checkRange(*target, actor->getWeapon().range)) {
+        action.type = ActionType::Attack;
+        return action;
+    }
+    emitEvent(actor->getEventSink(), CombatEventType::AIMoving, actor, target, 0, 0,
+        static_cast<uint8_t>(EventSource::Attack));
+    return stepTowardEnemies(actor, target, grid);
+}
+
+BattleAction choosePanicAction(Combatant* actor, Grid& grid) {
+    emitEvent(actor->getEventSink(), CombatEventType::Panicked, actor);
+    int x = actor->getX();
+    int y = actor->getY();
+    int w = grid.getWidth();
+    int h = grid.getHeight();
+
+    int distN = y, distS = h - 1 - y, distW = x, distE = w - 1 - x;
+    int dx = 0, dy = -1, minDist = distN;
+
+    if (distS < minDist) { minDist = distS; dx = 0; dy = 1; }
+    if (distW < minDist) { minDist = distW; dx = -1; dy = 0; }
+    if (distE < minDist) { minDist = distE; dx = 1; dy = 0; }
+
+    // Off the border, follow the exit field around walls and slow ground.
+    if (minDist > 0) {
+        Pathfinder& paths = grid.getPathfinder();
+        int stepX, stepY;
+        if (paths.bestStep(paths.distanceToExit(), x, y, dx, dy, stepX, stepY)) {
+            dx = stepX;
+            dy = stepY;
+        }
+    }
+
+    BattleAction action;
+    action.type = ActionType::Panic;
+    action.dx = dx;
+    action.dy = dy;
+    return action;
+}
+
+void runAITurn(Combatant* actor, BattleManager& battle, Grid& grid) {
+    playTurn(actor, chooseAIAction(actor, grid), battle, grid);
+}
+
+void handleBrokenUnit(Combatant* actor, BattleManager& battle, Grid& grid) {
+    playTurn(actor, choosePanicAction(actor, grid), battle, grid);
+}
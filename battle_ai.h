@@ -0,0 +1,19 @@
+#ifndef BATTLE_AI_H
+#define BATTLE_AI_H
+
+#include "rpg_system.h"
+#include "battle_action.h"
+
+// ==========================================
+// Greedy AI Policy
+// ==========================================
+Combatant* getNearestEnemy(Combatant* actor, Grid& grid);
+
+// The choosers emit the AI narration and return the turn to play; the run/
+// handle wrappers play it straight away.
+BattleAction chooseAIAction(Combatant* actor, Grid& grid);
+BattleAction choosePanicAction(Combatant* actor, Grid& grid);
+void runAITurn(Combatant* actor, BattleManager& battle, Grid& grid);
+void handleBrokenUnit(Combatant* actor, BattleManager& battle, Grid& grid);
+
+#endif
@@ -0,0 +1,337 @@
+#include "battle_analytics.h"
+#include "scenario.h"
+#include "content_catalog.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+// ==========================================
+// Online Aggregates
+// ==========================================
+void RunningStats::add(double x) {
+    if (count == 0) min = max = x;
+    min = std::min(min, x);
+    max = std::max(max, x);
+    count++;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    // Chan et al.'s pairwise combination of two Welford states.
+    double n = static_cast<double>(count + other.count);
+    double delta = other.mean - mean;
+    mean += delta * other.count / n;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / n);
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+double RunningStats::stddev() const { return std::sqrt(variance()); }
+
+Histogram::Histogram(double low, double width) : low(low), width(width > 0.0 ? width : 1.0) {}
+
+void Histogram::add(double x) {
+    if (x < low) {
+        underflow++;
+        return;
+    }
+    double bucket = (x - low) / width;
+    if (bucket >= BUCKETS) overflow++;
+    else counts[static_cast<int>(bucket)]++;
+}
+
+void Histogram::merge(const Histogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) counts[i] += other.counts[i];
+    underflow += other.underflow;
+    overflow += other.overflow;
+}
+
+namespace {
+
+// Bucket k holds (GAMMA^(k-1), GAMMA^k]; reporting the bucket's midpoint in
+// relative terms keeps every answer within ALPHA of a true sample.
+const double SKETCH_ALPHA = 0.02;
+const double SKETCH_GAMMA = (1.0 + SKETCH_ALPHA) / (1.0 - SKETCH_ALPHA);
+const double SKETCH_LOG_GAMMA = std::log(SKETCH_GAMMA);
+
+} // namespace
+
+void QuantileSketch::add(double x) {
+    total++;
+    if (x < 1.0) {
+        belowOne++;
+        return;
+    }
+    int bucket = static_cast<int>(std::ceil(std::log(x) / SKETCH_LOG_GAMMA));
+    counts[std::min(bucket, BUCKETS - 1)]++;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    for (int i = 0; i < BUCKETS; ++i) counts[i] += other.counts[i];
+    belowOne += other.belowOne;
+    total += other.total;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) return 0.0;
+    q = std::min(std::max(q, 0.0), 1.0);
+    long long rank = static_cast<long long>(q * (total - 1));
+    if (rank < belowOne) return 0.0;
+    long long seen = belowOne;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen > rank) return 2.0 * std::pow(SKETCH_GAMMA, i) / (SKETCH_GAMMA + 1.0);
+    }
+    return 2.0 * std::pow(SKETCH_GAMMA, BUCKETS - 1) / (SKETCH_GAMMA + 1.0);
+}
+
+// ==========================================
+// Balance Analytics
+// ==========================================
+void SourceStats::merge(const SourceStats& other) {
+    uses += other.uses;
+    strikes += other.strikes;
+    hits += other.hits;
+    crits += other.crits;
+    kills += other.kills;
+    damage += other.damage;
+    hitDamage.merge(other.hitDamage);
+    timeToKill.merge(other.timeToKill);
+    timeToKillSketch.merge(other.timeToKillSketch);
+}
+
+void CompositionOutcomes::merge(const CompositionOutcomes& other) {
+    battles += other.battles;
+    goodWins += other.goodWins;
+    badWins += other.badWins;
+    draws += other.draws;
+    stalemates += other.stalemates;
+}
+
+BattleAnalytics::BattleAnalytics() : turnHistogram(0.0, 5.0) {}
+
+SourceStats& BattleAnalytics::statsOf(const SourceRef& source) {
+    std::vector<SourceStats>& table = source.isSpell ? spells : weapons;
+    if (source.id >= table.size()) table.resize(source.id + 1);
+    return table[source.id];
+}
+
+const SourceStats* BattleAnalytics::weaponStats(WeaponId id) const {
+    return id < weapons.size() ? &weapons[id] : nullptr;
+}
+
+const SourceStats* BattleAnalytics::spellStats(SpellId id) const {
+    return id < spells.size() ? &spells[id] : nullptr;
+}
+
+void BattleAnalytics::beginBattle(const Battle& battle) {
+    const std::pmr::vector<Combatant*>& participants = battle.manager.getParticipants();
+    int count = static_cast<int>(participants.size());
+    firstHitClock.assign(count, -1);
+    lastHitBy.assign(count, SourceRef());
+    current = SourceRef();
+    currentTarget = nullptr;
+    clock = 0;
+
+    // "Team [n Weapon, ...] vs Team [...]", teams by id and weapons by id,
+    // built in a reused buffer so known compositions cost no allocation.
+    roster.clear();
+    for (const Combatant* c : participants) roster.emplace_back(c->getTeamId(), c->getWeaponId());
+    std::sort(roster.begin(), roster.end());
+    composition.clear();
+    for (size_t i = 0; i < roster.size();) {
+        if (i > 0) composition += "] vs ";
+        int team = roster[i].first;
+        for (const Combatant* c : participants) {
+            if (c->getTeamId() == team) {
+                composition += c->getTeam();
+                break;
+            }
+        }
+        composition += " [";
+        bool firstWeapon = true;
+        while (i < roster.size() && roster[i].first == team) {
+            size_t run = i;
+            while (run < roster.size() && roster[run] == roster[i]) run++;
+            if (!firstWeapon) composition += ", ";
+            composition += std::to_string(run - i);
+            composition += ' ';
+            composition += contentCatalog().weapon(static_cast<WeaponId>(roster[i].second)).name;
+            firstWeapon = false;
+            i = run;
+        }
+    }
+    if (!roster.empty()) composition += "]";
+}
+
+void BattleAnalytics::endBattle(const std::string& winner, int turns) {
+    auto found = compositions.find(composition);
+    if (found == compositions.end()) found = compositions.emplace(composition, CompositionOutcomes()).first;
+    CompositionOutcomes& outcomes = found->second;
+    outcomes.battles++;
+    if (winner == "Good Guys") outcomes.goodWins++;
+    else if (winner == "Bad Guys") outcomes.badWins++;
+    else if (winner == "Draw") outcomes.draws++;
+    else outcomes.stalemates++;
+
+    battleTurns.add(turns);
+    turnHistogram.add(turns);
+    turnSketch.add(turns);
+    battleTicks.add(clock);
+    tickSketch.add(clock);
+}
+
+void BattleAnalytics::onEvent(const CombatEvent& e) {
+    switch (e.type) {
+    case CombatEventType::AttackDeclared:
+        clock = std::max(clock, e.actor->getInitiative());
+        current = SourceRef{ false, e.actor->getWeaponId(), true };
+        currentTarget = e.target;
+        statsOf(current).uses++;
+        break;
+    case CombatEventType::SpellCast:
+        clock = std::max(clock, e.actor->getInitiative());
+        current = SourceRef{ true, e.actor->getSpells()[e.value], true };
+        currentTarget = nullptr;
+        statsOf(current).uses++;
+        break;
+    case CombatEventType::AttackMissed:
+        if (current.valid) statsOf(current).strikes++;
+        break;
+    case CombatEventType::CriticalHit:
+        if (current.valid) statsOf(current).crits++;
+        break;
+    case CombatEventType::SpellHit:
+        if (current.valid) statsOf(current).strikes++;
+        currentTarget = e.target;
+        break;
+    case CombatEventType::DamageTaken: {
+        int slot = e.actor->getSlot();
+        if (slot < 0 || slot >= static_cast<int>(lastHitBy.size())) break;
+        bool direct = current.valid && e.actor == currentTarget &&
+            static_cast<Element>(e.detail) != Element::Reflect;
+        if (!direct) {
+            lastHitBy[slot] = SourceRef();
+            break;
+        }
+        SourceStats& stats = statsOf(current);
+        if (!current.isSpell) stats.strikes++;
+        stats.hits++;
+        stats.damage += e.value;
+        stats.hitDamage.add(e.value);
+        if (firstHitClock[slot] < 0) firstHitClock[slot] = clock;
+        lastHitBy[slot] = current;
+        // A target is hit once per swing or cast; later damage is a side effect.
+        if (current.isSpell) currentTarget = nullptr;
+        break;
+    }
+    case CombatEventType::Defeated: {
+        int slot = e.actor->getSlot();
+        if (slot < 0 || slot >= static_cast<int>(lastHitBy.size()) || !lastHitBy[slot].valid) break;
+        SourceStats& stats = statsOf(lastHitBy[slot]);
+        stats.kills++;
+        stats.timeToKill.add(clock - firstHitClock[slot]);
+        stats.timeToKillSketch.add(clock - firstHitClock[slot]);
+        lastHitBy[slot] = SourceRef();
+        break;
+    }
+    case CombatEventType::ItemUsed:
+    case CombatEventType::Guarded:
+    case CombatEventType::Moved:
+    case CombatEventType::Fled:
+        current = SourceRef();
+        currentTarget = nullptr;
+        break;
+    default:
+        break;
+    }
+}
+
+void BattleAnalytics::merge(const BattleAnalytics& other) {
+    if (weapons.size() < other.weapons.size()) weapons.resize(other.weapons.size());
+    for (size_t i = 0; i < other.weapons.size(); ++i) weapons[i].merge(other.weapons[i]);
+    if (spells.size() < other.spells.size()) spells.resize(other.spells.size());
+    for (size_t i = 0; i < other.spells.size(); ++i) spells[i].merge(other.spells[i]);
+    for (const auto& entry : other.compositions) compositions[entry.first].merge(entry.second);
+    battleTurns.merge(other.battleTurns);
+    battleTicks.merge(other.battleTicks);
+    turnHistogram.merge(other.turnHistogram);
+    turnSketch.merge(other.turnSketch);
+    tickSketch.merge(other.tickSketch);
+}
+
+void BattleAnalytics::print(std::ostream& out) const {
+    auto pct = [](long long n, long long of) { return of > 0 ? (100.0 * n) / of : 0.0; };
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << "=== BALANCE ANALYTICS (" << battleCount() << " battles) ===\n";
+    auto printSources = [&](const char* heading, const std::vector<SourceStats>& table, bool isSpell) {
+        out << heading << "\n";
+        out << "  " << std::left << std::setw(16) << "Name" << std::right << std::setw(9) << "Uses"
+            << std::setw(8) << "Hit%" << std::setw(8) << "Crit%" << std::setw(10) << "Dmg/hit"
+            << std::setw(8) << "(sd)" << std::setw(10) << "Dmg/tick" << std::setw(8) << "Kills"
+            << std::setw(10) << "TTK mean" << std::setw(8) << "p50" << std::setw(8) << "p90" << "\n";
+        int cost = isSpell ? COST_SPELL : COST_ATTACK;
+        for (size_t id = 0; id < table.size(); ++id) {
+            const SourceStats& s = table[id];
+            if (s.uses == 0) continue;
+            const std::string& name = isSpell ? contentCatalog().spell(static_cast<SpellId>(id)).name
+                : contentCatalog().weapon(static_cast<WeaponId>(id)).name;
+            out << "  " << std::left << std::setw(16) << name.substr(0, 15) << std::right
+                << std::setw(9) << s.uses
+                << std::setw(8) << pct(s.hits, s.strikes)
+                << std::setw(8) << pct(s.crits, s.hits)
+                << std::setw(10) << s.hitDamage.mean
+                << std::setw(8) << s.hitDamage.stddev()
+                << std::setw(10) << static_cast<double>(s.damage) / (static_cast<double>(s.uses) * cost)
+                << std::setw(8) << s.kills
+                << std::setw(10) << s.timeToKill.mean
+                << std::setw(8) << s.timeToKillSketch.quantile(0.5)
+                << std::setw(8) << s.timeToKillSketch.quantile(0.9) << "\n";
+        }
+    };
+    printSources("Weapons:", weapons, false);
+    printSources("Spells:", spells, true);
+
+    out << "Compositions:\n";
+    for (const auto& entry : compositions) {
+        const CompositionOutcomes& o = entry.second;
+        out << "  " << entry.first << "\n"
+            << "    " << o.battles << " battles: Good " << pct(o.goodWins, o.battles) << "%, Bad "
+            << pct(o.badWins, o.battles) << "%, Draw " << pct(o.draws, o.battles) << "%, Stalemate "
+            << pct(o.stalemates, o.battles) << "%\n";
+    }
+
+    out << "Battle length:\n"
+        << "  Turns: mean " << battleTurns.mean << " (sd " << battleTurns.stddev() << "), p10 "
+        << turnSketch.quantile(0.1) << ", p50 " << turnSketch.quantile(0.5) << ", p90 "
+        << turnSketch.quantile(0.9) << ", p99 " << turnSketch.quantile(0.99) << ", max " << battleTurns.max << "\n"
+        << "  Ticks: mean " << battleTicks.mean << " (sd " << battleTicks.stddev() << "), p50 "
+        << tickSketch.quantile(0.5) << ", p90 " << tickSketch.quantile(0.9) << "\n";
+    out << std::setprecision(0);
+    for (int b = 0; b < Histogram::BUCKETS; ++b) {
+        if (turnHistogram.count(b) == 0) continue;
+        out << "  " << std::setw(4) << turnHistogram.bucketLow(b) << "-" << std::left << std::setw(4)
+            << turnHistogram.bucketLow(b) + turnHistogram.bucketWidth() - 1 << std::right << " "
+            << std::setw(9) << turnHistogram.count(b) << " (" << std::setprecision(1)
+            << pct(turnHistogram.count(b), battleTurns.count) << "%)\n" << std::setprecision(0);
+    }
+    if (turnHistogram.overflowCount() > 0) {
+        out << "  " << std::setw(4) << turnHistogram.bucketLow(Histogram::BUCKETS) << "+    "
+            << std::setw(9) << turnHistogram.overflowCount() << "\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
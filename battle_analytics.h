@@ -0,0 +1,158 @@
+#ifndef BATTLE_ANALYTICS_H
+#define BATTLE_ANALYTICS_H
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+#include "combat_events.h"
+#include "rpg_system.h"
+
+struct Battle;
+
+// ==========================================
+// Online Aggregates
+// ==========================================
+// Each aggregate takes samples one at a time in constant memory and merges
+// with another of the same kind, so per-thread copies can be combined once
+// at the end of a run.
+
+// Count, mean and variance by Welford's method, plus the extremes.
+struct RunningStats {
+    long long count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+
+    void add(double x);
+    void merge(const RunningStats& other);
+    double variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+    double stddev() const;
+};
+
+// BUCKETS equal-width buckets from `low`; samples outside land in the
+// underflow and overflow counts.
+class Histogram {
+public:
+    static const int BUCKETS = 32;
+
+    explicit Histogram(double low = 0.0, double width = 1.0);
+    void add(double x);
+    void merge(const Histogram& other);
+
+    double bucketLow(int bucket) const { return low + bucket * width; }
+    double bucketWidth() const { return width; }
+    long long count(int bucket) const { return counts[bucket]; }
+    long long underflowCount() const { return underflow; }
+    long long overflowCount() const { return overflow; }
+
+private:
+    double low;
+    double width;
+    std::array<long long, BUCKETS> counts{};
+    long long underflow = 0;
+    long long overflow = 0;
+};
+
+// Quantiles of non-negative samples to within 2% relative error. Samples
+// are counted in logarithmic buckets (as in DDSketch), so merging is adding
+// counts; values below 1 share one bucket.
+class QuantileSketch {
+public:
+    void add(double x);
+    void merge(const QuantileSketch& other);
+    long long count() const { return total; }
+    // Value at rank q in [0, 1]; 0 when empty.
+    double quantile(double q) const;
+
+private:
+    static const int BUCKETS = 512;
+    std::array<long long, BUCKETS> counts{};
+    long long belowOne = 0;
+    long long total = 0;
+};
+
+// ==========================================
+// Balance Analytics
+// ==========================================
+// What one weapon or spell did across every battle observed. A "use" is an
+// attack or cast; a "strike" is one swing or one AoE victim. Damage counts
+// direct hits only: burn and acid ticks, and poison reflection, are not
+// credited to the source that caused them.
+struct SourceStats {
+    long long uses = 0;
+    long long strikes = 0;
+    long long hits = 0;
+    long long crits = 0;
+    long long kills = 0;
+    long long damage = 0;
+    RunningStats hitDamage;
+    RunningStats timeToKill;        // Ticks from a victim's first direct hit to its defeat
+    QuantileSketch timeToKillSketch;
+
+    void merge(const SourceStats& other);
+};
+
+struct CompositionOutcomes {
+    long long battles = 0;
+    long long goodWins = 0;
+    long long badWins = 0;
+    long long draws = 0;
+    long long stalemates = 0;
+
+    void merge(const CompositionOutcomes& other);
+};
+
+// A CombatEventSink that folds a stream of battles into per-weapon and
+// per-spell statistics, win rates per team composition and the battle
+// length distribution. Attach it to a battle between beginBattle and
+// endBattle. Memory grows with the number of distinct weapons, spells and
+// compositions seen, never with the number of battles or events.
+class BattleAnalytics : public CombatEventSink {
+public:
+    BattleAnalytics();
+
+    void beginBattle(const Battle& battle);
+    void endBattle(const std::string& winner, int turns);
+    void onEvent(const CombatEvent& event) override;
+
+    void merge(const BattleAnalytics& other);
+    void print(std::ostream& out) const;
+
+    long long battleCount() const { return battleTurns.count; }
+    const SourceStats* weaponStats(WeaponId id) const;
+    const SourceStats* spellStats(SpellId id) const;
+
+private:
+    // Direct damage is credited to whatever started the current action.
+    struct SourceRef {
+        bool isSpell = false;
+        uint16_t id = 0;
+        bool valid = false;
+    };
+
+    std::vector<SourceStats> weapons;   // By WeaponId
+    std::vector<SourceStats> spells;    // By SpellId
+    std::map<std::string, CompositionOutcomes> compositions;
+    RunningStats battleTurns;
+    RunningStats battleTicks;
+    Histogram turnHistogram;
+    QuantileSketch turnSketch;
+    QuantileSketch tickSketch;
+
+    // Current battle, reused from one battle to the next.
+    std::string composition;
+    std::vector<std::pair<int, int>> roster;    // (team id, weapon id) per unit
+    std::vector<int> firstHitClock;             // By participant slot; -1 before any hit
+    std::vector<SourceRef> lastHitBy;           // By participant slot
+    SourceRef current;
+    const Combatant* currentTarget = nullptr;   // Attack target or latest AoE victim
+    int clock = 0;
+
+    SourceStats& statsOf(const SourceRef& source);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "battle_arena.h"
+#include <cstdint>
+
+BattleArena::BattleArena(size_t initialBytes) {
+    addBlock(initialBytes > 0 ? initialBytes : 1);
+    firstBlockBytes = blocks->bytes;
+}
+
+BattleArena::~BattleArena() {
+    runCleanups();
+    releaseBlocks();
+}
+
+void BattleArena::addBlock(size_t minBytes) {
+    size_t bytes = blocks ? blocks->bytes * 2 : minBytes;
+    if (bytes < minBytes) bytes = minBytes;
+    Block* block = static_cast<Block*>(::operator new(sizeof(Block) + bytes));
+    block->next = blocks;
+    block->bytes = bytes;
+    if (blocks) spills++;
+    blocks = block;
+    cursor = reinterpret_cast<char*>(block + 1);
+    limit = cursor + bytes;
+}
+
+void BattleArena::releaseBlocks() {
+    while (blocks) {
+        Block* next = blocks->next;
+        ::operator delete(blocks);
+        blocks = next;
+    }
+}
+
+void* BattleArena::do_allocate(size_t bytes, size_t alignment) {
+    uintptr_t at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    if (at + bytes > reinterpret_cast<uintptr_t>(limit)) {
+        addBlock(bytes + alignment);
+        at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+    used += bytes + (at - reinterpret_cast<uintptr_t>(cursor));
+    cursor = reinterpret_cast<char*>(at + bytes);
+    return reinterpret_cast<void*>(at);
+}
+
+void BattleArena::runCleanups() {
+    while (cleanups) {
+        Cleanup* node = cleanups;
+        cleanups = node->next;
+        node->destroy(node->object);
+    }
+}
+
+void BattleArena::reset() {
+    runCleanups();
+    if (used > peak) peak = used;
+
+    if (blocks->next) {
+        // Spilled: trade every block for one that holds the whole battle.
+        size_t bytes = firstBlockBytes;
+        while (bytes < used) bytes *= 2;
+        releaseBlocks();
+        addBlock(bytes);
+        firstBlockBytes = bytes;
+    }
+    else {
+        cursor = reinterpret_cast<char*>(blocks + 1);
+        limit = cursor + blocks->bytes;
+    }
+    used = 0;
+}
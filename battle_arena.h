@@ -0,0 +1,93 @@
+#ifndef BATTLE_ARENA_H
+#define BATTLE_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// ==========================================
+// Battle Arena
+// ==========================================
+// Monotonic memory for one battle at a time. Everything the battle builds --
+// its units, their names and inventories, the store rows, grid boards and
+// path fields -- is bump-allocated from here, deallocation is free, and
+// reset() drops the lot at once. The arena keeps its memory across resets:
+// if a battle spilled past the first block, reset() replaces the blocks
+// with one block large enough for it, so a loop of similar battles settles
+// into making no global heap allocations at all.
+class BattleArena : public std::pmr::memory_resource {
+public:
+    explicit BattleArena(size_t initialBytes = 64 * 1024);
+    ~BattleArena() override;
+    BattleArena(const BattleArena&) = delete;
+    BattleArena& operator=(const BattleArena&) = delete;
+
+    // Constructs a T in the arena. reset() destroys it, newest first.
+    template <typename T, typename... Args>
+    T* create(Args&&... args);
+
+    void reset();
+
+    size_t capacity() const { return firstBlockBytes; }
+    // Most bytes any battle has drawn between two resets (alignment included).
+    size_t peakBytes() const { return peak; }
+    // Blocks taken from the global heap after the first, over the arena's life.
+    long long spillCount() const { return spills; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t bytes;
+    };
+    struct Cleanup {
+        void (*destroy)(void*);
+        void* object;
+        Cleanup* next;
+    };
+
+    Block* blocks = nullptr;        // Newest first; the last one is the first block
+    size_t firstBlockBytes = 0;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t used = 0;
+    size_t peak = 0;
+    long long spills = 0;
+    Cleanup* cleanups = nullptr;
+
+    void addBlock(size_t minBytes);
+    void releaseBlocks();
+    void runCleanups();
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+template <typename T, typename... Args>
+T* BattleArena::create(Args&&... args) {
+    T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        Cleanup* node = static_cast<Cleanup*>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+        node->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+        node->object = object;
+        node->next = cleanups;
+        cleanups = node;
+    }
+    return object;
+}
+
+// polymorphic_allocator::new_object and delete_object taking the resource
+// directly; deleteObject also accepts null, as delete does.
+template <typename T, typename... Args>
+T* newObject(std::pmr::memory_resource* memory, Args&&... args) {
+    return std::pmr::polymorphic_allocator<>(memory).new_object<T>(std::forward<Args>(args)...);
+}
+
+template <typename T>
+void deleteObject(std::pmr::memory_resource* memory, T* object) {
+    if (object) std::pmr::polymorphic_allocator<>(memory).delete_object(object);
+}
+
+#endif
@@ -0,0 +1,473 @@
+#include "battle_file.h"
+#include "content_catalog.h"
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint64_t alignUp(uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); }
+
+// Accumulates the string pool while records are filled in.
+class StringPool {
+private:
+    std::vector<char> bytes;
+
+public:
+    FileStringRef add(std::string_view s) {
+        FileStringRef ref{ static_cast<uint32_t>(bytes.size()), static_cast<uint32_t>(s.size()) };
+        bytes.insert(bytes.end(), s.begin(), s.end());
+        return ref;
+    }
+    const std::vector<char>& getBytes() const { return bytes; }
+};
+
+template <typename T>
+void appendSection(std::vector<uint8_t>& out, uint64_t& offset, const std::vector<T>& records) {
+    out.resize(alignUp(out.size()), 0);
+    offset = out.size();
+    if (records.empty()) return;
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(records.data());
+    out.insert(out.end(), raw, raw + records.size() * sizeof(T));
+}
+
+} // namespace
+
+// ==========================================
+// Encoding
+// ==========================================
+void encodeBattleFile(const Battle& battle, std::vector<uint8_t>& out) {
+    BattleState state;
+    battle.saveState(state);
+    const Grid& grid = battle.grid;
+    const CombatantStore& rows = state.units;
+    StringPool strings;
+
+    BattleFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = BATTLE_FILE_MAGIC;
+    header.version = BATTLE_FILE_VERSION;
+    header.byteOrder = BATTLE_FILE_BYTE_ORDER;
+    header.headerSize = sizeof(BattleFileHeader);
+    header.width = grid.getWidth();
+    header.height = grid.getHeight();
+    header.rngSeed = state.rng.getSeed();
+    header.rngStream = state.rng.getStream();
+    header.rngPosition = state.rng.tell();
+
+    std::vector<uint8_t> terrain(static_cast<size_t>(header.width) * header.height);
+    for (int y = 0; y < header.height; ++y) {
+        for (int x = 0; x < header.width; ++x) terrain[y * header.width + x] = static_cast<uint8_t>(grid.getTerrain(x, y));
+    }
+
+    std::vector<FileUnit> units(battle.units.size());
+    std::vector<FileSpell> spells;
+    std::vector<FileItem> items;
+    std::vector<FileStatus> fileStatuses;
+    for (size_t slot = 0; slot < battle.units.size(); ++slot) {
+        const Combatant& c = *battle.units[slot];
+        FileUnit& u = units[slot];
+        std::memset(&u, 0, sizeof(u));
+        u.name = strings.add(c.getName());
+        u.team = strings.add(c.getTeam());
+        u.health = rows.currentHealth[slot];
+        u.maxHealth = rows.maxHealth[slot];
+        u.magicPoints = rows.currentMagicPoints[slot];
+        u.maxMagicPoints = rows.maxMagicPoints[slot];
+        u.initiative = rows.initiative[slot];
+        u.morale = rows.morale[slot];
+        u.x = rows.xPos[slot];
+        u.y = rows.yPos[slot];
+        u.schedulePos = state.schedulePos[slot];
+        u.flags = rows.flags[slot];
+
+        const Weapon& w = c.getWeapon();
+        u.weapon.name = strings.add(w.name);
+        u.weapon.physicalAttack = w.physicalAttack;
+        u.weapon.accuracy = w.accuracy;
+        u.weapon.range = w.range;
+        u.weapon.numberOfAttacks = w.numberOfAttacks;
+        u.weapon.element = static_cast<uint8_t>(w.element);
+
+        const Armor& a = c.getArmor();
+        u.armor.name = strings.add(a.name);
+        u.armor.damageResistance = a.damageResistance;
+        u.armor.damageThreshold = a.damageThreshold;
+        u.armor.evasion = a.evasion;
+        u.armor.magicalDefense = a.magicalDefense;
+        u.armor.element = static_cast<uint8_t>(a.element);
+
+        const StatusList& statuses = rows.statuses[slot];
+        u.firstStatus = static_cast<uint32_t>(fileStatuses.size());
+        u.statusCount = static_cast<uint32_t>(statuses.count);
+        for (int i = 0; i < statuses.count; ++i) {
+            FileStatus f;
+            std::memset(&f, 0, sizeof(f));
+            f.durationTicks = statuses[i].durationTicks;
+            f.potency = statuses[i].potency;
+            f.stacks = statuses[i].stacks;
+            f.type = static_cast<uint8_t>(statuses[i].type);
+            fileStatuses.push_back(f);
+        }
+
+        u.firstSpell = static_cast<uint32_t>(spells.size());
+        u.spellCount = static_cast<uint32_t>(c.getSpells().size());
+        for (SpellId id : c.getSpells()) {
+            const Spell& s = contentCatalog().spell(id);
+            FileSpell f;
+            std::memset(&f, 0, sizeof(f));
+            f.name = strings.add(s.name);
+            f.magicalAttack = s.magicalAttack;
+            f.mpCost = s.mpCost;
+            f.range = s.range;
+            f.duration = s.duration;
+            f.aoe = s.aoe;
+            f.element = static_cast<uint8_t>(s.element);
+            f.category = static_cast<uint8_t>(s.category);
+            spells.push_back(f);
+        }
+
+        u.firstItem = static_cast<uint32_t>(items.size());
+        u.itemCount = static_cast<uint32_t>(c.getInventory().size());
+        for (const InventoryEntry& stack : c.getInventory()) {
+            const Item& item = contentCatalog().item(stack.item);
+            FileItem f;
+            std::memset(&f, 0, sizeof(f));
+            f.name = strings.add(item.name);
+            f.quantity = stack.quantity;
+            f.range = item.range;
+            f.potency = item.potency;
+            f.category = static_cast<uint8_t>(item.category);
+            items.push_back(f);
+        }
+    }
+
+    std::vector<uint32_t> occupants(state.occupants.begin(), state.occupants.end());
+    header.unitCount = static_cast<uint32_t>(units.size());
+    header.spellCount = static_cast<uint32_t>(spells.size());
+    header.itemCount = static_cast<uint32_t>(items.size());
+    header.statusCount = static_cast<uint32_t>(fileStatuses.size());
+    header.occupantCount = static_cast<uint32_t>(occupants.size());
+
+    out.assign(sizeof(BattleFileHeader), 0);
+    appendSection(out, header.terrainOffset, terrain);
+    appendSection(out, header.unitsOffset, units);
+    appendSection(out, header.spellsOffset, spells);
+    appendSection(out, header.itemsOffset, items);
+    appendSection(out, header.statusesOffset, fileStatuses);
+    appendSection(out, header.occupantsOffset, occupants);
+    appendSection(out, header.stringsOffset, strings.getBytes());
+    header.stringBytes = strings.getBytes().size();
+    header.fileSize = out.size();
+    std::memcpy(out.data(), &header, sizeof(header));
+}
+
+bool saveBattleFile(const std::string& path, const Battle& battle) {
+    std::vector<uint8_t> bytes;
+    encodeBattleFile(battle, bytes);
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+// ==========================================
+// View
+// ==========================================
+bool BattleFileView::open(const uint8_t* bytes, size_t length) {
+    data = bytes;
+    size = length;
+    if (!bytes || length < sizeof(BattleFileHeader) || reinterpret_cast<uintptr_t>(bytes) % 8 != 0 || !validate()) {
+        data = nullptr;
+        size = 0;
+        return false;
+    }
+    return true;
+}
+
+bool validSchedule(const std::vector<ScheduleSlot>& slots) {
+    int scheduled = 0;
+    for (const ScheduleSlot& s : slots) {
+        if ((s.pos != -1) != s.alive) return false;
+        if (s.alive) scheduled++;
+    }
+    std::vector<int> heapSlot(scheduled, -1);
+    for (int slot = 0; slot < static_cast<int>(slots.size()); ++slot) {
+        int pos = slots[slot].pos;
+        if (pos == -1) continue;
+        if (pos < 0 || pos >= scheduled || heapSlot[pos] != -1) return false;
+        heapSlot[pos] = slot;
+    }
+    for (int index = 1; index < scheduled; ++index) {
+        int child = heapSlot[index];
+        int parent = heapSlot[(index - 1) / 2];
+        int childInit = slots[child].initiative;
+        int parentInit = slots[parent].initiative;
+        if (childInit < parentInit || (childInit == parentInit && child < parent)) return false;
+    }
+    return true;
+}
+
+bool validStatuses(const std::vector<StatusEffect>& statuses) {
+    long long potencyTotal[StatusList::TYPE_COUNT] = {};
+    for (const StatusEffect& e : statuses) {
+        int type = static_cast<int>(e.type);
+        if (type >= StatusList::TYPE_COUNT || e.durationTicks < 1 || e.potency < 0) return false;
+        if (e.stacks < 1 || e.stacks > StatusList::MAX_STACKS) return false;
+        potencyTotal[type] += e.potency;
+        if (potencyTotal[type] > std::numeric_limits<int>::max()) return false;
+    }
+    return true;
+}
+
+bool BattleFileView::validate() const {
+    const BattleFileHeader& h = header();
+    if (h.magic != BATTLE_FILE_MAGIC || h.version != BATTLE_FILE_VERSION || h.byteOrder != BATTLE_FILE_BYTE_ORDER ||
+        h.headerSize != sizeof(BattleFileHeader) || h.fileSize != size) {
+        return false;
+    }
+    if (h.width <= 0 || h.height <= 0 || h.width > 4096 || h.height > 4096) return false;
+    const uint64_t cells = static_cast<uint64_t>(h.width) * h.height;
+
+    auto inside = [this](uint64_t offset, uint64_t count, uint64_t recordSize) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / recordSize;
+    };
+    if (!inside(h.terrainOffset, cells, 1) || !inside(h.unitsOffset, h.unitCount, sizeof(FileUnit)) ||
+        !inside(h.spellsOffset, h.spellCount, sizeof(FileSpell)) || !inside(h.itemsOffset, h.itemCount, sizeof(FileItem)) ||
+        !inside(h.statusesOffset, h.statusCount, sizeof(FileStatus)) ||
+        !inside(h.occupantsOffset, h.occupantCount, sizeof(uint32_t)) || !inside(h.stringsOffset, h.stringBytes, 1)) {
+        return false;
+    }
+    auto validString = [&h](FileStringRef ref) {
+        return ref.offset <= h.stringBytes && ref.length <= h.stringBytes - ref.offset;
+    };
+
+    for (uint64_t i = 0; i < cells; ++i) {
+        if (terrain()[i] >= static_cast<uint8_t>(Terrain::Count)) return false;
+    }
+    for (uint32_t i = 0; i < h.spellCount; ++i) {
+        const FileSpell& s = spells()[i];
+        if (!validString(s.name) || s.element >= ELEMENT_COUNT || s.category >= static_cast<int>(SpellCategory::Count)) return false;
+        // Area stencils are built per radius, so keep the radius on the map.
+        if (s.aoe < 0 || s.aoe > h.width + h.height) return false;
+    }
+    for (uint32_t i = 0; i < h.itemCount; ++i) {
+        const FileItem& item = items()[i];
+        if (!validString(item.name) || item.category >= static_cast<int>(ItemCategory::Count)) return false;
+    }
+    for (uint32_t i = 0; i < h.statusCount; ++i) {
+        if (statuses()[i].type >= StatusList::TYPE_COUNT) return false;
+    }
+
+    std::vector<ScheduleSlot> schedule;
+    schedule.reserve(h.unitCount);
+    std::vector<StatusEffect> unitStatuses;
+    for (uint32_t slot = 0; slot < h.unitCount; ++slot) {
+        const FileUnit& u = units()[slot];
+        if (!validString(u.name) || !validString(u.team) || !validString(u.weapon.name) || !validString(u.armor.name)) return false;
+        if (u.weapon.element >= ELEMENT_COUNT || u.armor.element >= ELEMENT_COUNT) return false;
+        if (u.firstSpell > h.spellCount || u.spellCount > h.spellCount - u.firstSpell) return false;
+        if (u.firstItem > h.itemCount || u.itemCount > h.itemCount - u.firstItem) return false;
+        if (u.firstStatus > h.statusCount || u.statusCount > h.statusCount - u.firstStatus) return false;
+        unitStatuses.clear();
+        for (uint32_t i = 0; i < u.statusCount; ++i) {
+            const FileStatus& f = statuses()[u.firstStatus + i];
+            unitStatuses.push_back(StatusEffect{ static_cast<StatusType>(f.type), f.durationTicks, f.potency, f.stacks });
+        }
+        if (!validStatuses(unitStatuses)) return false;
+        bool alive = u.health > 0 && !(u.flags & CombatantStore::FLAG_FLED);
+        schedule.push_back(ScheduleSlot{ u.schedulePos, u.initiative, alive });
+    }
+    if (!validSchedule(schedule)) return false;
+
+    std::vector<bool> cellTaken(static_cast<size_t>(cells), false);
+    for (uint32_t i = 0; i < h.occupantCount; ++i) {
+        uint32_t slot = occupants()[i];
+        if (slot >= h.unitCount) return false;
+        const FileUnit& u = units()[slot];
+        if (u.x < 0 || u.x >= h.width || u.y < 0 || u.y >= h.height) return false;
+        size_t cell = static_cast<size_t>(u.y) * h.width + u.x;
+        if (cellTaken[cell]) return false;
+        cellTaken[cell] = true;
+    }
+    return true;
+}
+
+std::string BattleFileView::getString(FileStringRef ref) const {
+    const char* pool = reinterpret_cast<const char*>(data + header().stringsOffset);
+    return std::string(pool + ref.offset, ref.length);
+}
+
+std::unique_ptr<Battle> BattleFileView::instantiate() const {
+    if (!data) return nullptr;
+    const BattleFileHeader& h = header();
+    auto battle = std::make_unique<Battle>(h.width, h.height);
+    for (int y = 0; y < h.height; ++y) {
+        for (int x = 0; x < h.width; ++x) {
+            Terrain t = static_cast<Terrain>(terrain()[y * h.width + x]);
+            if (t != Terrain::Open) battle->grid.setTerrain(x, y, t);
+        }
+    }
+
+    for (uint32_t slot = 0; slot < h.unitCount; ++slot) {
+        const FileUnit& u = units()[slot];
+        Combatant* c = battle->spawn(getString(u.name), getString(u.team), u.maxHealth, u.maxMagicPoints,
+            u.initiative, u.morale);
+
+        Weapon weapon;
+        weapon.name = getString(u.weapon.name);
+        weapon.physicalAttack = u.weapon.physicalAttack;
+        weapon.accuracy = u.weapon.accuracy;
+        weapon.range = u.weapon.range;
+        weapon.numberOfAttacks = u.weapon.numberOfAttacks;
+        weapon.element = static_cast<Element>(u.weapon.element);
+        c->equipWeapon(weapon);
+
+        Armor armor;
+        armor.name = getString(u.armor.name);
+        armor.damageResistance = u.armor.damageResistance;
+        armor.damageThreshold = u.armor.damageThreshold;
+        armor.evasion = u.armor.evasion;
+        armor.magicalDefense = u.armor.magicalDefense;
+        armor.element = static_cast<Element>(u.armor.element);
+        c->equipArmor(armor);
+
+        for (uint32_t i = 0; i < u.spellCount; ++i) {
+            const FileSpell& f = spells()[u.firstSpell + i];
+            Spell spell(getString(f.name), f.magicalAttack, f.mpCost, f.range, f.duration, "None", f.aoe, "Debuff");
+            spell.element = static_cast<Element>(f.element);
+            spell.category = static_cast<SpellCategory>(f.category);
+            c->learnSpell(spell);
+        }
+        for (uint32_t i = 0; i < u.itemCount; ++i) {
+            const FileItem& f = items()[u.firstItem + i];
+            Item item(getString(f.name), f.range, "None", f.potency);
+            item.category = static_cast<ItemCategory>(f.category);
+            c->addItem(item, f.quantity);
+        }
+    }
+
+    // Live rows go over a snapshot of the fresh battle, which keeps this
+    // process's team ids and already holds the item quantities.
+    BattleState state;
+    battle->saveState(state);
+    CombatantStore& rows = state.units;
+    for (uint32_t slot = 0; slot < h.unitCount; ++slot) {
+        const FileUnit& u = units()[slot];
+        rows.currentHealth[slot] = u.health;
+        rows.maxHealth[slot] = u.maxHealth;
+        rows.currentMagicPoints[slot] = u.magicPoints;
+        rows.maxMagicPoints[slot] = u.maxMagicPoints;
+        rows.initiative[slot] = u.initiative;
+        rows.morale[slot] = u.morale;
+        rows.xPos[slot] = u.x;
+        rows.yPos[slot] = u.y;
+        rows.flags[slot] = u.flags;
+        StatusList& list = rows.statuses[slot];
+        list.clear();
+        for (uint32_t i = 0; i < u.statusCount; ++i) {
+            const FileStatus& f = statuses()[u.firstStatus + i];
+            StatusEffect e;
+            e.type = static_cast<StatusType>(f.type);
+            e.durationTicks = f.durationTicks;
+            e.potency = f.potency;
+            e.stacks = f.stacks;
+            list.push(e);
+        }
+        state.schedulePos[slot] = u.schedulePos;
+    }
+    state.occupants.assign(occupants(), occupants() + h.occupantCount);
+    for (int slot : state.occupants) state.cells[rows.yPos[slot] * h.width + rows.xPos[slot]] = slot;
+    state.rng.reseed(h.rngSeed, h.rngStream);
+    state.rng.seek(h.rngPosition);
+
+    battle->restoreState(state);
+    return battle;
+}
+
+bool BattleFile::open(const std::string& path) {
+    return file.open(path) && view.open(file.data(), file.size());
+}
+
+// ==========================================
+// Memory-Mapped Files
+// ==========================================
+MappedFile::~MappedFile() { close(); }
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE fileH = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileH == INVALID_HANDLE_VALUE) return false;
+    fileHandle = fileH;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileH, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(fileH, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    mappingHandle = mapping;
+    bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    bytes = nullptr;
+    length = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close();
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    bytes = static_cast<const uint8_t*>(mapped);
+    length = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    if (fd >= 0) ::close(fd);
+    bytes = nullptr;
+    length = 0;
+    fd = -1;
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef BATTLE_FILE_H
+#define BATTLE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "scenario.h"
+
+// ==========================================
+// Battle Files
+// ==========================================
+// A versioned, fixed-layout snapshot of a whole battle, laid out so that a
+// mapped file is used in place. The file is a header of section offsets,
+// then flat arrays of plain records, then one string pool. Sections are
+// 8-byte aligned and integers little-endian (the byte-order word rejects
+// anything else), so opening a view takes one validation pass and no
+// decoding. Saved before the first turn, a file is a scenario; saved
+// mid-battle, it is a checkpoint that resumes exactly where it stopped,
+// RNG position included.
+const uint32_t BATTLE_FILE_MAGIC = 0x53475052;      // "RPGS"
+const uint32_t BATTLE_FILE_VERSION = 2;
+const uint32_t BATTLE_FILE_BYTE_ORDER = 0x01020304;
+
+struct FileStringRef {
+    uint32_t offset;        // Into the string pool
+    uint32_t length;
+};
+
+struct FileWeapon {
+    FileStringRef name;
+    int32_t physicalAttack;
+    float accuracy;
+    float range;
+    int32_t numberOfAttacks;
+    uint8_t element;
+    uint8_t pad[3];
+};
+
+struct FileArmor {
+    FileStringRef name;
+    int32_t damageResistance;
+    int32_t damageThreshold;
+    float evasion;
+    int32_t magicalDefense;
+    uint8_t element;
+    uint8_t pad[3];
+};
+
+struct FileSpell {
+    FileStringRef name;
+    int32_t magicalAttack;
+    int32_t mpCost;
+    float range;
+    int32_t duration;
+    int32_t aoe;
+    uint8_t element;
+    uint8_t category;
+    uint8_t pad[2];
+};
+
+struct FileItem {
+    FileStringRef name;
+    int32_t quantity;
+    float range;
+    int32_t potency;
+    uint8_t category;
+    uint8_t pad[3];
+};
+
+struct FileStatus {
+    int32_t durationTicks;
+    int32_t potency;
+    int32_t stacks;
+    uint8_t type;
+    uint8_t pad[3];
+};
+
+// One participant, in slot order. Spells, items and statuses are ranges of
+// the shared spell, item and status sections.
+struct FileUnit {
+    FileStringRef name;
+    FileStringRef team;
+    int32_t health;
+    int32_t maxHealth;
+    int32_t magicPoints;
+    int32_t maxMagicPoints;
+    int32_t initiative;
+    int32_t morale;
+    int32_t x;
+    int32_t y;
+    int32_t schedulePos;    // Initiative heap index, -1 = unscheduled
+    uint32_t firstSpell;
+    uint32_t spellCount;
+    uint32_t firstItem;
+    uint32_t itemCount;
+    uint32_t firstStatus;
+    uint32_t statusCount;
+    uint8_t flags;
+    uint8_t pad[3];
+    FileWeapon weapon;
+    FileArmor armor;
+};
+
+struct BattleFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    int32_t width;
+    int32_t height;
+    uint64_t rngSeed;
+    uint64_t rngStream;
+    uint64_t rngPosition;
+    uint32_t unitCount;
+    uint32_t spellCount;
+    uint32_t itemCount;
+    uint32_t occupantCount;     // Slots on the grid, in placement order
+    uint32_t statusCount;
+    uint32_t pad;
+    uint64_t terrainOffset;     // width * height Terrain bytes, row-major
+    uint64_t unitsOffset;
+    uint64_t spellsOffset;
+    uint64_t itemsOffset;
+    uint64_t statusesOffset;
+    uint64_t occupantsOffset;   // uint32 slots
+    uint64_t stringsOffset;
+    uint64_t stringBytes;
+};
+
+static_assert(std::is_trivially_copyable<FileUnit>::value && std::is_trivially_copyable<BattleFileHeader>::value,
+    "battle file records must be plain data");
+static_assert(sizeof(BattleFileHeader) == 144 && sizeof(FileUnit) == 136, "battle file layout changed; bump BATTLE_FILE_VERSION");
+
+// One unit's place in a stored turn order.
+struct ScheduleSlot {
+    int pos;            // Initiative heap index, -1 = unscheduled
+    int initiative;
+    bool alive;         // HP left and not fled
+};
+
+// True when the heap indices of `slots` (in participant order) rebuild the
+// engine's initiative heap: exactly the living units are scheduled, their
+// indices are a permutation of 0..scheduled-1, and every parent comes no
+// later than its children on (initiative, slot). Checked by every loader
+// before a stored turn order reaches BattleManager::restoreState.
+bool validSchedule(const std::vector<ScheduleSlot>& slots);
+
+// True when one unit's stored statuses can be pushed into a StatusList: each
+// has a known type, a tick left, a non-negative potency and 1..MAX_STACKS
+// stacks, and the potency total per type fits in an int.
+bool validStatuses(const std::vector<StatusEffect>& statuses);
+
+// Serializes `battle` in its current state.
+void encodeBattleFile(const Battle& battle, std::vector<uint8_t>& out);
+bool saveBattleFile(const std::string& path, const Battle& battle);
+
+// Read-only typed view over an encoded battle file. open() checks the header,
+// that every section and string lies inside the buffer, and that enums,
+// ranges and grid positions are consistent, and that the turn order and each
+// unit's statuses pass validSchedule() and validStatuses(); after that the
+// accessors index straight into the bytes. The buffer must outlive the view.
+class BattleFileView {
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    template <typename T>
+    const T* section(uint64_t offset) const { return reinterpret_cast<const T*>(data + offset); }
+    bool validate() const;
+
+public:
+    bool open(const uint8_t* bytes, size_t length);
+    bool isOpen() const { return data != nullptr; }
+
+    const BattleFileHeader& header() const { return *section<BattleFileHeader>(0); }
+    const uint8_t* terrain() const { return section<uint8_t>(header().terrainOffset); }
+    const FileUnit* units() const { return section<FileUnit>(header().unitsOffset); }
+    const FileSpell* spells() const { return section<FileSpell>(header().spellsOffset); }
+    const FileItem* items() const { return section<FileItem>(header().itemsOffset); }
+    const FileStatus* statuses() const { return section<FileStatus>(header().statusesOffset); }
+    const uint32_t* occupants() const { return section<uint32_t>(header().occupantsOffset); }
+    std::string getString(FileStringRef ref) const;
+
+    // Builds a live battle from the view.
+    std::unique_ptr<Battle> instantiate() const;
+};
+
+// ==========================================
+// Memory-Mapped Files
+// ==========================================
+// Read-only mapping of a whole file: mmap on POSIX, a file mapping on Windows.
+class MappedFile {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// A mapped battle file and its view.
+class BattleFile {
+private:
+    MappedFile file;
+    BattleFileView view;
+
+public:
+    bool open(const std::string& path);
+    const BattleFileView& getView() const { return view; }
+    std::unique_ptr<Battle> instantiate() const { return view.instantiate(); }
+};
+
+#endif
@@ -0,0 +1,875 @@
+#include "battle_server.h"
+#include "battle_action.h"
+#include "battle_ai.h"
+#include "scenario.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int SLOT_BITS = 20;                   // Battle id = generation << SLOT_BITS | slot
+const uint32_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+const int REQUESTS_PER_TASK = 16;           // Then the battle yields its worker
+const size_t READ_CHUNK = 1 << 16;
+const size_t MAX_OUTPUT_BYTES = 1 << 20;    // Unsent replies queued for a client before it is dropped
+
+// Little-endian frame building and parsing.
+struct FrameWriter {
+    std::vector<uint8_t>& out;
+    size_t start;
+
+    FrameWriter(std::vector<uint8_t>& buffer, ServerMessage type) : out(buffer), start(buffer.size()) {
+        put32(0);
+        put8(static_cast<uint8_t>(type));
+    }
+    void put8(uint8_t v) { out.push_back(v); }
+    void put16(uint16_t v) { put8(static_cast<uint8_t>(v)); put8(static_cast<uint8_t>(v >> 8)); }
+    void put32(uint32_t v) { put16(static_cast<uint16_t>(v)); put16(static_cast<uint16_t>(v >> 16)); }
+    void put64(uint64_t v) { put32(static_cast<uint32_t>(v)); put32(static_cast<uint32_t>(v >> 32)); }
+    void putDouble(double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        put64(bits);
+    }
+    // Writes the payload length into the header.
+    void finish() {
+        uint32_t length = static_cast<uint32_t>(out.size() - start - 4);
+        for (int i = 0; i < 4; ++i) out[start + i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+};
+
+struct FrameReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    FrameReader(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+    uint64_t get(int bytes) {
+        if (end - p < bytes) {
+            ok = false;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+        p += bytes;
+        return v;
+    }
+    uint8_t get8() { return static_cast<uint8_t>(get(1)); }
+    uint16_t get16() { return static_cast<uint16_t>(get(2)); }
+    uint32_t get32() { return static_cast<uint32_t>(get(4)); }
+    uint64_t get64() { return get(8); }
+    double getDouble() {
+        uint64_t bits = get64();
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+};
+
+// Splits complete frames off the front of `input`, calling body(payload,
+// length) for each. Returns false on a frame too large or empty.
+template <typename Body>
+bool takeFrames(std::vector<uint8_t>& input, Body&& body) {
+    size_t offset = 0;
+    bool ok = true;
+    while (input.size() - offset >= 4) {
+        uint32_t length = static_cast<uint32_t>(input[offset]) | (static_cast<uint32_t>(input[offset + 1]) << 8) |
+            (static_cast<uint32_t>(input[offset + 2]) << 16) | (static_cast<uint32_t>(input[offset + 3]) << 24);
+        if (length == 0 || length > MAX_FRAME_BYTES) {
+            ok = false;
+            break;
+        }
+        if (input.size() - offset - 4 < length) break;
+        body(input.data() + offset + 4, length);
+        offset += 4 + length;
+    }
+    input.erase(input.begin(), input.begin() + offset);
+    return ok;
+}
+
+double microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+BattleStatus statusOf(const std::string& winner) {
+    if (winner == "Good Guys") return BattleStatus::GoodWins;
+    if (winner == "Bad Guys") return BattleStatus::BadWins;
+    if (winner == "Draw") return BattleStatus::Draw;
+    return BattleStatus::Ongoing;
+}
+
+} // namespace
+
+// ==========================================
+// Server
+// ==========================================
+struct BattleServer::Connection {
+    int fd;
+    int wakeFd;                         // The server's wake pipe
+    std::mutex writeLock;
+    bool open = true;                   // Guarded by writeLock
+    std::vector<uint8_t> output;        // Guarded by writeLock; bytes the socket has not taken yet
+    std::vector<uint8_t> input;         // I/O thread only
+    std::mutex ownedLock;
+    std::unordered_set<uint32_t> owned; // Battle ids to close on disconnect
+
+    Connection(int socket, int wake) : fd(socket), wakeFd(wake) {}
+    ~Connection();
+
+    // Never blocks: sends what the socket takes now and queues the rest for
+    // the I/O thread, which flush()es it once the socket is writable. A
+    // client that lets more than MAX_OUTPUT_BYTES pile up is dropped.
+    void send(const std::vector<uint8_t>& frame);
+    // I/O thread only.
+    void flush();
+    bool hasOutput();
+    // Gives up on the client; its reads then end and the I/O thread
+    // disconnects it.
+    void drop();
+
+private:
+    // Writes without blocking, under writeLock; returns the bytes taken.
+    size_t sendNow(const uint8_t* data, size_t size);
+};
+
+struct BattleServer::Request {
+    ServerMessage type = ServerMessage::Act;
+    uint32_t id = 0;
+    uint32_t battleId = 0;
+    uint8_t scenario = 0;
+    uint16_t units = 0;
+    uint64_t seed = 0;
+    uint8_t action = ACT_AUTO;
+    BattleAction explicitAction;
+    std::chrono::steady_clock::time_point received;
+    std::shared_ptr<Connection> connection;
+};
+
+struct BattleServer::HostedBattle {
+    std::mutex lock;
+    std::deque<Request> inbox;          // Guarded by lock
+    bool scheduled = false;             // Guarded by lock
+    uint32_t generation = 0;            // Guarded by lock
+    bool live = false;                  // Guarded by lock; false once closed
+
+    // Touched only by the worker running this battle's task.
+    std::unique_ptr<Battle> battle;
+    Combatant* actor = nullptr;
+    BattleStatus status = BattleStatus::Ongoing;
+    uint32_t turns = 0;
+    std::shared_ptr<Connection> owner;
+    std::vector<BattleAction> legal;
+    std::vector<uint8_t> reply;
+
+    // Ends the finished turn: records a winner, or draws and readies the
+    // next actor, as runHeadlessBattle's loop does.
+    void advance() {
+        actor = nullptr;
+        status = statusOf(battle->manager.getWinner());
+        if (status != BattleStatus::Ongoing) return;
+        actor = battle->manager.getNextActiveCombatant();
+        if (!actor) {
+            status = BattleStatus::Draw;
+            return;
+        }
+        actor->startTurn();
+    }
+    uint16_t actorSlot() const { return actor ? static_cast<uint16_t>(actor->getSlot()) : NO_ACTOR; }
+};
+
+#ifndef _WIN32
+
+BattleServer::Connection::~Connection() { ::close(fd); }
+
+size_t BattleServer::Connection::sendNow(const uint8_t* data, size_t size) {
+    size_t taken = 0;
+    while (open && taken < size) {
+        ssize_t sent = ::send(fd, data + taken, size - taken, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (sent <= 0) {
+            drop();
+            break;
+        }
+        taken += static_cast<size_t>(sent);
+    }
+    return taken;
+}
+
+void BattleServer::Connection::send(const std::vector<uint8_t>& frame) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    size_t taken = output.empty() ? sendNow(frame.data(), frame.size()) : 0;
+    if (!open || taken == frame.size()) return;
+    bool wasIdle = output.empty();
+    output.insert(output.end(), frame.begin() + taken, frame.end());
+    if (output.size() > MAX_OUTPUT_BYTES) return drop();
+    // Have the I/O thread start polling this socket for POLLOUT.
+    if (wasIdle) {
+        char wake = 1;
+        ssize_t woken = ::write(wakeFd, &wake, 1);
+        (void)woken;
+    }
+}
+
+void BattleServer::Connection::flush() {
+    std::lock_guard<std::mutex> guard(writeLock);
+    size_t taken = sendNow(output.data(), output.size());
+    // A send error part-way drops the connection, which already cleared output.
+    if (open) output.erase(output.begin(), output.begin() + taken);
+}
+
+bool BattleServer::Connection::hasOutput() {
+    std::lock_guard<std::mutex> guard(writeLock);
+    return open && !output.empty();
+}
+
+void BattleServer::Connection::drop() {
+    if (open) ::shutdown(fd, SHUT_RDWR);
+    open = false;
+    output.clear();
+}
+
+BattleServer::BattleServer(const ServerConfig& config) : config(config) {
+    this->config.maxBattles = std::max(1, std::min(this->config.maxBattles, static_cast<int>(SLOT_MASK) + 1));
+}
+
+BattleServer::~BattleServer() { stop(); }
+
+bool BattleServer::start(std::string& error) {
+    if (config.socketPath.empty()) {
+        const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+        std::string pattern = std::string(runtime && *runtime ? runtime : "/tmp") + "/rpgcombat-XXXXXX";
+        if (!::mkdtemp(pattern.data())) {
+            error = "Cannot create a directory like " + pattern + ": " + std::strerror(errno);
+            return false;
+        }
+        scratchDir = pattern;
+        config.socketPath = scratchDir + "/server.sock";
+    }
+    auto removeScratch = [this]() {
+        if (scratchDir.empty()) return;
+        ::rmdir(scratchDir.c_str());
+        scratchDir.clear();
+        config.socketPath.clear();
+    };
+
+    sockaddr_un address{};
+    if (config.socketPath.size() >= sizeof(address.sun_path)) {
+        error = "Socket path must be 1-" + std::to_string(sizeof(address.sun_path) - 1) + " characters";
+        removeScratch();
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, config.socketPath.c_str(), config.socketPath.size() + 1);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    socketBound = listenFd >= 0 && ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    if (!socketBound || ::listen(listenFd, 128) != 0 || ::pipe(wakeFds) != 0) {
+        error = "Cannot listen on " + config.socketPath + ": " + std::strerror(errno);
+        if (listenFd >= 0) ::close(listenFd);
+        listenFd = -1;
+        if (socketBound) ::unlink(config.socketPath.c_str());
+        socketBound = false;
+        removeScratch();
+        return false;
+    }
+    // Workers wake the I/O thread through the pipe too; neither side may block.
+    for (int fd : wakeFds) ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    battles.reset(new HostedBattle[config.maxBattles]);
+    for (int slot = config.maxBattles - 1; slot >= 0; --slot) freeSlots.push_back(static_cast<uint32_t>(slot));
+    pool = std::make_unique<WorkStealingPool>(config.threads,
+        [this](int worker, uint32_t slot) { runBattle(worker, slot); });
+    for (int i = 0; i < pool->threadCount(); ++i) workerStats.push_back(std::make_unique<WorkerStats>());
+
+    running = true;
+    ioThread = std::thread([this]() { serve(); });
+    return true;
+}
+
+void BattleServer::stop() {
+    if (!running.exchange(false)) return;
+    char wake = 0;
+    ssize_t woken = ::write(wakeFds[1], &wake, 1);
+    (void)woken;
+    ioThread.join();
+    // Plays out the Close requests queued for every connection. A battle
+    // yielding its worker resubmits itself through `pool`, so the pool is
+    // only released once finish() has joined every worker.
+    pool->finish();
+    stoppedSteals = pool->stealCount();
+    pool.reset();
+    ::close(wakeFds[0]);
+    ::close(wakeFds[1]);
+    ::close(listenFd);
+    listenFd = -1;
+    if (socketBound) ::unlink(config.socketPath.c_str());
+    socketBound = false;
+    if (!scratchDir.empty()) ::rmdir(scratchDir.c_str());
+}
+
+ServerStats BattleServer::stats() {
+    ServerStats total;
+    for (auto& worker : workerStats) {
+        std::lock_guard<std::mutex> guard(worker->lock);
+        total.actions += worker->actions;
+        total.latency.merge(worker->latency);
+    }
+    total.battlesCreated = battlesCreated.load();
+    total.liveBattles = liveBattles.load();
+    total.steals = pool ? pool->stealCount() : stoppedSteals;
+    return total;
+}
+
+void BattleServer::serve() {
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> polled;
+    std::vector<uint8_t> chunk(READ_CHUNK);
+
+    // Closes every battle the connection still owns, through its own queue.
+    auto disconnect = [&](const std::shared_ptr<Connection>& connection) {
+        {
+            std::lock_guard<std::mutex> guard(connection->writeLock);
+            connection->drop();
+        }
+        std::vector<uint32_t> owned;
+        {
+            std::lock_guard<std::mutex> guard(connection->ownedLock);
+            owned.assign(connection->owned.begin(), connection->owned.end());
+        }
+        std::vector<uint8_t> frame;
+        for (uint32_t battle : owned) {
+            frame.clear();
+            FrameWriter w(frame, ServerMessage::Close);
+            w.put32(0);
+            w.put32(battle);
+            w.finish();
+            dispatch(connection, frame.data() + 4, static_cast<uint32_t>(frame.size() - 4));
+        }
+    };
+
+    while (running) {
+        polled.clear();
+        polled.push_back(pollfd{ listenFd, POLLIN, 0 });
+        polled.push_back(pollfd{ wakeFds[0], POLLIN, 0 });
+        for (const auto& connection : connections) {
+            short events = POLLIN | (connection->hasOutput() ? POLLOUT : 0);
+            polled.push_back(pollfd{ connection->fd, events, 0 });
+        }
+        if (::poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (polled[1].revents) {
+            char drained[64];
+            while (::read(wakeFds[0], drained, sizeof(drained)) > 0) {}
+            if (!running) break;
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            std::shared_ptr<Connection>& connection = connections[i];
+            short events = polled[i + 2].revents;
+            bool alive = true;
+            if (events & POLLOUT) connection->flush();
+            if (events & (POLLIN | POLLHUP | POLLERR)) {
+                ssize_t got = ::recv(connection->fd, chunk.data(), chunk.size(), 0);
+                if (got <= 0) {
+                    alive = false;
+                }
+                else {
+                    connection->input.insert(connection->input.end(), chunk.begin(), chunk.begin() + got);
+                    alive = takeFrames(connection->input, [&](const uint8_t* payload, uint32_t length) {
+                        dispatch(connection, payload, length);
+                    });
+                }
+            }
+            if (alive) connections[kept++] = std::move(connection);
+            else disconnect(connection);
+        }
+        connections.resize(kept);
+
+        if (polled[0].revents & POLLIN) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) connections.push_back(std::make_shared<Connection>(fd, wakeFds[1]));
+        }
+    }
+    for (const auto& connection : connections) disconnect(connection);
+}
+
+#else
+
+BattleServer::Connection::~Connection() {}
+void BattleServer::Connection::send(const std::vector<uint8_t>&) {}
+void BattleServer::Connection::flush() {}
+bool BattleServer::Connection::hasOutput() { return false; }
+void BattleServer::Connection::drop() {}
+size_t BattleServer::Connection::sendNow(const uint8_t*, size_t) { return 0; }
+BattleServer::BattleServer(const ServerConfig& config) : config(config) {}
+BattleServer::~BattleServer() {}
+bool BattleServer::start(std::string& error) {
+    error = "The battle server needs Unix domain sockets (POSIX only)";
+    return false;
+}
+void BattleServer::stop() {}
+ServerStats BattleServer::stats() { return ServerStats(); }
+void BattleServer::serve() {}
+
+#endif
+
+void BattleServer::dispatch(const std::shared_ptr<Connection>& connection, const uint8_t* payload, uint32_t length) {
+    FrameReader r(payload, length);
+    Request request;
+    request.received = std::chrono::steady_clock::now();
+    request.type = static_cast<ServerMessage>(r.get8());
+    request.id = r.get32();
+    request.connection = connection;
+
+    auto replyError = [&](ServerError code) {
+        std::vector<uint8_t> frame;
+        FrameWriter w(frame, ServerMessage::Error);
+        w.put32(request.id);
+        w.put8(static_cast<uint8_t>(code));
+        w.finish();
+        connection->send(frame);
+    };
+
+    uint32_t slot = 0;
+    switch (request.type) {
+    case ServerMessage::Create: {
+        request.scenario = r.get8();
+        request.units = r.get16();
+        request.seed = r.get64();
+        if (!r.ok) return replyError(ServerError::Malformed);
+        {
+            std::lock_guard<std::mutex> guard(freeLock);
+            if (freeSlots.empty()) return replyError(ServerError::Full);
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        HostedBattle& hosted = battles[slot];
+        std::lock_guard<std::mutex> guard(hosted.lock);
+        hosted.generation = (hosted.generation + 1) & (0xFFFFFFFFu >> SLOT_BITS);
+        hosted.live = true;
+        request.battleId = (hosted.generation << SLOT_BITS) | slot;
+        std::lock_guard<std::mutex> owned(connection->ownedLock);
+        connection->owned.insert(request.battleId);
+        break;
+    }
+    case ServerMessage::Act:
+        request.battleId = r.get32();
+        request.action = r.get8();
+        request.explicitAction.target = static_cast<int16_t>(r.get16());
+        request.explicitAction.index = static_cast<int16_t>(r.get16());
+        request.explicitAction.dx = static_cast<int8_t>(r.get8());
+        request.explicitAction.dy = static_cast<int8_t>(r.get8());
+        request.explicitAction.type = static_cast<ActionType>(request.action);
+        if (!r.ok) return replyError(ServerError::Malformed);
+        break;
+    case ServerMessage::Close:
+        request.battleId = r.get32();
+        if (!r.ok) return replyError(ServerError::Malformed);
+        break;
+    case ServerMessage::Stats: {
+        if (!r.ok) return replyError(ServerError::Malformed);
+        ServerStats now = stats();
+        std::vector<uint8_t> frame;
+        FrameWriter w(frame, ServerMessage::StatsOk);
+        w.put32(request.id);
+        w.put64(static_cast<uint64_t>(now.actions));
+        w.put32(static_cast<uint32_t>(now.liveBattles));
+        w.put64(static_cast<uint64_t>(now.steals));
+        w.putDouble(now.latency.quantile(0.50));
+        w.putDouble(now.latency.quantile(0.99));
+        w.finish();
+        connection->send(frame);
+        return;
+    }
+    default:
+        return replyError(ServerError::Malformed);
+    }
+
+    slot = request.battleId & SLOT_MASK;
+    if (slot >= static_cast<uint32_t>(config.maxBattles)) return replyError(ServerError::UnknownBattle);
+    HostedBattle& hosted = battles[slot];
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> guard(hosted.lock);
+        if (!hosted.live || hosted.generation != request.battleId >> SLOT_BITS) {
+            schedule = true;    // Reused below as "reply with an error"
+        }
+        else {
+            hosted.inbox.push_back(std::move(request));
+            if (!hosted.scheduled) {
+                hosted.scheduled = true;
+                pool->submit(slot);
+            }
+        }
+    }
+    if (schedule) replyError(ServerError::UnknownBattle);
+}
+
+void BattleServer::runBattle(int worker, uint32_t slot) {
+    HostedBattle& hosted = battles[slot];
+    for (int handled = 0;; ++handled) {
+        Request request;
+        {
+            std::lock_guard<std::mutex> guard(hosted.lock);
+            if (hosted.inbox.empty()) {
+                hosted.scheduled = false;
+                return;
+            }
+            // Yield to other battles; this one stays scheduled.
+            if (handled == REQUESTS_PER_TASK) {
+                pool->submit(slot);
+                return;
+            }
+            request = std::move(hosted.inbox.front());
+            hosted.inbox.pop_front();
+        }
+        handle(worker, hosted, slot, request);
+    }
+}
+
+void BattleServer::handle(int worker, HostedBattle& hosted, uint32_t slot, Request& request) {
+    std::vector<uint8_t>& reply = hosted.reply;
+    reply.clear();
+    auto sendError = [&](ServerError code) {
+        FrameWriter w(reply, ServerMessage::Error);
+        w.put32(request.id);
+        w.put8(static_cast<uint8_t>(code));
+        w.finish();
+        request.connection->send(reply);
+    };
+
+    if (request.type == ServerMessage::Create) {
+        hosted.battle = request.scenario == 1 ? buildSkirmishScenario(std::max(1, std::min<int>(request.units, 64)))
+            : buildDefaultScenario();
+        hosted.battle->manager.getRng().reseed(request.seed, 0);
+        hosted.owner = request.connection;
+        hosted.turns = 0;
+        hosted.advance();
+        battlesCreated++;
+        liveBattles++;
+        FrameWriter w(reply, ServerMessage::Created);
+        w.put32(request.id);
+        w.put32(request.battleId);
+        w.put16(hosted.actorSlot());
+        w.finish();
+        request.connection->send(reply);
+        return;
+    }
+
+    // Requests queued before the battle was closed.
+    if (!hosted.battle) return sendError(ServerError::UnknownBattle);
+
+    if (request.type == ServerMessage::Close) {
+        hosted.battle.reset();
+        hosted.actor = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(hosted.lock);
+            hosted.live = false;
+        }
+        {
+            std::lock_guard<std::mutex> guard(hosted.owner->ownedLock);
+            hosted.owner->owned.erase(request.battleId);
+        }
+        hosted.owner.reset();
+        liveBattles--;
+        FrameWriter w(reply, ServerMessage::Closed);
+        w.put32(request.id);
+        w.put32(request.battleId);
+        w.finish();
+        request.connection->send(reply);
+        release(slot);
+        return;
+    }
+
+    if (hosted.status != BattleStatus::Ongoing) return sendError(ServerError::BattleOver);
+    Battle& battle = *hosted.battle;
+    Combatant* actor = hosted.actor;
+    BattleAction action;
+    if (actor->isBroken()) {
+        action = choosePanicAction(actor, battle.grid);
+    }
+    else if (request.action == ACT_AUTO) {
+        action = chooseAIAction(actor, battle.grid);
+    }
+    else {
+        hosted.legal.clear();
+        legalActions(battle.manager, battle.grid, actor, hosted.legal);
+        if (std::find(hosted.legal.begin(), hosted.legal.end(), request.explicitAction) == hosted.legal.end()) {
+            return sendError(ServerError::IllegalAction);
+        }
+        action = request.explicitAction;
+    }
+    playTurn(actor, action, battle.manager, battle.grid);
+    hosted.turns++;
+    hosted.advance();
+
+    FrameWriter w(reply, ServerMessage::Result);
+    w.put32(request.id);
+    w.put32(request.battleId);
+    w.put16(static_cast<uint16_t>(actor->getSlot()));
+    w.put8(static_cast<uint8_t>(action.type));
+    w.put8(static_cast<uint8_t>(hosted.status));
+    w.put16(hosted.actorSlot());
+    w.put32(hosted.turns);
+    w.finish();
+    request.connection->send(reply);
+
+    WorkerStats& stats = *workerStats[worker];
+    std::lock_guard<std::mutex> guard(stats.lock);
+    stats.actions++;
+    stats.latency.add(microsecondsSince(request.received));
+}
+
+void BattleServer::release(uint32_t slot) {
+    std::lock_guard<std::mutex> guard(freeLock);
+    freeSlots.push_back(slot);
+}
+
+void ServerStats::print() const {
+    std::cout << "=== BATTLE SERVER ===\n"
+        << "Actions:    " << actions << " | Battles: " << battlesCreated << " created, " << liveBattles << " live\n"
+        << "Latency:    p50 " << latency.quantile(0.50) << " us | p99 " << latency.quantile(0.99)
+        << " us (act received -> result sent)\n"
+        << "Steals:     " << steals << "\n";
+}
+
+// ==========================================
+// Load Generator
+// ==========================================
+void LoadResult::print() const {
+    std::cout << "=== LOAD GENERATOR ===\n"
+        << "Actions:    " << actions << " in " << seconds << "s ("
+        << (seconds > 0.0 ? actions / seconds : 0.0) << " actions/s)\n"
+        << "Battles:    " << battles << " finished | Errors: " << errors << "\n"
+        << "Round trip: p50 " << latency.quantile(0.50) << " us | p99 " << latency.quantile(0.99) << " us\n"
+        << "Server:     p50 " << serverP50 << " us | p99 " << serverP99 << " us | " << serverActions << " actions, "
+        << serverSteals << " steals\n";
+}
+
+#ifndef _WIN32
+
+namespace {
+
+int connectTo(const std::string& path, std::string& error) {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "Bad socket path " + path;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        error = "Cannot connect to " + path + ": " + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const std::vector<uint8_t>& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t sent = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        done += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+struct ClientTotals {
+    long long actions = 0;
+    long long battles = 0;
+    long long errors = 0;
+    QuantileSketch latency;
+    std::string error;
+};
+
+// One connection's share of the load. Request ids are battle lane indices,
+// so each lane has exactly one request outstanding at a time.
+void runClient(const LoadConfig& config, int client, std::atomic<long long>& budget, ClientTotals& totals) {
+    int fd = connectTo(config.socketPath, totals.error);
+    if (fd < 0) return;
+
+    struct Lane {
+        uint32_t battle = 0;
+        std::chrono::steady_clock::time_point sent;
+    };
+    std::vector<Lane> lanes(config.battlesPerConnection);
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> chunk(READ_CHUNK);
+    long long outstanding = 0;
+    uint64_t battleCount = 0;
+
+    auto create = [&](uint32_t lane) {
+        FrameWriter w(out, ServerMessage::Create);
+        w.put32(lane);
+        w.put8(config.skirmishUnits > 0 ? 1 : 0);
+        w.put16(static_cast<uint16_t>(config.skirmishUnits));
+        w.put64(config.seed + (static_cast<uint64_t>(client) << 32) + battleCount++);
+        w.finish();
+        outstanding++;
+    };
+    auto act = [&](uint32_t lane) {
+        // Out of budget: retire the lane's battle instead.
+        if (budget.fetch_sub(1) <= 0) {
+            FrameWriter w(out, ServerMessage::Close);
+            w.put32(lane | 0x80000000u);
+            w.put32(lanes[lane].battle);
+            w.finish();
+            outstanding++;
+            return;
+        }
+        FrameWriter w(out, ServerMessage::Act);
+        w.put32(lane);
+        w.put32(lanes[lane].battle);
+        w.put8(ACT_AUTO);
+        w.put16(0);
+        w.put16(0);
+        w.put8(0);
+        w.put8(0);
+        w.finish();
+        lanes[lane].sent = std::chrono::steady_clock::now();
+        outstanding++;
+    };
+
+    for (uint32_t lane = 0; lane < lanes.size(); ++lane) create(lane);
+    while (outstanding > 0) {
+        if (!sendAll(fd, out)) {
+            totals.error = "Server closed the connection";
+            break;
+        }
+        out.clear();
+        ssize_t got = ::recv(fd, chunk.data(), chunk.size(), 0);
+        if (got <= 0) {
+            totals.error = "Server closed the connection";
+            break;
+        }
+        input.insert(input.end(), chunk.begin(), chunk.begin() + got);
+        takeFrames(input, [&](const uint8_t* payload, uint32_t length) {
+            FrameReader r(payload, length);
+            ServerMessage type = static_cast<ServerMessage>(r.get8());
+            uint32_t request = r.get32();
+            uint32_t lane = request & 0x7FFFFFFFu;
+            outstanding--;
+            if (lane >= lanes.size()) return;
+            if (type == ServerMessage::Created) {
+                lanes[lane].battle = r.get32();
+                act(lane);
+            }
+            else if (type == ServerMessage::Result) {
+                totals.latency.add(microsecondsSince(lanes[lane].sent));
+                totals.actions++;
+                r.get32();
+                r.get16();
+                r.get8();
+                BattleStatus status = static_cast<BattleStatus>(r.get8());
+                if (status == BattleStatus::Ongoing) {
+                    act(lane);
+                    return;
+                }
+                FrameWriter w(out, ServerMessage::Close);
+                w.put32(lane);
+                w.put32(lanes[lane].battle);
+                w.finish();
+                outstanding++;
+            }
+            else if (type == ServerMessage::Closed) {
+                // Retired lanes (high bit) stay closed; finished battles are replaced.
+                if (request & 0x80000000u) return;
+                totals.battles++;
+                if (budget.load() > 0) create(lane);
+            }
+            else {
+                totals.errors++;
+            }
+        });
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+bool runLoadGenerator(const LoadConfig& config, LoadResult& result, std::string& error) {
+    result = LoadResult();
+    std::atomic<long long> budget(config.actions);
+    std::vector<ClientTotals> totals(std::max(config.connections, 1));
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < static_cast<int>(totals.size()); ++c) {
+        clients.emplace_back([&, c]() { runClient(config, c, budget, totals[c]); });
+    }
+    for (auto& client : clients) client.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& t : totals) {
+        if (!t.error.empty()) error = t.error;
+        result.actions += t.actions;
+        result.battles += t.battles;
+        result.errors += t.errors;
+        result.latency.merge(t.latency);
+    }
+    if (!error.empty()) return false;
+
+    // The server's own view, over a fresh connection.
+    int fd = connectTo(config.socketPath, error);
+    if (fd < 0) return false;
+    std::vector<uint8_t> frame;
+    FrameWriter w(frame, ServerMessage::Stats);
+    w.put32(0);
+    w.finish();
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> chunk(READ_CHUNK);
+    bool answered = false;
+    if (sendAll(fd, frame)) {
+        while (!answered) {
+            ssize_t got = ::recv(fd, chunk.data(), chunk.size(), 0);
+            if (got <= 0) break;
+            input.insert(input.end(), chunk.begin(), chunk.begin() + got);
+            takeFrames(input, [&](const uint8_t* payload, uint32_t length) {
+                FrameReader r(payload, length);
+                if (static_cast<ServerMessage>(r.get8()) != ServerMessage::StatsOk) return;
+                r.get32();
+                result.serverActions = static_cast<long long>(r.get64());
+                r.get32();
+                result.serverSteals = static_cast<long long>(r.get64());
+                result.serverP50 = r.getDouble();
+                result.serverP99 = r.getDouble();
+                answered = true;
+            });
+        }
+    }
+    ::close(fd);
+    if (!answered) error = "No stats reply from the server";
+    return answered;
+}
+
+#else
+
+bool runLoadGenerator(const LoadConfig&, LoadResult& result, std::string& error) {
+    result = LoadResult();
+    error = "The load generator needs Unix domain sockets (POSIX only)";
+    return false;
+}
+
+#endif
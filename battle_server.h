@@ -0,0 +1,159 @@
+#ifndef BATTLE_SERVER_H
+#define BATTLE_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "battle_analytics.h"
+#include "work_stealing_pool.h"
+
+// ==========================================
+// Battle Server Protocol
+// ==========================================
+// Clients talk to the server over a Unix domain socket in frames: a
+// little-endian u32 payload length, then the payload, whose first byte is
+// the message type. Every request carries a client-chosen u32 request id
+// that its reply echoes, so a client can keep many requests in flight.
+//
+//   Create   u32 request, u8 scenario (0 default, 1 skirmish), u16 units per team, u64 seed
+//   Act      u32 request, u32 battle, u8 action (ActionType, or ACT_AUTO), i16 target,
+//            i16 index, i8 dx, i8 dy
+//   Close    u32 request, u32 battle
+//   Stats    u32 request
+//
+//   Created  u32 request, u32 battle, u16 next actor slot
+//   Result   u32 request, u32 battle, u16 actor slot, u8 action played, u8 status,
+//            u16 next actor slot (NO_ACTOR once over), u32 turns played
+//   Closed   u32 request, u32 battle
+//   StatsOk  u32 request, u64 actions, u32 live battles, u64 steals, f64 p50 us, f64 p99 us
+//   Error    u32 request, u8 ServerError
+//
+// Each battle plays the way runHeadlessBattle does: the next actor is drawn
+// as soon as the previous turn ends, and a broken unit always panics
+// whatever it was told. An Act either names one of the actor's legal
+// actions or asks the greedy AI to choose (ACT_AUTO).
+enum class ServerMessage : uint8_t {
+    Create = 1, Act = 2, Close = 3, Stats = 4,
+    Created = 129, Result = 130, Closed = 131, StatsOk = 132, Error = 255
+};
+enum class ServerError : uint8_t { Malformed = 1, UnknownBattle = 2, IllegalAction = 3, BattleOver = 4, Full = 5 };
+enum class BattleStatus : uint8_t { Ongoing = 0, GoodWins = 1, BadWins = 2, Draw = 3 };
+const uint8_t ACT_AUTO = 255;
+const uint16_t NO_ACTOR = 0xFFFF;
+const uint32_t MAX_FRAME_BYTES = 1 << 16;
+
+// ==========================================
+// Battle Server
+// ==========================================
+struct ServerConfig {
+    std::string socketPath;         // Empty = a fresh private directory under $XDG_RUNTIME_DIR or /tmp
+    int threads = 0;                // Pool workers (0 = one per hardware thread)
+    int maxBattles = 1 << 16;       // Hosted at once
+};
+
+struct ServerStats {
+    long long actions = 0;
+    long long battlesCreated = 0;
+    int liveBattles = 0;
+    long long steals = 0;
+    QuantileSketch latency;         // Act received -> Result sent, in microseconds
+
+    void print() const;
+};
+
+// Hosts up to maxBattles battles in one process. One I/O thread polls the
+// listening socket and every connection, splits frames and queues each
+// request on its battle; a battle with queued requests is one task on a
+// WorkStealingPool, so a battle only ever runs on one worker at a time
+// while different battles run in parallel. Replies never block a thread:
+// whatever a connection's socket will not take at once is queued, and the
+// I/O thread flushes it when poll reports the socket writable.
+class BattleServer {
+public:
+    explicit BattleServer(const ServerConfig& config);
+    ~BattleServer();
+    BattleServer(const BattleServer&) = delete;
+    BattleServer& operator=(const BattleServer&) = delete;
+
+    // Binds the socket and starts serving; false with `error` set on failure.
+    // An existing file at the socket path is left alone and fails the bind.
+    bool start(std::string& error);
+    // Stops accepting, finishes queued work and closes every connection,
+    // then removes the socket and any directory start() created.
+    void stop();
+    ServerStats stats();
+    const std::string& socketPath() const { return config.socketPath; }
+
+private:
+    struct Connection;
+    struct Request;
+    struct HostedBattle;
+
+    ServerConfig config;
+    int listenFd = -1;
+    bool socketBound = false;           // The socket file is ours to unlink
+    std::string scratchDir;             // Made by start() for an empty socketPath
+    int wakeFds[2] = { -1, -1 };
+    std::thread ioThread;
+    std::atomic<bool> running{ false };
+
+    std::unique_ptr<HostedBattle[]> battles;
+    std::mutex freeLock;
+    std::vector<uint32_t> freeSlots;
+    std::atomic<long long> battlesCreated{ 0 };
+    std::atomic<int> liveBattles{ 0 };
+
+    struct WorkerStats {
+        std::mutex lock;
+        long long actions = 0;
+        QuantileSketch latency;
+    };
+    std::vector<std::unique_ptr<WorkerStats>> workerStats;
+    std::unique_ptr<WorkStealingPool> pool;
+    long long stoppedSteals = 0;        // The pool's count, once stop() has joined it
+
+    void serve();
+    void dispatch(const std::shared_ptr<Connection>& connection, const uint8_t* payload, uint32_t length);
+    void runBattle(int worker, uint32_t slot);
+    void handle(int worker, HostedBattle& hosted, uint32_t slot, Request& request);
+    void release(uint32_t slot);
+};
+
+// ==========================================
+// Load Generator
+// ==========================================
+struct LoadConfig {
+    std::string socketPath;
+    int connections = 4;
+    int battlesPerConnection = 256;     // Kept in flight, one outstanding Act each
+    long long actions = 200000;         // Total across connections
+    int skirmishUnits = 0;              // Per team; 0 = the default scenario
+    uint64_t seed = 0;
+};
+
+struct LoadResult {
+    long long actions = 0;
+    long long battles = 0;
+    long long errors = 0;
+    double seconds = 0.0;
+    QuantileSketch latency;     // Act sent -> Result received, in microseconds
+
+    // The server's StatsOk reply at the end.
+    long long serverActions = 0;
+    long long serverSteals = 0;
+    double serverP50 = 0.0;
+    double serverP99 = 0.0;
+
+    void print() const;
+};
+
+// Opens `connections` clients, each keeping `battlesPerConnection` battles
+// going with AI-chosen actions (replacing every battle that ends) until
+// `actions` results have come back, then asks the server for its stats.
+bool runLoadGenerator(const LoadConfig& config, LoadResult& result, std::string& error);
+
+#endif
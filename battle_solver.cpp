@@ -0,0 +1,419 @@
+#include "battle_solver.h"
+#include "battle_ai.h"
+#include "battle_action.h"
+#include "simulation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+enum Outcome { GOOD_WINS, BAD_WINS, DRAW, OUTCOME_COUNT, ONGOING = -1 };
+
+const size_t EXPAND_CHUNK = 4096;   // States expanded between interning passes
+
+Outcome outcomeOf(const std::string& winner) {
+    if (winner == "Good Guys") return GOOD_WINS;
+    if (winner == "Bad Guys") return BAD_WINS;
+    if (winner == "Draw") return DRAW;
+    return ONGOING;
+}
+
+// Walks every sequence of draw outcomes a turn can make, depth first: each
+// run replays the turn, taking the recorded pick at each draw it has seen
+// before and the first outcome of any new one; advance() then moves to the
+// next sequence like an odometer. A draw whose other outcome has zero odds
+// is not a branch.
+class BranchingScript : public DrawScript {
+private:
+    struct Draw {
+        int pick;
+        int outcomes;
+        double trueOdds;    // chance() draws; < 0 for a uniform nextInt
+    };
+    std::vector<Draw> path;
+    size_t depth = 0;
+
+public:
+    void clear() { path.clear(); depth = 0; }
+    void rewind() { depth = 0; }
+
+    int drawInt(int min, int max) override {
+        if (depth == path.size()) path.push_back(Draw{ 0, max - min + 1, -1.0 });
+        return min + path[depth++].pick;
+    }
+
+    bool drawChance(float probability) override {
+        if (depth == path.size()) {
+            double odds = BattleRng::chanceOdds(probability);
+            path.push_back(Draw{ 0, odds > 0.0 && odds < 1.0 ? 2 : 1, odds });
+        }
+        const Draw& draw = path[depth++];
+        return draw.outcomes == 1 ? draw.trueOdds >= 1.0 : draw.pick == 0;
+    }
+
+    // Odds of the sequence the last run took.
+    double odds() const {
+        double total = 1.0;
+        for (size_t i = 0; i < depth; ++i) {
+            const Draw& draw = path[i];
+            if (draw.trueOdds < 0.0) total /= draw.outcomes;
+            else if (draw.outcomes == 2) total *= draw.pick == 0 ? draw.trueOdds : 1.0 - draw.trueOdds;
+        }
+        return total;
+    }
+
+    bool advance() {
+        path.resize(depth);
+        while (!path.empty() && path.back().pick + 1 >= path.back().outcomes) path.pop_back();
+        if (path.empty()) return false;
+        path.back().pick++;
+        return true;
+    }
+};
+
+void putVarint(std::string& out, long long value) {
+    uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (zigzag >= 0x80) {
+        out.push_back(static_cast<char>((zigzag & 0x7F) | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back(static_cast<char>(zigzag));
+}
+
+long long getVarint(const char*& in) {
+    uint64_t zigzag = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        byte = static_cast<uint8_t>(*in++);
+        zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return static_cast<long long>(zigzag >> 1) ^ -static_cast<long long>(zigzag & 1);
+}
+
+// Everything in a BattleState that play can change, minus the RNG, packed
+// into a string: equal keys mean the fight goes on identically. Initiatives
+// are stored relative to the lowest scheduled one, which is all the
+// schedule ever compares. An unscheduled (defeated or fled) unit's is
+// dropped: the AI only ever targets living units, so it never acts again.
+void encodeState(const BattleState& state, std::string& key) {
+    const CombatantStore& u = state.units;
+    int count = u.size();
+    int base = INT_MAX;
+    for (int slot = 0; slot < count; ++slot) {
+        if (state.schedulePos[slot] != -1) base = std::min(base, u.initiative[slot]);
+    }
+    if (base == INT_MAX) base = 0;
+
+    key.clear();
+    for (int slot = 0; slot < count; ++slot) {
+        putVarint(key, u.currentHealth[slot]);
+        putVarint(key, u.currentMagicPoints[slot]);
+        putVarint(key, state.schedulePos[slot] == -1 ? 0 : static_cast<long long>(u.initiative[slot]) - base);
+        putVarint(key, u.morale[slot]);
+        putVarint(key, u.xPos[slot]);
+        putVarint(key, u.yPos[slot]);
+        putVarint(key, u.flags[slot]);
+        const StatusList& statuses = u.statuses[slot];
+        putVarint(key, statuses.count);
+        for (int type = 0; type < StatusList::TYPE_COUNT; ++type) putVarint(key, statuses.potencyTotal[type]);
+        for (int i = 0; i < statuses.count; ++i) {
+            const StatusEffect& e = statuses[i];
+            putVarint(key, static_cast<int>(e.type));
+            putVarint(key, e.durationTicks);
+            putVarint(key, e.potency);
+            putVarint(key, e.stacks);
+        }
+        putVarint(key, state.schedulePos[slot]);
+    }
+    putVarint(key, static_cast<long long>(state.occupants.size()));
+    for (int slot : state.occupants) putVarint(key, slot);
+    long long occupied = std::count_if(state.cells.begin(), state.cells.end(), [](int c) { return c != -1; });
+    putVarint(key, occupied);
+    for (size_t i = 0; i < state.cells.size(); ++i) {
+        if (state.cells[i] == -1) continue;
+        putVarint(key, static_cast<long long>(i));
+        putVarint(key, state.cells[i]);
+    }
+    for (int quantity : state.itemQuantities) putVarint(key, quantity);
+}
+
+// Inverse of encodeState into `state`, which must already hold a snapshot of
+// the same battle (it supplies the fields play never changes).
+void decodeState(const std::string& key, BattleState& state) {
+    CombatantStore& u = state.units;
+    int count = u.size();
+    const char* in = key.data();
+    for (int slot = 0; slot < count; ++slot) {
+        u.currentHealth[slot] = static_cast<int>(getVarint(in));
+        u.currentMagicPoints[slot] = static_cast<int>(getVarint(in));
+        u.initiative[slot] = static_cast<int>(getVarint(in));
+        u.morale[slot] = static_cast<int>(getVarint(in));
+        u.xPos[slot] = static_cast<int>(getVarint(in));
+        u.yPos[slot] = static_cast<int>(getVarint(in));
+        u.flags[slot] = static_cast<uint8_t>(getVarint(in));
+        StatusList& statuses = u.statuses[slot];
+        statuses.count = static_cast<int>(getVarint(in));
+        statuses.overflow.resize(statuses.count > StatusList::CAPACITY ? statuses.count - StatusList::CAPACITY : 0);
+        for (int type = 0; type < StatusList::TYPE_COUNT; ++type) statuses.potencyTotal[type] = static_cast<int>(getVarint(in));
+        for (int i = 0; i < statuses.count; ++i) {
+            StatusEffect& e = statuses[i];
+            e.type = static_cast<StatusType>(getVarint(in));
+            e.durationTicks = static_cast<int>(getVarint(in));
+            e.potency = static_cast<int>(getVarint(in));
+            e.stacks = static_cast<int>(getVarint(in));
+        }
+        state.schedulePos[slot] = static_cast<int>(getVarint(in));
+    }
+    state.occupants.resize(static_cast<size_t>(getVarint(in)));
+    for (int& slot : state.occupants) slot = static_cast<int>(getVarint(in));
+    std::fill(state.cells.begin(), state.cells.end(), -1);
+    for (long long occupied = getVarint(in); occupied > 0; --occupied) {
+        size_t cell = static_cast<size_t>(getVarint(in));
+        state.cells[cell] = static_cast<int>(getVarint(in));
+    }
+    for (int& quantity : state.itemQuantities) quantity = static_cast<int>(getVarint(in));
+}
+
+// Every way one state's turn can end: successor keys and terminal outcomes
+// with their odds.
+struct Expansion {
+    std::vector<std::pair<std::string, double>> next;
+    double terminal[OUTCOME_COUNT];
+    long long turns;
+};
+
+struct Worker {
+    std::unique_ptr<Battle> battle;
+    BattleState from;
+    BattleState to;
+    BranchingScript script;
+    std::string key;
+};
+
+// runHeadlessBattle's loop body, minus the winner check the caller has made.
+Outcome playOneTurn(Battle& battle) {
+    Combatant* actor = battle.manager.getNextActiveCombatant();
+    if (!actor) return DRAW;
+    actor->startTurn();
+    BattleAction action = actor->isBroken() ? choosePanicAction(actor, battle.grid)
+        : chooseAIAction(actor, battle.grid);
+    playTurn(actor, action, battle.manager, battle.grid);
+    return outcomeOf(battle.manager.getWinner());
+}
+
+void expand(Worker& w, const std::string& key, Expansion& out) {
+    out.next.clear();
+    std::fill(out.terminal, out.terminal + OUTCOME_COUNT, 0.0);
+    out.turns = 0;
+    decodeState(key, w.from);
+    w.script.clear();
+    do {
+        w.battle->restoreState(w.from);
+        w.battle->manager.getRng().setScript(&w.script);
+        w.script.rewind();
+        Outcome outcome = playOneTurn(*w.battle);
+        double odds = w.script.odds();
+        out.turns++;
+        if (outcome != ONGOING) {
+            out.terminal[outcome] += odds;
+            continue;
+        }
+        w.battle->saveState(w.to);
+        encodeState(w.to, w.key);
+        auto same = std::find_if(out.next.begin(), out.next.end(),
+            [&](const std::pair<std::string, double>& n) { return n.first == w.key; });
+        if (same != out.next.end()) same->second += odds;
+        else out.next.emplace_back(w.key, odds);
+    } while (w.script.advance());
+}
+
+// Runs `body(worker)` on every worker at once, or inline for small jobs.
+template <typename Body>
+void runWorkers(std::vector<Worker>& workers, size_t jobs, Body&& body) {
+    if (jobs < 2 * workers.size()) {
+        body(workers[0]);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workers.size(); ++t) threads.emplace_back([&, t]() { body(workers[t]); });
+    body(workers[0]);
+    for (auto& thread : threads) thread.join();
+}
+
+void sampleBattle(const Battle& battle, const SolverConfig& config, int threads, SolverResult& result) {
+    std::atomic<long long> nextBattle(0);
+    std::vector<SimulationResult> perThread(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::unique_ptr<Battle> copy = battle.clone();
+            BattleState opening;
+            copy->saveState(opening);
+            SimulationResult& local = perThread[t];
+            for (long long i = nextBattle++; i < config.fallbackBattles; i = nextBattle++) {
+                copy->restoreState(opening);
+                copy->manager.getRng().reseed(config.seed, static_cast<uint64_t>(i));
+                std::string winner = runHeadlessBattle(*copy);
+                local.battles++;
+                if (winner == "Good Guys") local.goodWins++;
+                else if (winner == "Bad Guys") local.badWins++;
+                else if (winner == "Draw") local.draws++;
+                else local.stalemates++;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    SimulationResult total;
+    for (const auto& local : perThread) total.merge(local);
+    double battles = total.battles > 0 ? static_cast<double>(total.battles) : 1.0;
+    result.sampledBattles = total.battles;
+    result.goodWins = total.goodWins / battles;
+    result.badWins = total.badWins / battles;
+    result.draws = total.draws / battles;
+    result.unresolved = total.stalemates / battles;
+}
+
+} // namespace
+
+void SolverResult::print() const {
+    if (exact) std::cout << "=== EXACT BATTLE SOLUTION ===\n";
+    else if (sampledBattles == 0) std::cout << "=== UNCONVERGED BATTLE SOLUTION (sweep limit reached) ===\n";
+    else std::cout << "=== SAMPLED BATTLE ESTIMATE ===\n";
+    if (sampledBattles == 0) {
+        std::cout << "States:     " << states << " (" << transitions << " transitions, depth " << depth << ")\n"
+            << "Turns:      " << turnsPlayed << " replayed in " << seconds << "s\n"
+            << "Solve:      " << sweeps << " sweeps, residual " << residual << "\n";
+    }
+    else {
+        std::cout << "States:     cap reached at " << states << " (depth " << depth << ")\n"
+            << "Battles:    " << sampledBattles << " sampled in " << seconds << "s\n";
+    }
+    std::cout << "Good Guys:  " << 100.0 * goodWins << "%\n"
+        << "Bad Guys:   " << 100.0 * badWins << "%\n"
+        << "Draws:      " << 100.0 * draws << "%\n"
+        << (exact ? "Endless:    " : "Stalemates: ") << 100.0 * unresolved << "%\n";
+}
+
+SolverResult solveBattle(const Battle& battle, const SolverConfig& config) {
+    auto start = std::chrono::steady_clock::now();
+    int threads = config.threads > 0 ? config.threads : static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    SolverResult result;
+    std::vector<Worker> workers(threads);
+    for (Worker& w : workers) {
+        w.battle = battle.clone();
+        w.battle->saveState(w.from);
+    }
+
+    // Hash-consed states in discovery order. Edges are stored per state in
+    // that order; a negative target is a terminal outcome, -1 - Outcome.
+    std::unordered_map<std::string, int> ids;
+    std::vector<const std::string*> keys;
+    std::vector<long long> edgeStart{ 0 };
+    std::vector<int> edgeTarget;
+    std::vector<double> edgeOdds;
+    auto intern = [&](std::string& key) {
+        auto inserted = ids.emplace(std::move(key), static_cast<int>(keys.size()));
+        if (inserted.second) keys.push_back(&inserted.first->first);
+        return inserted.first->second;
+    };
+
+    Outcome rootOutcome = outcomeOf(workers[0].battle->manager.getWinner());
+    std::string rootKey;
+    encodeState(workers[0].from, rootKey);
+    intern(rootKey);
+
+    std::vector<Expansion> expansions(EXPAND_CHUNK);
+    size_t levelBegin = 0;
+    bool capped = false;
+    while (rootOutcome == ONGOING && levelBegin < keys.size() && !capped) {
+        size_t levelEnd = keys.size();
+        result.depth++;
+        for (size_t chunk = levelBegin; chunk < levelEnd && !capped; chunk += EXPAND_CHUNK) {
+            size_t chunkEnd = std::min(chunk + EXPAND_CHUNK, levelEnd);
+            std::atomic<size_t> next(chunk);
+            runWorkers(workers, chunkEnd - chunk, [&](Worker& w) {
+                for (size_t i = next++; i < chunkEnd; i = next++) expand(w, *keys[i], expansions[i - chunk]);
+            });
+
+            for (size_t i = chunk; i < chunkEnd; ++i) {
+                Expansion& e = expansions[i - chunk];
+                result.turnsPlayed += e.turns;
+                for (int o = 0; o < OUTCOME_COUNT; ++o) {
+                    if (e.terminal[o] == 0.0) continue;
+                    edgeTarget.push_back(-1 - o);
+                    edgeOdds.push_back(e.terminal[o]);
+                }
+                for (auto& n : e.next) {
+                    edgeTarget.push_back(intern(n.first));
+                    edgeOdds.push_back(n.second);
+                }
+                edgeStart.push_back(static_cast<long long>(edgeTarget.size()));
+            }
+            capped = static_cast<long long>(keys.size()) > config.maxStates;
+        }
+        levelBegin = levelEnd;
+    }
+
+    result.states = static_cast<long long>(keys.size());
+    result.transitions = static_cast<long long>(edgeTarget.size());
+    if (capped) {
+        sampleBattle(battle, config, threads, result);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    if (rootOutcome != ONGOING) {
+        double* totals[OUTCOME_COUNT] = { &result.goodWins, &result.badWins, &result.draws };
+        *totals[rootOutcome] = 1.0;
+        result.exact = true;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    // Absorption odds per state and outcome, by Gauss-Seidel from zero. Most
+    // edges lead to later states, so sweeping backwards settles an acyclic
+    // chain in one pass; states that can recur need further sweeps.
+    size_t count = keys.size();
+    std::vector<double> value(count * OUTCOME_COUNT, 0.0);
+    do {
+        result.residual = 0.0;
+        for (size_t s = count; s-- > 0;) {
+            double sum[OUTCOME_COUNT] = {};
+            for (long long e = edgeStart[s]; e < edgeStart[s + 1]; ++e) {
+                int target = edgeTarget[e];
+                if (target < 0) {
+                    sum[-1 - target] += edgeOdds[e];
+                    continue;
+                }
+                for (int o = 0; o < OUTCOME_COUNT; ++o) sum[o] += edgeOdds[e] * value[target * OUTCOME_COUNT + o];
+            }
+            for (int o = 0; o < OUTCOME_COUNT; ++o) {
+                result.residual = std::max(result.residual, std::abs(sum[o] - value[s * OUTCOME_COUNT + o]));
+                value[s * OUTCOME_COUNT + o] = sum[o];
+            }
+        }
+        result.sweeps++;
+    } while (result.residual > config.tolerance && result.sweeps < config.maxSweeps);
+    result.exact = result.residual <= config.tolerance;
+
+    result.goodWins = value[GOOD_WINS];
+    result.badWins = value[BAD_WINS];
+    result.draws = value[DRAW];
+    result.unresolved = std::max(0.0, 1.0 - result.goodWins - result.badWins - result.draws);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
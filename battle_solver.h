@@ -0,0 +1,50 @@
+#ifndef BATTLE_SOLVER_H
+#define BATTLE_SOLVER_H
+
+#include <cstdint>
+#include "scenario.h"
+
+// ==========================================
+// Exact Battle Solver
+// ==========================================
+// Treats a battle played by the greedy AI (runHeadlessBattle's policy) as a
+// Markov chain over its snapshots. Each state is expanded by replaying its
+// turn under a DrawScript that walks every outcome of every RNG draw the
+// turn makes, weighting each with its exact probability. States are
+// hash-consed on their BattleState with initiatives taken relative to the
+// next actor, so the same position reached at different times is one state.
+// Each BFS level is expanded in parallel on per-worker battle clones; the
+// resulting absorbing chain is then solved for the chance of each outcome.
+struct SolverConfig {
+    long long maxStates = 2000000;      // Past this, estimate by sampling instead
+    int threads = 0;                    // 0 = one per hardware thread
+    double tolerance = 1e-12;           // Largest change that ends the solve
+    int maxSweeps = 100000;             // Past this, the solve is reported as unconverged
+    long long fallbackBattles = 20000;  // Sampled battles when the cap is hit
+    uint64_t seed = 0;                  // Fallback RNG seed; stream i = battle i
+};
+
+struct SolverResult {
+    bool exact = false;         // False when the state cap forced sampling or
+                                // maxSweeps ran out before reaching tolerance
+    double goodWins = 0.0;
+    double badWins = 0.0;
+    double draws = 0.0;
+    double unresolved = 0.0;    // Never ends (exact) or hit the turn cap (sampled)
+
+    long long states = 0;
+    long long transitions = 0;
+    long long turnsPlayed = 0;  // Turn replays, one per draw sequence explored
+    int depth = 0;              // BFS levels expanded
+    int sweeps = 0;
+    double residual = 0.0;      // Largest change in the final sweep
+    long long sampledBattles = 0;
+    double seconds = 0.0;
+
+    void print() const;
+};
+
+// Solves `battle` from its current state. The battle itself is not touched.
+SolverResult solveBattle(const Battle& battle, const SolverConfig& config = SolverConfig());
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef BATTLE_STATE_H
+#define BATTLE_STATE_H
+
+#include <vector>
+#include "rpg_system.h"
+
+// ==========================================
+// BattleState: pointer-free snapshot of a fight
+// ==========================================
+// Everything that changes while a battle is played: unit rows (statuses
+// included), turn order, RNG position, grid occupancy and item counts. Units
+// are referred to by participant slot, so a state can be restored into the
+// battle it came from or into any battle built the same way. Saving into a
+// state that already holds a snapshot of that battle reuses its storage.
+struct BattleState {
+    CombatantStore units;
+    std::vector<int> schedulePos;       // Initiative heap index per slot, -1 = unscheduled
+    BattleRng rng;
+
+    std::vector<int> cells;             // Occupant slot per grid cell (row-major), -1 = empty
+    std::vector<int> occupants;         // Slots standing on the grid, in placement order
+
+    std::vector<int> itemQuantities;    // Every inventory back to back, in slot order
+};
+
+#endif
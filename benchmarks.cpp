@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rpg_system.h"
+#include "battle_file.h"
+#include "battle_solver.h"
+#include "damage_model.h"
+#include "pathfinding.h"
+#include "scenario.h"
+#include "simulation.h"
+#include "turn_driver.h"
+
+// ==========================================
+// Benchmark Suite
+// ==========================================
+// Times the engine's hot calls in isolation and whole battles end to end,
+// then writes one JSON document so runs can be diffed across commits.
+// Each fixture is built once with units too tough to fall quickly, and is
+// rewound to its opening snapshot whenever HP or initiative drift too far,
+// so any measurement length leaves the fixture playable.
+
+namespace {
+
+const int ENDLESS = 1000000000;
+
+struct BenchResult {
+    std::string name;
+    long long iterations = 0;
+    double seconds = 0.0;
+
+    double nsPerOp() const { return iterations > 0 ? seconds * 1e9 / iterations : 0.0; }
+    double opsPerSecond() const { return seconds > 0.0 ? iterations / seconds : 0.0; }
+};
+
+struct BenchOptions {
+    double seconds = 0.5;
+    std::string filter;
+};
+
+// Runs `body` in batches until `seconds` have passed, reading the clock once
+// per batch.
+template <typename Body>
+BenchResult timeBench(const std::string& name, double seconds, int batch, Body&& body) {
+    BenchResult result;
+    result.name = name;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        for (int i = 0; i < batch; ++i) body();
+        result.iterations += batch;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (result.seconds < seconds);
+    return result;
+}
+
+// One attacker swinging at one adjacent target.
+BenchResult benchAttack(const BenchOptions& options) {
+    Battle battle(4, 4);
+    Combatant* attacker = battle.spawn("Attacker", "Good Guys", ENDLESS, 0, 5, 100);
+    Combatant* target = battle.spawn("Target", "Bad Guys", ENDLESS, 0, 6, 100);
+    attacker->equipWeapon(Weapon("Bench Blade", 40, 0.9f, 1.5f, 2, "Standard"));
+    battle.grid.placeCombatant(attacker, 1, 1);
+    battle.grid.placeCombatant(target, 2, 1);
+    BattleRng& rng = battle.manager.getRng();
+    BattleState opening;
+    battle.saveState(opening);
+    return timeBench("combatant_attack", options.seconds, 1024, [&]() {
+        attacker->attack(*target, battle.grid, rng);
+        if (target->getHP() < ENDLESS / 2) battle.restoreState(opening);
+    });
+}
+
+// A radius-2 fireball into a side x side grid holding a unit on every
+// other cell of every other row, so a quarter of the cells are occupied.
+BenchResult benchCastSpell(const BenchOptions& options, int side) {
+    Battle battle(side, side);
+    Combatant* caster = nullptr;
+    Combatant* target = nullptr;
+    for (int y = 0; y < side; y += 2) {
+        for (int x = 0; x < side; x += 2) {
+            bool isCaster = caster == nullptr;
+            Combatant* c = battle.spawn(isCaster ? "Caster" : "Dummy", isCaster ? "Good Guys" : "Bad Guys",
+                ENDLESS, ENDLESS, 5, 100);
+            battle.grid.placeCombatant(c, x, y);
+            if (isCaster) caster = c;
+        }
+    }
+    caster->learnSpell(Spell("Bench Blast", 64, 1, 15.0f, 0, "Fire", 2, "Debuff"));
+    target = battle.grid.getCombatantAt(4, 4);
+    BattleState opening;
+    battle.saveState(opening);
+    return timeBench("cast_spell_aoe/" + std::to_string(side), options.seconds, 256, [&]() {
+        caster->castSpell(*target, 0, battle.grid);
+        if (target->getHP() < ENDLESS / 2) battle.restoreState(opening);
+    });
+}
+
+// A unit carrying a full status list, none of which expire or hurt, so
+// every tick walks all of them.
+BenchResult benchAddTicks(const BenchOptions& options) {
+    Battle battle(2, 2);
+    Combatant* unit = battle.spawn("Sufferer", "Good Guys", ENDLESS, 0, 5, 100);
+    for (int i = 0; i < StatusList::CAPACITY; ++i) {
+        unit->applyStatus(i % 2 == 0 ? StatusType::Burn : StatusType::Acid, ENDLESS - i, 0);
+    }
+    BattleState opening;
+    battle.saveState(opening);
+    return timeBench("add_ticks/" + std::to_string(StatusList::CAPACITY) + "_statuses", options.seconds, 1024, [&]() {
+        unit->addTicks(1);
+        if (unit->getInitiative() > ENDLESS) battle.restoreState(opening);
+    });
+}
+
+// One unit pacing between two cells next to a stationary enemy.
+BenchResult benchMoveCombatant(const BenchOptions& options) {
+    Battle battle(8, 8);
+    Combatant* walker = battle.spawn("Walker", "Good Guys", ENDLESS, 0, 5, 100);
+    Combatant* watcher = battle.spawn("Watcher", "Bad Guys", ENDLESS, 0, 5, 100);
+    battle.grid.placeCombatant(walker, 3, 3);
+    battle.grid.placeCombatant(watcher, 3, 4);
+    int step = 1;
+    return timeBench("grid_move_combatant", options.seconds, 1024, [&]() {
+        battle.grid.moveCombatant(walker, step, 0);
+        step = -step;
+    });
+}
+
+// Picks the next actor among `units` participants and charges it a random
+// action's cost, so the schedule keeps churning. Initiatives start repeating
+// every three units, as in the skirmish scenario, so ties are resolved too.
+BenchResult benchNextActive(const BenchOptions& options, int units) {
+    int side = 2;
+    while (side * side < units) side++;
+    Battle battle(side, side);
+    for (int i = 0; i < units; ++i) {
+        Combatant* c = battle.spawn("Unit " + std::to_string(i), i % 2 == 0 ? "Good Guys" : "Bad Guys",
+            ENDLESS, 0, 5 + i % 3, 100);
+        battle.grid.placeCombatant(c, i % side, i / side);
+    }
+    BattleState opening;
+    battle.saveState(opening);
+    return timeBench("next_active_combatant/" + std::to_string(units), options.seconds, 256, [&]() {
+        Combatant* actor = battle.manager.getNextActiveCombatant();
+        actor->addTicks(battle.manager.getRng().nextInt(COST_MOVE_BASE, COST_ATTACK));
+        if (actor->getInitiative() > ENDLESS) battle.restoreState(opening);
+    });
+}
+
+// Whole default-scenario battles on one worker, arena and all.
+BenchResult benchBattles(const BenchOptions& options) {
+    const long long perRun = 256;
+    uint64_t seed = 0;
+    BenchResult result = timeBench("battles_default_scenario", options.seconds, 1,
+        [&]() { runSimulation(perRun, 1, seed++); });
+    result.iterations *= perRun;
+    return result;
+}
+
+// Exact damage distribution of a two-swing acid weapon: computed from
+// scratch each time, or looked up in a warm calculator.
+BenchResult benchDamagePmf(const BenchOptions& options, bool cached) {
+    Battle battle(4, 4);
+    Combatant* attacker = battle.spawn("Attacker", "Good Guys", ENDLESS, 0, 5, 100);
+    Combatant* target = battle.spawn("Target", "Bad Guys", ENDLESS, 0, 6, 100);
+    attacker->equipWeapon(Weapon("Bench Acid Bow", 40, 0.9f, 9.0f, 2, "Acid"));
+    target->equipArmor(Armor("Bench Plate", 30, 5, 0.1f, "Standard", 10));
+    DamageCalculator warm;
+    double sink = 0.0;
+    BenchResult result = timeBench(cached ? "damage_pmf/cached" : "damage_pmf/cold", options.seconds, 256, [&]() {
+        if (cached) {
+            sink += warm.attackDamage(*attacker, *target).mean();
+        }
+        else {
+            DamageCalculator fresh;
+            sink += fresh.attackDamage(*attacker, *target).mean();
+        }
+    });
+    if (sink < 0.0) std::cerr << sink;     // Keeps the work observable
+    return result;
+}
+
+// `count` default-scenario battles whose human turns all wait on one
+// thread; each op answers whichever battle is next in line, round-robin.
+// Finished battles are rewound and replayed with a new seed.
+BenchResult benchTurnDriver(const BenchOptions& options, int count) {
+    static const int ANSWERS[] = { 1, 1, 3, 1, 2, 4, 1, 1, 3, 3 };
+    const int answerCount = static_cast<int>(sizeof(ANSWERS) / sizeof(ANSWERS[0]));
+    struct Hosted {
+        std::unique_ptr<Battle> battle;
+        BattleState opening;
+        TurnInput input;
+        Task<std::string> game;
+        int next = 0;
+    };
+    std::ostream quiet(nullptr);
+    std::vector<Hosted> hosted(count);
+    uint64_t seed = 0;
+    auto begin = [&](Hosted& h) {
+        h.battle->restoreState(h.opening);
+        h.battle->manager.getRng().reseed(seed++, 0);
+        h.game = playBattle(*h.battle, h.input, quiet, "bench.rpgs");
+        h.game.start();
+    };
+    for (Hosted& h : hosted) {
+        h.battle = buildDefaultScenario();
+        h.battle->saveState(h.opening);
+        begin(h);
+    }
+    size_t turn = 0;
+    return timeBench("turn_driver/" + std::to_string(count), options.seconds, 256, [&]() {
+        Hosted& h = hosted[turn++ % hosted.size()];
+        if (h.game.done()) begin(h);
+        h.input.provide(ANSWERS[h.next++ % answerCount]);
+    });
+}
+
+// ==========================================
+// Model Verification
+// ==========================================
+// --verify checks the exact models against the engine they describe: the
+// mean of each DamageCalculator distribution against that many real attacks,
+// and solveBattle's win chance on a small duel against a seeded
+// runSimulation of the same duel. Both are seeded, so a run is reproducible;
+// an estimate passes when it lies within MAX_STANDARD_ERRORS of the exact
+// value. It also checks the Pathfinder's incrementally patched distance
+// fields against fresh rebuilds and against findPath.
+
+const double MAX_STANDARD_ERRORS = 5.0;
+
+bool withinBound(const std::string& name, double exact, double sampled, double standardError) {
+    double errors = standardError > 0.0 ? std::fabs(sampled - exact) / standardError : 0.0;
+    bool pass = standardError > 0.0 ? errors <= MAX_STANDARD_ERRORS : std::fabs(sampled - exact) < 1e-9;
+    std::cout << (pass ? "[PASS] " : "[FAIL] ") << name << ": exact " << exact << ", sampled " << sampled
+        << " (" << errors << " standard errors)\n";
+    return pass;
+}
+
+// `attacks` swings of `weapon` at an unkillable target in `armor`, each from
+// the same opening so statuses left by one attack never reach the next.
+bool verifyAttackDamage(const std::string& name, const Weapon& weapon, const Armor& armor, bool guarding, long long attacks) {
+    Battle battle(4, 4);
+    Combatant* attacker = battle.spawn("Attacker", "Good Guys", ENDLESS, 0, 5, 100);
+    Combatant* target = battle.spawn("Target", "Bad Guys", ENDLESS, 0, 6, 100);
+    attacker->equipWeapon(weapon);
+    target->equipArmor(armor);
+    battle.grid.placeCombatant(attacker, 1, 1);
+    battle.grid.placeCombatant(target, 2, 1);
+    if (guarding) target->guard();
+    BattleState opening;
+    battle.saveState(opening);
+
+    DamageCalculator calculator;
+    double exact = calculator.attackDamage(*attacker, *target).mean();
+
+    BattleRng& rng = battle.manager.getRng();
+    rng.reseed(0, 0);
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for (long long i = 0; i < attacks; ++i) {
+        attacker->attack(*target, battle.grid, rng);
+        double damage = ENDLESS - target->getHP();
+        sum += damage;
+        sumSquares += damage * damage;
+        BattleRng position = rng;
+        battle.restoreState(opening);
+        rng = position;
+    }
+    double mean = sum / attacks;
+    double variance = std::max(sumSquares / attacks - mean * mean, 0.0);
+    return withinBound("damage_pmf/" + name + " mean", exact, mean, std::sqrt(variance / attacks));
+}
+
+// Two single-cell duelists trading blows until one falls; the fire blade
+// leaves burns, so status ticks are part of the chain.
+std::unique_ptr<Battle> buildVerifyDuel() {
+    auto battle = std::make_unique<Battle>(2, 1);
+    Combatant* duelist = battle->spawn("Duelist", "Good Guys", 60, 0, 5, 100);
+    Combatant* brute = battle->spawn("Brute", "Bad Guys", 60, 0, 6, 100);
+    duelist->equipWeapon(Weapon("Verify Fire Blade", 30, 0.8f, 1.5f, 1, "Fire"));
+    duelist->equipArmor(Armor("Verify Mail", 20, 3, 0.1f, "Standard", 0));
+    brute->equipWeapon(Weapon("Verify Club", 45, 0.7f, 1.5f, 1, "Standard"));
+    brute->equipArmor(Armor("Verify Hide", 10, 2, 0.05f, "Standard", 0));
+    battle->grid.placeCombatant(duelist, 0, 0);
+    battle->grid.placeCombatant(brute, 1, 0);
+    return battle;
+}
+
+bool verifySolver(long long battles) {
+    auto duel = buildVerifyDuel();
+    SolverResult solved = solveBattle(*duel);
+    if (!solved.exact) {
+        std::cout << "[FAIL] solver/duel: " << (solved.sampledBattles > 0 ? "state cap reached" : "sweep limit reached")
+            << ", no exact answer\n";
+        return false;
+    }
+
+    // runSimulation takes scenarios as battle files.
+    std::vector<uint8_t> bytes;
+    encodeBattleFile(*duel, bytes);
+    std::vector<uint64_t> aligned((bytes.size() + 7) / 8);
+    std::memcpy(aligned.data(), bytes.data(), bytes.size());
+    BattleFileView view;
+    if (!view.open(reinterpret_cast<const uint8_t*>(aligned.data()), bytes.size())) {
+        std::cout << "[FAIL] solver/duel: cannot reopen the encoded duel\n";
+        return false;
+    }
+    SimulationResult simulated = runSimulation(battles, 0, 0, &view);
+    double p = solved.goodWins;
+    double sampled = static_cast<double>(simulated.goodWins) / simulated.battles;
+    return withinBound("solver/duel good wins", p, sampled, std::sqrt(p * (1.0 - p) / simulated.battles));
+}
+
+bool reportCount(const std::string& name, long long checked, long long mismatches, const char* what) {
+    bool pass = mismatches == 0 && checked > 0;
+    std::cout << (pass ? "[PASS] " : "[FAIL] ") << name << ": " << mismatches << " of " << checked << " " << what
+        << " disagree\n";
+    return pass;
+}
+
+// Both teams' distance fields after every turn of seeded skirmishes (walls,
+// rough ground and water included), as patched by the grid's Pathfinder,
+// against the same fields built from scratch by a fresh one.
+bool verifyDistanceFields(int battles) {
+    const int goodTeam = internTeam("Good Guys");
+    const int badTeam = internTeam("Bad Guys");
+    long long fields = 0;
+    long long mismatches = 0;
+    for (int b = 0; b < battles; ++b) {
+        auto battle = buildSkirmishScenario(8);
+        battle->manager.getRng().reseed(0, static_cast<uint64_t>(b));
+        for (int turn = 0; turn < 2000; ++turn) {
+            if (runHeadlessBattle(*battle, 1) != "Stalemate") break;
+            for (int team : { goodTeam, badTeam }) {
+                const std::pmr::vector<int>& patched = battle->grid.getPathfinder().distanceToTeam(team);
+                Pathfinder fresh(battle->grid);
+                if (fresh.distanceToTeam(team) != patched) mismatches++;
+                fields++;
+            }
+        }
+    }
+    return reportCount("pathfinding/patched fields", fields, mismatches, "fields");
+}
+
+// On random terrain holding one unit, findPath from every passable cell to
+// that unit must cost exactly the unit's distance field there (or fail where
+// the field is UNREACHABLE), along a path of adjacent steps whose enter costs
+// add up to that cost.
+bool verifyFindPath(int grids) {
+    const int side = 16;
+    static const Terrain TERRAINS[] = { Terrain::Open, Terrain::Open, Terrain::Rough, Terrain::Forest,
+        Terrain::Water, Terrain::Wall };
+    const int terrainCount = static_cast<int>(sizeof(TERRAINS) / sizeof(TERRAINS[0]));
+    BattleRng rng(0, 0);
+    std::vector<std::pair<int, int>> path;
+    long long routes = 0;
+    long long mismatches = 0;
+    for (int g = 0; g < grids; ++g) {
+        Battle battle(side, side);
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) battle.grid.setTerrain(x, y, TERRAINS[rng.nextInt(0, terrainCount - 1)]);
+        }
+        int gx = rng.nextInt(0, side - 1);
+        int gy = rng.nextInt(0, side - 1);
+        battle.grid.setTerrain(gx, gy, Terrain::Open);
+        Combatant* goal = battle.spawn("Goal", "Bad Guys", 100, 0, 5, 100);
+        battle.grid.placeCombatant(goal, gx, gy);
+
+        Pathfinder& paths = battle.grid.getPathfinder();
+        const std::pmr::vector<int>& field = paths.distanceToTeam(goal->getTeamId());
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                if ((x == gx && y == gy) || battle.grid.getEnterCost(x, y) < 0) continue;
+                routes++;
+                int cost = paths.findPath(x, y, gx, gy, path);
+                int expected = field[y * side + x];
+                bool agree = expected == Pathfinder::UNREACHABLE ? cost == -1 : cost == expected;
+                if (agree && cost >= 0) {
+                    int walked = 0;
+                    int px = x;
+                    int py = y;
+                    for (const auto& step : path) {
+                        if (std::abs(step.first - px) + std::abs(step.second - py) != 1) agree = false;
+                        walked += battle.grid.getEnterCost(step.first, step.second);
+                        px = step.first;
+                        py = step.second;
+                    }
+                    agree = agree && walked == cost && px == gx && py == gy;
+                }
+                if (!agree) mismatches++;
+            }
+        }
+    }
+    return reportCount("pathfinding/findPath vs field", routes, mismatches, "routes");
+}
+
+bool runVerification() {
+    const long long attacks = 200000;
+    Armor plate("Verify Plate", 30, 5, 0.1f, "Standard", 10);
+    bool pass = verifyAttackDamage("sword", Weapon("Verify Sword", 40, 0.9f, 1.5f, 1, "Standard"), plate, false, attacks);
+    pass &= verifyAttackDamage("acid_bow", Weapon("Verify Acid Bow", 40, 0.9f, 9.0f, 2, "Acid"), plate, false, attacks);
+    pass &= verifyAttackDamage("fire_axe_guarded", Weapon("Verify Fire Axe", 55, 0.75f, 1.5f, 3, "Fire"),
+        Armor("Verify Frost Mail", 15, 2, 0.05f, "Ice", 0), true, attacks);
+    pass &= verifySolver(200000);
+    pass &= verifyDistanceFields(40);
+    pass &= verifyFindPath(200);
+    std::cout << (pass ? "All models agree with the engine\n" : "Model verification failed\n");
+    return pass;
+}
+
+bool selected(const BenchOptions& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<BenchResult>& results) {
+    out << "{\n  \"min_seconds\": " << options.seconds << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"seconds\": " << r.seconds << ", \"ns_per_op\": " << r.nsPerOp()
+            << ", \"ops_per_second\": " << r.opsPerSecond() << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void printUsage() {
+    std::cout << "Usage: RPGCombatBench [--seconds <min per benchmark>] [--filter <name part>] [--out <file>]\n"
+        << "       RPGCombatBench --verify\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string outPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) options.seconds = std::atof(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc) options.filter = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (arg == "--verify") return runVerification() ? 0 : 1;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    auto run = [&](const std::string& name, auto&& bench) {
+        if (selected(options, name)) results.push_back(bench());
+    };
+    run("combatant_attack", [&]() { return benchAttack(options); });
+    for (int side : { 16, 64, 256 }) {
+        run("cast_spell_aoe/" + std::to_string(side), [&]() { return benchCastSpell(options, side); });
+    }
+    run("add_ticks", [&]() { return benchAddTicks(options); });
+    run("grid_move_combatant", [&]() { return benchMoveCombatant(options); });
+    for (int units : { 4, 64, 4096 }) {
+        run("next_active_combatant/" + std::to_string(units), [&]() { return benchNextActive(options, units); });
+    }
+    run("damage_pmf/cold", [&]() { return benchDamagePmf(options, false); });
+    run("damage_pmf/cached", [&]() { return benchDamagePmf(options, true); });
+    run("turn_driver/1024", [&]() { return benchTurnDriver(options, 1024); });
+    run("battles_default_scenario", [&]() { return benchBattles(options); });
+
+    if (outPath.empty()) {
+        writeJson(std::cout, options, results);
+        return 0;
+    }
+    std::ofstream file(outPath);
+    if (!file) {
+        std::cerr << "Cannot write " << outPath << "\n";
+        return 1;
+    }
+    writeJson(file, options, results);
+    return 0;
+}
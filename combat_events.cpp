@@ -0,0 +1,167 @@
+#include "combat_events.h"
+#include "rpg_system.h"
+#include "varint.h"
+#include <ostream>
+
+// ==========================================
+// Text Sink
+// ==========================================
+TextEventSink::TextEventSink(std::ostream& os) : out(os) {}
+
+void TextEventSink::onEvent(const CombatEvent& e) {
+    const Combatant* a = e.actor;
+    const Combatant* t = e.target;
+    EventSource source = static_cast<EventSource>(e.detail);
+
+    switch (e.type) {
+    case CombatEventType::GuardDropped:
+        out << " >> " << a->getName() << " drops their guard.\n";
+        break;
+    case CombatEventType::Guarded:
+        out << " >> " << a->getName() << " enters Guard Stance! (+100 DR)\n";
+        break;
+    case CombatEventType::AttackDeclared:
+        out << a->getName() << " attacks " << t->getName() << " with " << a->getWeapon().name
+            << " (" << elementName(a->getWeapon().element) << ")!\n";
+        break;
+    case CombatEventType::AttackMissed:
+        out << " - Attack " << e.value << " MISSED!\n";
+        break;
+    case CombatEventType::CriticalHit:
+        out << " - CRITICAL HIT! ";
+        break;
+    case CombatEventType::Weakness:
+        out << (source == EventSource::Spell ? "(Weakness) " : "(Weakness Hit!) ");
+        break;
+    case CombatEventType::Resisted:
+        out << "(Resisted) ";
+        break;
+    case CombatEventType::IceChill:
+        if (source == EventSource::Spell) out << "Ice chills! (+" << e.value << " Init Ticks) ";
+        else out << " >> Ice chills " << t->getName() << "! (+" << e.value << " Init Ticks)\n";
+        break;
+    case CombatEventType::BioLeech:
+        out << (source == EventSource::Spell ? "Bio-leech! " : " >> Bio-leech absorbs health!\n");
+        break;
+    case CombatEventType::SpellCast: {
+        const Spell& spell = a->getSpell(e.value);
+        out << a->getName() << " casts " << spell.name << " (" << elementName(spell.element) << ")!\n";
+        break;
+    }
+    case CombatEventType::SpellHit:
+        out << "  -> Hit " << t->getName() << ": ";
+        break;
+    case CombatEventType::ItemUsed:
+        out << a->getName() << " uses " << a->getItem(e.value).name << " on " << t->getName() << "!\n";
+        break;
+    case CombatEventType::ItemBuffed:
+        out << " >> " << t->getName() << " is Buffed!\n";
+        break;
+    case CombatEventType::ItemDebuffed:
+        out << " >> " << t->getName() << " is Debuffed!\n";
+        break;
+    case CombatEventType::OutOfRange:
+        out << " >> Target out of range for "
+            << (source == EventSource::Spell ? "spell" : source == EventSource::Item ? "item" : "attack") << "!\n";
+        break;
+    case CombatEventType::NotEnoughMP:
+        out << " >> Not enough MP! (Cost: " << e.value << ", Have: " << e.extra << ")\n";
+        break;
+    case CombatEventType::NotEnoughItems:
+        out << " >> Not enough items!\n";
+        break;
+    case CombatEventType::InvalidSpell:
+        out << "Invalid spell selection.\n";
+        break;
+    case CombatEventType::DamageTaken:
+        out << " >> " << a->getName() << " takes " << e.value << " damage! (HP: " << e.extra << "/" << a->getMaxHP() << ")\n";
+        break;
+    case CombatEventType::PsiStrike:
+        out << " >> Psi attack strikes the mind!\n";
+        break;
+    case CombatEventType::PoisonReflect:
+        out << " >> Poison Armor spews toxins! Reflecting " << e.value << " damage!\n";
+        break;
+    case CombatEventType::Defeated:
+        out << " >> " << a->getName() << " has been defeated!\n";
+        break;
+    case CombatEventType::Healed:
+        out << " >> " << a->getName() << " recovers " << e.value << " HP! (HP: " << e.extra << "/" << a->getMaxHP() << ")\n";
+        break;
+    case CombatEventType::MPDrained:
+        out << " >> " << a->getName() << " loses " << e.value << " MP! (MP: " << e.extra << ")\n";
+        break;
+    case CombatEventType::MPRestored:
+        out << " >> " << a->getName() << " restores " << e.value << " MP! (MP: " << e.extra << "/" << a->getMaxMP() << ")\n";
+        break;
+    case CombatEventType::MoraleBroken:
+        out << " >> " << a->getName() << " is MENTALLY BROKEN! (Morale: " << e.extra << ")\n";
+        break;
+    case CombatEventType::MoraleRegained:
+        out << " >> " << a->getName() << " regains " << e.value << " Morale. (Current: " << e.extra << ")\n";
+        break;
+    case CombatEventType::StatusApplied:
+        out << " >> " << a->getName() << " is affected by " << statusName(static_cast<StatusType>(e.detail))
+            << "! (" << e.value << " ticks)\n";
+        break;
+    case CombatEventType::StatusExpired:
+        if (static_cast<StatusType>(e.detail) == StatusType::Burn) out << " >> " << a->getName() << "'s burns fade.\n";
+        else out << " >> Acid drips off " << a->getName() << "'s armor.\n";
+        break;
+    case CombatEventType::Succumbed:
+        out << " >> " << a->getName() << " succumbed to damage!\n";
+        break;
+    case CombatEventType::Moved:
+        out << "[Movement] " << a->getName() << " moved to (" << a->getX() << "," << a->getY() << "). "
+            << (e.extra ? "(Engaged move: +" : "(Standard move: +") << e.value << " ticks)\n";
+        break;
+    case CombatEventType::MoveBlocked:
+        out << "[Movement] Blocked (Occupied by " << t->getName() << ")\n";
+        break;
+    case CombatEventType::Fled:
+        out << " >> " << a->getName() << " runs off the battlefield!\n";
+        break;
+    case CombatEventType::InitiativeTie:
+        out << "[Info] Tie detected for Initiative " << e.value << ". Randomly resolving...\n";
+        break;
+    case CombatEventType::AIThinking:
+        out << "(AI Thinking...)\n";
+        break;
+    case CombatEventType::AIWaiting:
+        out << " >> AI has no targets. Waiting.\n";
+        break;
+    case CombatEventType::AIMoving:
+        out << (source == EventSource::Spell ? " >> AI moving to spell range...\n" : " >> AI moving to attack...\n");
+        break;
+    case CombatEventType::Panicked:
+        out << " >> " << a->getName() << " is BROKEN and panics!\n";
+        break;
+    case CombatEventType::MoveImpassable:
+        out << "[Movement] Blocked (Impassable terrain at " << e.value << "," << e.extra << ")\n";
+        break;
+    }
+}
+
+// ==========================================
+// Binary Sink
+// ==========================================
+BinaryEventSink::BinaryEventSink(std::vector<uint8_t>& buffer) : out(buffer) {}
+
+void BinaryEventSink::registerCombatant(const Combatant* c) {
+    ids.emplace(c, static_cast<uint32_t>(ids.size() + 1));
+}
+
+uint32_t BinaryEventSink::idOf(const Combatant* c) const {
+    if (!c) return 0;
+    auto it = ids.find(c);
+    return it != ids.end() ? it->second : 0;
+}
+
+void BinaryEventSink::onEvent(const CombatEvent& e) {
+    out.push_back(static_cast<uint8_t>(e.type));
+    out.push_back(e.detail);
+    writeVarint(out, idOf(e.actor));
+    writeVarint(out, idOf(e.target));
+    writeSignedVarint(out, e.value);
+    writeSignedVarint(out, e.extra);
+}
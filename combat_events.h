@@ -0,0 +1,133 @@
+#ifndef COMBAT_EVENTS_H
+#define COMBAT_EVENTS_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <unordered_map>
+#include <vector>
+
+class Combatant;
+
+// ==========================================
+// Combat Events
+// ==========================================
+// The engine reports everything that happens in a fight as typed events instead
+// of writing text. Which fields are meaningful depends on the type; see the
+// TextEventSink for how each one is narrated.
+enum class CombatEventType : uint8_t {
+    GuardDropped,       // actor
+    Guarded,            // actor
+    AttackDeclared,     // actor -> target
+    AttackMissed,       // actor -> target, value = swing number (1-based)
+    CriticalHit,        // actor -> target
+    Weakness,           // actor -> target, detail = EventSource
+    Resisted,           // actor -> target, detail = EventSource
+    IceChill,           // actor -> target, value = ticks added, detail = EventSource
+    BioLeech,           // actor -> target, detail = EventSource
+    SpellCast,          // actor -> target, value = spell index
+    SpellHit,           // actor -> target (one AoE victim)
+    ItemUsed,           // actor -> target, value = item index
+    ItemBuffed,         // actor -> target
+    ItemDebuffed,       // actor -> target
+    OutOfRange,         // actor -> target, detail = EventSource
+    NotEnoughMP,        // actor, value = cost, extra = MP available
+    NotEnoughItems,     // actor, value = item index
+    InvalidSpell,       // actor, value = spell index
+    DamageTaken,        // actor, value = amount, extra = HP after, detail = Element
+    PsiStrike,          // actor
+    PoisonReflect,      // actor, value = reflected amount
+    Defeated,           // actor
+    Healed,             // actor, value = amount, extra = HP after
+    MPDrained,          // actor, value = amount, extra = MP after
+    MPRestored,         // actor, value = amount, extra = MP after
+    MoraleBroken,       // actor, extra = morale after
+    MoraleRegained,     // actor, value = amount, extra = morale after
+    StatusApplied,      // actor, detail = StatusType, value = duration, extra = potency
+    StatusExpired,      // actor, detail = StatusType
+    Succumbed,          // actor
+    Moved,              // actor, value = tick cost, extra = 1 if engaged
+    MoveBlocked,        // actor, target = occupant
+    Fled,               // actor
+    InitiativeTie,      // value = initiative
+    AIThinking,         // actor
+    AIWaiting,          // actor
+    AIMoving,           // actor, detail = EventSource of the intended action
+    Panicked,           // actor
+    MoveImpassable      // actor, value = target x, extra = target y
+};
+
+enum class EventSource : uint8_t { Attack, Spell, Item };
+
+struct CombatEvent {
+    CombatEventType type;
+    uint8_t detail;
+    const Combatant* actor;
+    const Combatant* target;
+    int value;
+    int extra;
+};
+
+// ==========================================
+// Sinks
+// ==========================================
+class CombatEventSink {
+public:
+    virtual ~CombatEventSink() = default;
+    virtual void onEvent(const CombatEvent& event) = 0;
+
+    // Sinks that drop every event report true; the engine then detaches them
+    // so no event is ever built for them.
+    virtual bool discardsEvents() const { return false; }
+};
+
+// Discards everything. Attaching it is equivalent to attaching no sink; build
+// with RPG_NO_COMBAT_EVENTS to remove event emission from the engine entirely.
+class NullEventSink final : public CombatEventSink {
+public:
+    void onEvent(const CombatEvent&) override {}
+    bool discardsEvents() const override { return true; }
+};
+
+// Narrates events exactly as the console game always has.
+class TextEventSink : public CombatEventSink {
+private:
+    std::ostream& out;
+
+public:
+    explicit TextEventSink(std::ostream& os);
+    void onEvent(const CombatEvent& event) override;
+};
+
+// Appends each event as a compact varint-encoded record:
+// type, detail, actor id, target id, zigzag(value), zigzag(extra).
+// Combatant ids are 1-based registration order; 0 means "none".
+class BinaryEventSink : public CombatEventSink {
+private:
+    std::vector<uint8_t>& out;
+    std::unordered_map<const Combatant*, uint32_t> ids;
+
+    uint32_t idOf(const Combatant* c) const;
+
+public:
+    explicit BinaryEventSink(std::vector<uint8_t>& buffer);
+    void registerCombatant(const Combatant* c);
+    void onEvent(const CombatEvent& event) override;
+};
+
+// ==========================================
+// Emission Helper
+// ==========================================
+inline CombatEventSink* normalizeSink(CombatEventSink* sink) {
+    return (sink && !sink->discardsEvents()) ? sink : nullptr;
+}
+
+inline void emitEvent(CombatEventSink* sink, CombatEventType type, const Combatant* actor,
+    const Combatant* target = nullptr, int value = 0, int extra = 0, uint8_t detail = 0) {
+#ifndef RPG_NO_COMBAT_EVENTS
+    if (sink) sink->onEvent(CombatEvent{ type, detail, actor, target, value, extra });
+#else
+    (void)sink; (void)type; (void)actor; (void)target; (void)value; (void)extra; (void)detail;
+#endif
+}
+
+#endif
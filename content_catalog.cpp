@@ -0,0 +1,312 @@
+#include "content_catalog.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+template <typename T>
+void appendBytes(std::string& key, const T& value) {
+    char raw[sizeof(T)];
+    std::memcpy(raw, &value, sizeof(T));
+    key.append(raw, sizeof(T));
+}
+
+// Byte-exact identity of a definition, for interning by value.
+std::string keyOf(const Weapon& w) {
+    std::string key = w.name;
+    key.push_back('\0');
+    appendBytes(key, w.physicalAttack);
+    appendBytes(key, w.accuracy);
+    appendBytes(key, w.range);
+    appendBytes(key, w.numberOfAttacks);
+    appendBytes(key, w.element);
+    return key;
+}
+
+std::string keyOf(const Armor& a) {
+    std::string key = a.name;
+    key.push_back('\0');
+    appendBytes(key, a.damageResistance);
+    appendBytes(key, a.damageThreshold);
+    appendBytes(key, a.evasion);
+    appendBytes(key, a.element);
+    appendBytes(key, a.magicalDefense);
+    return key;
+}
+
+std::string keyOf(const Spell& s) {
+    std::string key = s.name;
+    key.push_back('\0');
+    appendBytes(key, s.magicalAttack);
+    appendBytes(key, s.mpCost);
+    appendBytes(key, s.range);
+    appendBytes(key, s.duration);
+    appendBytes(key, s.element);
+    appendBytes(key, s.aoe);
+    appendBytes(key, s.category);
+    return key;
+}
+
+std::string keyOf(const Item& item) {
+    std::string key = item.name;
+    key.push_back('\0');
+    appendBytes(key, item.range);
+    appendBytes(key, item.category);
+    appendBytes(key, item.potency);
+    return key;
+}
+
+} // namespace
+
+bool tokenizeContentLine(const std::string& line, std::vector<std::string>& words, std::string& error) {
+    words.clear();
+    size_t i = 0;
+    while (i < line.size()) {
+        char c = line[i];
+        if (c == '#') break;
+        if (c == ' ' || c == '\t' || c == '\r') {
+            ++i;
+            continue;
+        }
+        std::string word;
+        if (c == '"') {
+            size_t close = line.find('"', i + 1);
+            if (close == std::string::npos) {
+                error = "unterminated quote";
+                return false;
+            }
+            word = line.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        else {
+            while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r' && line[i] != '#') word.push_back(line[i++]);
+        }
+        words.push_back(word);
+    }
+    return true;
+}
+
+namespace {
+
+bool parseInt(const std::string& text, int& out) {
+    char* end = nullptr;
+    long v = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+bool parseFloat(const std::string& text, float& out) {
+    char* end = nullptr;
+    float v = std::strtof(text.c_str(), &end);
+    if (text.empty() || *end != '\0') return false;
+    out = v;
+    return true;
+}
+
+// Names must match exactly; the *FromName helpers fall back silently.
+bool parseElement(const std::string& text, std::string& out) {
+    out = text;
+    return text == elementName(elementFromName(text));
+}
+
+} // namespace
+
+template <typename T>
+int ContentCatalog::Table<T>::find(const std::string& name) const {
+    auto it = byName.find(name);
+    return it == byName.end() ? -1 : it->second;
+}
+
+template <typename T>
+int ContentCatalog::Table<T>::intern(const T& value, const std::string& key) {
+    auto it = byValue.find(key);
+    if (it != byValue.end()) return it->second;
+    if (count == CONTENT_ID_LIMIT) {
+        std::cerr << "[Content] More than " << CONTENT_ID_LIMIT << " distinct definitions of one kind\n";
+        std::abort();
+    }
+    std::unique_ptr<std::vector<T>>& chunk = chunks[count >> CHUNK_BITS];
+    if (!chunk) {
+        chunk.reset(new std::vector<T>());
+        chunk->reserve(CHUNK_SIZE);
+    }
+    chunk->push_back(value);
+    int id = count++;
+    byValue.emplace(key, id);
+    byName.emplace(value.name, id);
+    return id;
+}
+
+ContentCatalog::ContentCatalog() {
+    intern(Weapon());
+    intern(Armor());
+}
+
+WeaponId ContentCatalog::intern(const Weapon& weapon) {
+    std::lock_guard<std::mutex> guard(lock);
+    return static_cast<WeaponId>(weapons.intern(weapon, keyOf(weapon)));
+}
+
+ArmorId ContentCatalog::intern(const Armor& armor) {
+    std::lock_guard<std::mutex> guard(lock);
+    return static_cast<ArmorId>(armors.intern(armor, keyOf(armor)));
+}
+
+SpellId ContentCatalog::intern(const Spell& spell) {
+    std::lock_guard<std::mutex> guard(lock);
+    return static_cast<SpellId>(spells.intern(spell, keyOf(spell)));
+}
+
+ItemId ContentCatalog::intern(const Item& item) {
+    std::lock_guard<std::mutex> guard(lock);
+    return static_cast<ItemId>(items.intern(item, keyOf(item)));
+}
+
+int ContentCatalog::weaponCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return weapons.size();
+}
+
+int ContentCatalog::armorCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return armors.size();
+}
+
+int ContentCatalog::spellCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return spells.size();
+}
+
+int ContentCatalog::itemCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return items.size();
+}
+
+int ContentCatalog::findWeapon(const std::string& name) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return weapons.find(name);
+}
+
+int ContentCatalog::findArmor(const std::string& name) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return armors.find(name);
+}
+
+int ContentCatalog::findSpell(const std::string& name) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return spells.find(name);
+}
+
+int ContentCatalog::findItem(const std::string& name) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return items.find(name);
+}
+
+// ==========================================
+// Content Files
+// ==========================================
+bool ContentCatalog::loadLine(const std::string& line, std::string& error) {
+    std::vector<std::string> words;
+    if (!tokenizeContentLine(line, words, error)) return false;
+    if (words.empty()) return true;
+    if (words.size() < 2) {
+        error = "expected a kind and a name";
+        return false;
+    }
+    const std::string& kind = words[0];
+    const std::string& name = words[1];
+
+    // Defaults match the unarmed / unarmoured entries.
+    int attack = (kind == "weapon") ? 1 : 0, hits = 1, cost = 0, duration = 0, aoe = 0, potency = 0;
+    int dr = 0, dt = 0, magdef = 0;
+    float accuracy = 1.0f, range = 1.0f, evasion = 0.0f;
+    std::string element = (kind == "armor") ? "Standard" : (kind == "spell") ? "None" : "Physical";
+    std::string category = (kind == "spell") ? "Debuff" : "None";
+
+    for (size_t i = 2; i < words.size(); ++i) {
+        size_t eq = words[i].find('=');
+        if (eq == std::string::npos) {
+            error = "expected key=value, got '" + words[i] + "'";
+            return false;
+        }
+        std::string key = words[i].substr(0, eq);
+        std::string value = words[i].substr(eq + 1);
+        bool ok;
+        if (key == "attack") ok = parseInt(value, attack);
+        else if (key == "hits" && kind == "weapon") ok = parseInt(value, hits);
+        else if (key == "accuracy" && kind == "weapon") ok = parseFloat(value, accuracy);
+        else if (key == "range" && kind != "armor") ok = parseFloat(value, range);
+        else if (key == "element" && kind != "item") ok = parseElement(value, element);
+        else if (key == "dr" && kind == "armor") ok = parseInt(value, dr);
+        else if (key == "dt" && kind == "armor") ok = parseInt(value, dt);
+        else if (key == "evasion" && kind == "armor") ok = parseFloat(value, evasion);
+        else if (key == "magdef" && kind == "armor") ok = parseInt(value, magdef);
+        else if (key == "cost" && kind == "spell") ok = parseInt(value, cost);
+        else if (key == "duration" && kind == "spell") ok = parseInt(value, duration);
+        else if (key == "aoe" && kind == "spell") ok = parseInt(value, aoe) && aoe >= 0;
+        else if (key == "potency" && kind == "item") ok = parseInt(value, potency);
+        else if (key == "category" && kind == "spell") {
+            category = value;
+            ok = value == spellCategoryName(spellCategoryFromName(value));
+        }
+        else if (key == "category" && kind == "item") {
+            category = value;
+            ok = value == itemCategoryName(itemCategoryFromName(value));
+        }
+        else {
+            error = "unknown key '" + key + "' for " + kind;
+            return false;
+        }
+        if (!ok) {
+            error = "bad value for " + key + ": '" + value + "'";
+            return false;
+        }
+    }
+
+    if (kind == "weapon") intern(Weapon(name, attack, accuracy, range, hits, element));
+    else if (kind == "armor") intern(Armor(name, dr, dt, evasion, element, magdef));
+    else if (kind == "spell") intern(Spell(name, attack, cost, range, duration, element, aoe, category));
+    else if (kind == "item") intern(Item(name, range, category, potency));
+    else {
+        error = "unknown kind '" + kind + "'";
+        return false;
+    }
+    return true;
+}
+
+bool ContentCatalog::loadText(const std::string& text, std::string& error) {
+    std::istringstream in(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!loadLine(line, error)) {
+            error = "line " + std::to_string(lineNumber) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ContentCatalog::loadFile(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    if (!loadText(text.str(), error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+ContentCatalog& contentCatalog() {
+    static ContentCatalog catalog;
+    return catalog;
+}
@@ -0,0 +1,100 @@
+#ifndef CONTENT_CATALOG_H
+#define CONTENT_CATALOG_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rpg_system.h"
+
+// ==========================================
+// Content Catalog
+// ==========================================
+// Process-wide immutable tables of every weapon, armor, spell and item type.
+// Combatants hold only the small ids handed out here, so a thousand goblins
+// with the same bow share one Weapon. Interning is by value: registering an
+// identical definition again returns the existing id. Entries never move or
+// change once added, so lookups take no lock and references stay valid for
+// the life of the process.
+//
+// Content files hold one definition per line; '#' starts a comment:
+//   weapon "Iron Sword"  attack=50 accuracy=0.9 range=1.5 hits=1 element=Physical
+//   armor  "Iron Armor"  dr=40 dt=0 evasion=0 element=Standard magdef=0
+//   spell  "Fireball"    attack=64 cost=15 range=15 duration=0 element=Fire aoe=2 category=Debuff
+//   item   "Potion"      range=4 category=Healing potency=50
+// Omitted keys keep the type's defaults. The first definition of a name is
+// the one findWeapon() and friends return, so a content file loaded before
+// the scenarios are built rebalances them.
+class ContentCatalog {
+private:
+    // Append-only table in fixed chunks so readers never see a reallocation.
+    template <typename T>
+    class Table {
+    private:
+        static const int CHUNK_BITS = 8;
+        static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+        std::unique_ptr<std::vector<T>> chunks[CONTENT_ID_LIMIT / CHUNK_SIZE];
+        int count = 0;
+        std::unordered_map<std::string, int> byValue;
+        std::unordered_map<std::string, int> byName;
+
+    public:
+        const T& get(int id) const { return (*chunks[id >> CHUNK_BITS])[id & (CHUNK_SIZE - 1)]; }
+        int size() const { return count; }
+        int find(const std::string& name) const;
+        // Returns the id of `value`, adding it if new. Aborts once the table
+        // already holds CONTENT_ID_LIMIT definitions.
+        int intern(const T& value, const std::string& key);
+    };
+
+    Table<Weapon> weapons;
+    Table<Armor> armors;
+    Table<Spell> spells;
+    Table<Item> items;
+    mutable std::mutex lock;
+
+    bool loadLine(const std::string& line, std::string& error);
+
+public:
+    // Id 0 of the weapon and armor tables is the unarmed default.
+    ContentCatalog();
+    ContentCatalog(const ContentCatalog&) = delete;
+    ContentCatalog& operator=(const ContentCatalog&) = delete;
+
+    WeaponId intern(const Weapon& weapon);
+    ArmorId intern(const Armor& armor);
+    SpellId intern(const Spell& spell);
+    ItemId intern(const Item& item);
+
+    const Weapon& weapon(WeaponId id) const { return weapons.get(id); }
+    const Armor& armor(ArmorId id) const { return armors.get(id); }
+    const Spell& spell(SpellId id) const { return spells.get(id); }
+    const Item& item(ItemId id) const { return items.get(id); }
+
+    // Definitions of each kind so far, defaults included; at most
+    // CONTENT_ID_LIMIT.
+    int weaponCount() const;
+    int armorCount() const;
+    int spellCount() const;
+    int itemCount() const;
+
+    // Id of the first definition with this name, or -1.
+    int findWeapon(const std::string& name) const;
+    int findArmor(const std::string& name) const;
+    int findSpell(const std::string& name) const;
+    int findItem(const std::string& name) const;
+
+    // Adds every definition in `text` (content file format). On a malformed
+    // line, stops and describes it in `error`; lines before it stay loaded.
+    bool loadText(const std::string& text, std::string& error);
+    bool loadFile(const std::string& path, std::string& error);
+};
+
+ContentCatalog& contentCatalog();
+
+// Splits a content-format line into words, dropping any '#' comment; double
+// quotes group a name with spaces.
+bool tokenizeContentLine(const std::string& line, std::vector<std::string>& words, std::string& error);
+
+#endif
@@ -0,0 +1,110 @@
+#include "damage_model.h"
+#include "content_catalog.h"
+#include <algorithm>
+#include <map>
+
+double DamagePmf::mean() const {
+    double total = 0.0;
+    for (size_t d = 0; d < p.size(); ++d) total += d * p[d];
+    return total;
+}
+
+double DamagePmf::probabilityAtLeast(int damage) const {
+    double total = 0.0;
+    for (size_t d = std::max(damage, 0); d < p.size(); ++d) total += p[d];
+    return total;
+}
+
+DamagePmf DamageCalculator::computeAttack(WeaponId weaponId, ArmorId armorId, int acidPotency, bool guarding) {
+    const Weapon& weapon = contentCatalog().weapon(weaponId);
+    const Armor& armor = contentCatalog().armor(armorId);
+    const double hit = BattleRng::chanceOdds(weapon.accuracy - armor.evasion);
+    const double crit = BattleRng::chanceOdds(0.05f);
+    const float elemMult = getElementalMultiplier(weapon.element, armor.element);
+
+    // (damage so far, acid potency added by this attack) -> probability.
+    std::map<std::pair<int, int>, double> states{ { { 0, 0 }, 1.0 } };
+    for (int swing = 0; swing < weapon.numberOfAttacks; ++swing) {
+        std::map<std::pair<int, int>, double> next;
+        for (const auto& state : states) {
+            int damage = state.first.first;
+            int addedAcid = state.first.second;
+            double chance = state.second;
+            next[state.first] += chance * (1.0 - hit);
+
+            int dr = armor.damageResistance - (acidPotency + addedAcid);
+            if (dr < -80) dr = -80;
+            if (guarding) dr += 100;
+            if (dr < -80) dr = -80;
+
+            for (int multiplier = ATTACK_MULTIPLIER_MIN; multiplier <= ATTACK_MULTIPLIER_MAX; ++multiplier) {
+                double rolled = chance * hit / ATTACK_MULTIPLIER_COUNT;
+                int product = (weapon.physicalAttack * multiplier) / 10;
+
+                // A crit deals the raw product: threshold, DR and element are skipped.
+                next[{ damage + std::max(product, 0), addedAcid }] += rolled * crit;
+
+                int afterThreshold = std::max(product - armor.damageThreshold, 1);
+                int dealt = static_cast<int>(((afterThreshold * 100) / (100 + dr)) * elemMult);
+                int acid = weapon.element == Element::Acid ? dealt / 3 : 0;
+                next[{ damage + std::max(dealt, 0), addedAcid + acid }] += rolled * (1.0 - crit);
+            }
+        }
+        states.swap(next);
+    }
+
+    DamagePmf pmf;
+    for (const auto& state : states) {
+        int damage = state.first.first;
+        if (damage >= static_cast<int>(pmf.p.size())) pmf.p.resize(damage + 1, 0.0);
+        pmf.p[damage] += state.second;
+    }
+    if (pmf.p.empty()) pmf.p.push_back(1.0);
+    return pmf;
+}
+
+const DamagePmf& DamageCalculator::attackDamage(WeaponId weapon, ArmorId armor, int acidPotency, bool guarding) {
+    uint64_t key = static_cast<uint64_t>(weapon) | (static_cast<uint64_t>(armor) << 16) |
+        (static_cast<uint64_t>(static_cast<uint32_t>(acidPotency)) << 32) | (guarding ? 1ull << 63 : 0);
+    auto found = cache.find(key);
+    if (found != cache.end()) return found->second;
+    return cache.emplace(key, computeAttack(weapon, armor, acidPotency, guarding)).first->second;
+}
+
+const DamagePmf& DamageCalculator::attackDamage(const Combatant& attacker, const Combatant& target) {
+    return attackDamage(attacker.getWeaponId(), target.getArmorId(), target.getStatusPotency(StatusType::Acid),
+        target.isGuarding());
+}
+
+int DamageCalculator::spellDamage(SpellId spellId, ArmorId armorId) {
+    const Spell& spell = contentCatalog().spell(spellId);
+    const Armor& armor = contentCatalog().armor(armorId);
+    int magicDef = armor.magicalDefense;
+    if (magicDef < -80) magicDef = -80;
+    int damage = (spell.magicalAttack * 100) / (100 + magicDef);
+    return static_cast<int>(damage * getElementalMultiplier(spell.element, armor.element));
+}
+
+std::vector<double> DamageCalculator::killChances(const DamagePmf& perAction, int hp, int maxActions) {
+    std::vector<double> chances;
+    if (hp <= 0) return std::vector<double>(std::max(maxActions, 0), 1.0);
+
+    // alive[h] = P(exactly h damage taken so far and still standing).
+    std::vector<double> alive(hp, 0.0), next(hp, 0.0);
+    alive[0] = 1.0;
+    double dead = 0.0;
+    for (int k = 0; k < maxActions; ++k) {
+        std::fill(next.begin(), next.end(), 0.0);
+        for (int h = 0; h < hp; ++h) {
+            if (alive[h] == 0.0) continue;
+            for (int d = 0; d < static_cast<int>(perAction.p.size()); ++d) {
+                double chance = alive[h] * perAction.p[d];
+                if (h + d >= hp) dead += chance;
+                else next[h + d] += chance;
+            }
+        }
+        alive.swap(next);
+        chances.push_back(dead);
+    }
+    return chances;
+}
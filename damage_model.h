@@ -0,0 +1,58 @@
+#ifndef DAMAGE_MODEL_H
+#define DAMAGE_MODEL_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "rpg_system.h"
+
+// ==========================================
+// Exact Damage Distributions
+// ==========================================
+// Probability mass of the HP one action takes off its target: p[d] is the
+// chance of exactly d damage.
+struct DamagePmf {
+    std::vector<double> p;
+
+    int maxDamage() const { return static_cast<int>(p.size()) - 1; }
+    double mean() const;
+    double probabilityAtLeast(int damage) const;
+};
+
+// Computes damage distributions by enumerating the rolls Combatant::attack
+// and castSpell make, with the engine's own integer and float arithmetic:
+// the hit roll against accuracy - evasion and the 5% crit roll at the
+// BattleRng's 24-bit float resolution, the uniform 7..13 multiplier, then
+// threshold, DR, guard and the elemental multiplier. An acid weapon's own
+// hits lower DR for the rest of its swings, as in play.
+//
+// Only direct damage is counted: burn and acid ticks, poison reflection and
+// anything ice's extra ticks set off are left out, and the target is
+// assumed not to die mid-attack (which does not change kill chances).
+// Attack results are memoized per (weapon, armor, acid potency, guard), so
+// repeated questions cost a hash lookup. Not thread-safe; use one per thread.
+class DamageCalculator {
+public:
+    // One attack: every swing of `weapon` against `armor`, with `acidPotency`
+    // already subtracted from the armor's DR and the target guarding or not.
+    const DamagePmf& attackDamage(WeaponId weapon, ArmorId armor, int acidPotency = 0, bool guarding = false);
+    // The same for `attacker`'s current weapon against `target` as it stands.
+    const DamagePmf& attackDamage(const Combatant& attacker, const Combatant& target);
+
+    // A spell always hits for one fixed amount.
+    static int spellDamage(SpellId spell, ArmorId armor);
+
+    // killChance[k - 1] is the probability that k actions, each drawn from
+    // `perAction`, deal at least `hp` in total, for k = 1..maxActions. Each
+    // action is independent: statuses left by earlier actions are ignored.
+    static std::vector<double> killChances(const DamagePmf& perAction, int hp, int maxActions);
+
+    size_t cachedCount() const { return cache.size(); }
+
+private:
+    std::unordered_map<uint64_t, DamagePmf> cache;
+
+    static DamagePmf computeAttack(WeaponId weapon, ArmorId armor, int acidPotency, bool guarding);
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef HEAP_COUNTER_H
+#define HEAP_COUNTER_H
+
+// ==========================================
+// Heap Allocation Counter
+// ==========================================
+// Built with RPG_COUNT_HEAP_ALLOCATIONS, heap_counter.cpp replaces the global
+// operator new and delete with thin wrappers over malloc and free that count
+// calls per thread, so a loop can check how often it reached the global heap
+// by reading the count before and after. Without it the allocator is left
+// alone and the count is -1 (unavailable).
+long long heapAllocationCount();
+
+#endif
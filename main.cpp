@@ -3,355 +3,367 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <csignal>
+#include <thread>
 #include "rpg_system.h" 
+#include "battle_ai.h"
+#include "simulation.h"
+#include "replay.h"
+#include "battle_file.h"
+#include "content_catalog.h"
+#include "balance_sweep.h"
+#include "damage_model.h"
+#include "battle_solver.h"
+#include "battle_server.h"
+#include "turn_driver.h"
 
 // ==========================================
-// Helper: Target Selection
+// Main Execution
 // ==========================================
-Combatant* selectTarget(Combatant* actor, const std::vector<Combatant*>& participants, bool enemiesOnly) {
-    std::cout << "\nSelect Target (" << (enemiesOnly ? "Enemies" : "Allies") << "):\n";
-    std::vector<Combatant*> validTargets;
-
-    int index = 1;
-    for (auto* p : participants) {
-        if (p->isAlive()) {
-            bool isSameTeam = (p->getTeam() == actor->getTeam());
 
-            // If we want enemies only, skip team members
-            if (enemiesOnly && isSameTeam) continue;
+void printUsage() {
+    std::cout << "Usage: RPGCombat [--seed <n>] [--simulate <battles>] [--threads <n>] [--bench-snapshot <units>]\n"
+        << "                 [--mcts-eval <battles>] [--mcts-units <per team>] [--mcts-rollouts <n>] [--mcts-ms <ms>]\n"
+        << "                 [--record <file>] [--replay <file>] [--bench-replay <battles>]\n"
+        << "                 [--scenario <file>] [--save-scenario <file>] [--skirmish <per team>] [--checkpoint <file>]\n"
+        << "                 [--bench-load <loads>] [--content <file>] [--analytics]\n"
+        << "                 [--sweep <file>] [--sweep-band <low> <high>] [--sweep-max <battles per configuration>]\n"
+        << "                 [--damage <weapon or spell> <armor>] [--damage-hp <target hp>]\n"
+        << "                 [--solve] [--solve-states <cap>]\n"
+        << "                 [--serve <socket>] [--load <socket>] [--bench-server <actions>]\n"
+        << "                 [--load-actions <n>] [--load-connections <n>] [--load-battles <per connection>]\n"
+        << "                 [--input-script <file>]\n";
+}
 
-            // If we want allies only (beneficial actions), skip enemies
-            if (!enemiesOnly && !isSameTeam) continue;
+volatile std::sig_atomic_t serverInterrupted = 0;
 
-            std::cout << index << ". " << p->getName()
-                << " [" << p->getTeam() << "] (HP: " << p->getHP() << ")\n";
-            validTargets.push_back(p);
-            index++;
-        }
+// Hosts battles on `socketPath` until SIGINT/SIGTERM.
+int runServer(const ServerConfig& config) {
+    BattleServer server(config);
+    std::string error;
+    if (!server.start(error)) {
+        std::cout << "[Server] " << error << "\n";
+        return 1;
     }
+    std::signal(SIGINT, [](int) { serverInterrupted = 1; });
+    std::signal(SIGTERM, [](int) { serverInterrupted = 1; });
+    std::cout << "[Server] Listening on " << config.socketPath << " (Ctrl+C to stop)\n";
+    while (!serverInterrupted) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    server.stop();
+    server.stats().print();
+    return 0;
+}
 
-    if (validTargets.empty()) {
-        std::cout << "No valid targets found.\n";
-        return nullptr;
+// Exact damage distribution of one attack or spell against an armor, and
+// the chance that repeating it kills a target with `hp` within k actions.
+int printDamageReport(const std::string& source, const std::string& armorName, int hp) {
+    buildDefaultScenario();     // Interns the built-in content so it can be found by name
+    ContentCatalog& catalog = contentCatalog();
+    int armor = catalog.findArmor(armorName);
+    if (armor < 0) {
+        std::cout << "[Damage] Unknown armor \"" << armorName << "\"\n";
+        return 1;
     }
 
-    std::cout << "Choice: ";
-    int choice;
-    if (!(std::cin >> choice)) {
-        std::cin.clear();
-        std::cin.ignore(1000, '\n');
-        return nullptr;
+    DamageCalculator calculator;
+    DamagePmf pmf;
+    int weapon = catalog.findWeapon(source);
+    int spell = catalog.findSpell(source);
+    if (weapon >= 0) {
+        pmf = calculator.attackDamage(static_cast<WeaponId>(weapon), static_cast<ArmorId>(armor));
+    }
+    else if (spell >= 0) {
+        pmf.p.assign(DamageCalculator::spellDamage(static_cast<SpellId>(spell), static_cast<ArmorId>(armor)) + 1, 0.0);
+        pmf.p.back() = 1.0;
+    }
+    else {
+        std::cout << "[Damage] Unknown weapon or spell \"" << source << "\"\n";
+        return 1;
     }
 
-    if (choice < 1 || choice > validTargets.size()) return nullptr;
-    return validTargets[choice - 1];
-}
-
-Combatant* getNearestEnemy(Combatant* actor, const std::vector<Combatant*>& participants) {
-    Combatant* nearest = nullptr;
-    float minDistance = 9999.0f;
-    std::string targetTeam = (actor->getTeam() == "Good Guys") ? "Bad Guys" : "Good Guys";
-
-    for (auto* target : participants) {
-        if (target->getTeam() == targetTeam && target->isAlive() && target->getX() != -1) {
-            float dist = getDistance(actor->getX(), actor->getY(), target->getX(), target->getY());
-            if (dist < minDistance) {
-                minDistance = dist;
-                nearest = target;
-            }
-        }
+    std::cout << "=== " << source << " vs " << armorName << " ===\n";
+    std::cout << "Mean damage: " << pmf.mean() << " | Max: " << pmf.maxDamage() << "\n";
+    for (int d = 0; d <= pmf.maxDamage(); ++d) {
+        if (pmf.p[d] > 0.0) std::cout << "  " << d << ": " << pmf.p[d] << "\n";
     }
-    return nearest;
+    std::vector<double> kills = DamageCalculator::killChances(pmf, hp, 10);
+    std::cout << "Kill chance vs " << hp << " HP:\n";
+    for (size_t k = 0; k < kills.size(); ++k) {
+        std::cout << "  within " << (k + 1) << " action" << (k == 0 ? "" : "s") << ": " << kills[k] << "\n";
+    }
+    return 0;
 }
 
-// ==========================================
-// Logic: Turn Handlers
-// ==========================================
-
-void runHumanTurn(Combatant* actor, BattleManager& battle, Grid& grid) {
-    bool turnComplete = false;
-    while (!turnComplete) {
-        std::cout << "\n[MENU] 1.Attack  2.Guard  3.Move 4.Spell  5.Item\nChoice: ";
-        int choice;
-        if (!(std::cin >> choice)) {
-            std::cin.clear();
-            std::cin.ignore(1000, '\n');
-            std::cout << "Invalid input.\n";
-            continue;
-        }
-
-        if (choice == 1) { // ATTACK
-            // Attack always targets enemies
-            Combatant* target = selectTarget(actor, battle.getParticipants(), true);
-            if (target && actor->attack(*target, grid)) {
-                actor->addTicks(COST_ATTACK);
-                turnComplete = true;
-            }
+int main(int argc, char* argv[]) {
+    long long simulateBattles = 0;
+    int snapshotUnits = 0;
+    long long mctsBattles = 0;
+    int mctsUnits = 4;
+    MctsConfig mcts;
+    std::string recordPath;
+    std::string replayPath;
+    long long replayBattles = 0;
+    std::string scenarioPath;
+    std::string saveScenarioPath;
+    std::string checkpointPath = "checkpoint.rpgs";
+    std::string inputScriptPath;
+    int skirmishUnits = 0;
+    long long benchLoads = 0;
+    bool analytics = false;
+    std::string sweepPath;
+    SweepOptions sweep;
+    std::string damageSource;
+    std::string damageArmor;
+    int damageHp = 100;
+    bool solve = false;
+    SolverConfig solver;
+    std::string servePath;
+    LoadConfig load;
+    long long benchServerActions = 0;
+    int threads = 0;
+    bool seeded = false;
+    uint64_t seed = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--simulate" && i + 1 < argc) simulateBattles = std::atoll(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (arg == "--bench-snapshot" && i + 1 < argc) snapshotUnits = std::atoi(argv[++i]);
+        else if (arg == "--mcts-eval" && i + 1 < argc) mctsBattles = std::atoll(argv[++i]);
+        else if (arg == "--mcts-units" && i + 1 < argc) mctsUnits = std::atoi(argv[++i]);
+        else if (arg == "--mcts-rollouts" && i + 1 < argc) mcts.rolloutsPerDecision = std::atoi(argv[++i]);
+        else if (arg == "--mcts-ms" && i + 1 < argc) mcts.timeBudgetMs = std::atof(argv[++i]);
+        else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        else if (arg == "--bench-replay" && i + 1 < argc) replayBattles = std::atoll(argv[++i]);
+        else if (arg == "--scenario" && i + 1 < argc) scenarioPath = argv[++i];
+        else if (arg == "--save-scenario" && i + 1 < argc) saveScenarioPath = argv[++i];
+        else if (arg == "--skirmish" && i + 1 < argc) skirmishUnits = std::atoi(argv[++i]);
+        else if (arg == "--checkpoint" && i + 1 < argc) checkpointPath = argv[++i];
+        else if (arg == "--input-script" && i + 1 < argc) inputScriptPath = argv[++i];
+        else if (arg == "--bench-load" && i + 1 < argc) benchLoads = std::atoll(argv[++i]);
+        else if (arg == "--analytics") analytics = true;
+        else if (arg == "--sweep" && i + 1 < argc) sweepPath = argv[++i];
+        else if (arg == "--sweep-band" && i + 2 < argc) {
+            sweep.bandLow = std::atof(argv[++i]);
+            sweep.bandHigh = std::atof(argv[++i]);
         }
-        else if (choice == 2) { // GUARD
-            actor->guard();
-            actor->addTicks(COST_GUARD);
-            turnComplete = true;
+        else if (arg == "--sweep-max" && i + 1 < argc) sweep.maxBattles = std::atoll(argv[++i]);
+        else if (arg == "--damage" && i + 2 < argc) {
+            damageSource = argv[++i];
+            damageArmor = argv[++i];
         }
-        else if (choice == 3) { // MOVE
-            std::cout << "Direction (Press 1 to go North, 2 to go South, 3 to go East, 4 to go West.): ";
-            int dir;
-            if (!(std::cin >> dir)) {
-                std::cin.clear();
-                std::cin.ignore(1000, '\n');
-                std::cout << "Invalid input.\n";
-                continue;
-            }
-            int cost = 0;
-            switch (dir) {
-            case 1: cost = grid.moveCombatant(actor, 0, 1); break; // North is +Y
-            case 2: cost = grid.moveCombatant(actor, 0, -1); break; // South is -Y
-            case 3: cost = grid.moveCombatant(actor, 1, 0); break; // East is +X
-            case 4: cost = grid.moveCombatant(actor, -1, 0); break; // West is -X
-            default:
-                std::cout << "Invalid direction.\n";
-                continue;
-            }
-            if (cost > 0) {
-                actor->addTicks(cost);
-                turnComplete = true;
-            }
-            else {
-                std::cout << "Cannot move in that direction.\n";
+        else if (arg == "--damage-hp" && i + 1 < argc) damageHp = std::atoi(argv[++i]);
+        else if (arg == "--solve") solve = true;
+        else if (arg == "--solve-states" && i + 1 < argc) solver.maxStates = std::atoll(argv[++i]);
+        else if (arg == "--serve" && i + 1 < argc) servePath = argv[++i];
+        else if (arg == "--load" && i + 1 < argc) load.socketPath = argv[++i];
+        else if (arg == "--bench-server" && i + 1 < argc) benchServerActions = std::atoll(argv[++i]);
+        else if (arg == "--load-actions" && i + 1 < argc) load.actions = std::atoll(argv[++i]);
+        else if (arg == "--load-connections" && i + 1 < argc) load.connections = std::atoi(argv[++i]);
+        else if (arg == "--load-battles" && i + 1 < argc) load.battlesPerConnection = std::atoi(argv[++i]);
+        else if (arg == "--content" && i + 1 < argc) {
+            // Loaded before any scenario is built, so its definitions win by name.
+            std::string error;
+            if (!contentCatalog().loadFile(argv[++i], error)) {
+                std::cout << "[Content] " << error << "\n";
+                return 1;
             }
         }
-        else if (choice == 4) { // SPELL
-            if (actor->getSpells().empty()) {
-                std::cout << "No spells known!\n";
-                continue;
-            }
-            std::cout << "Select Spell:\n";
-            for (size_t i = 0; i < actor->getSpells().size(); ++i) {
-                std::cout << (i + 1) << ". " << actor->getSpells()[i].name
-                    << " (AOE: " << actor->getSpells()[i].aoe
-                    << ", " << actor->getSpells()[i].category << ")\n";
-            }
-            int sIdx;
-            if (!(std::cin >> sIdx) || sIdx < 1 || sIdx > static_cast<int>(actor->getSpells().size())) {
-                std::cin.clear();
-                std::cin.ignore(1000, '\n');
-                std::cout << "Invalid spell selection.\n";
-                continue;
-            }
-            sIdx--; // 0-based
-
-            // Determine targeting based on category
-            std::string cat = actor->getSpells()[sIdx].category;
-            bool enemiesOnly = (cat == "Debuff");
-
-            Combatant* target = selectTarget(actor, battle.getParticipants(), enemiesOnly);
-            if (target && actor->castSpell(*target, sIdx, grid)) {
-                actor->addTicks(COST_SPELL);
-                turnComplete = true;
-            }
-        }
-        else if (choice == 5) { // ITEM
-            if (actor->getInventory().empty()) {
-                std::cout << "Inventory empty!\n";
-                continue;
-            }
-            std::cout << "Select Item:\n";
-            for (size_t i = 0; i < actor->getInventory().size(); ++i) {
-                const auto& item = actor->getInventory()[i];
-                std::cout << (i + 1) << ". " << item.name << " (x" << item.quantity
-                    << ", " << item.category << ")\n";
-            }
-            int iIdx;
-            if (!(std::cin >> iIdx) || iIdx < 1 || iIdx > static_cast<int>(actor->getInventory().size())) {
-                std::cin.clear();
-                std::cin.ignore(1000, '\n');
-                std::cout << "Invalid item selection.\n";
-                continue;
-            }
-            iIdx--;
-
-            // Determine targeting based on category
-            std::string cat = actor->getInventory()[iIdx].category;
-            // Assuming Debuffs are the only offensive items, everything else (Healing/Buff/RestoreMP) is friendly
-            bool enemiesOnly = (cat == "Debuff");
-
-            Combatant* target = selectTarget(actor, battle.getParticipants(), enemiesOnly);
-            if (target && actor->useItem(*target, iIdx)) {
-                actor->addTicks(COST_ITEM);
-                turnComplete = true;
-            }
+        else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            seeded = true;
         }
         else {
-            std::cout << "Invalid input.\n";
-            std::cin.clear();
-            std::cin.ignore(1000, '\n');
+            printUsage();
+            return 1;
         }
     }
-}
-
-void runAITurn(Combatant* actor, BattleManager& battle, Grid& grid) {
-    std::cout << "(AI Thinking...)\n";
-    Combatant* target = getNearestEnemy(actor, battle.getParticipants());
-
-    if (!target) {
-        std::cout << " >> AI has no targets. Waiting.\n";
-        actor->addTicks(COST_MOVE_BASE);
-        return;
-    }
 
-    // Priority 1: Cast Spell
-    for (size_t i = 0; i < actor->getSpells().size(); ++i) {
-        const auto& spell = actor->getSpells()[i];
-        if (actor->getMP() >= spell.mpCost) {
-            if (actor->checkRange(*target, spell.range)) {
-                actor->castSpell(*target, i, grid);
-                actor->addTicks(COST_SPELL);
-                return;
-            }
-            else {
-                int dx = target->getX() - actor->getX();
-                int dy = target->getY() - actor->getY();
-                int moveX = (std::abs(dx) > std::abs(dy)) ? ((dx > 0) ? 1 : -1) : 0;
-                int moveY = (moveX == 0) ? ((dy > 0) ? 1 : -1) : 0;
-
-                std::cout << " >> AI moving to spell range...\n";
-                int cost = grid.moveCombatant(actor, moveX, moveY);
-                if (cost == 0) cost = COST_MOVE_BASE;
-                actor->addTicks(cost);
-                return;
-            }
+    if (!replayPath.empty()) {
+        std::vector<uint8_t> data;
+        if (!readReplayFile(replayPath, data)) {
+            std::cout << "Cannot read replay " << replayPath << "\n";
+            return 1;
         }
+        TextEventSink narrator(std::cout);
+        ReplayResult result = playReplay(data, &narrator);
+        if (!result.ok) {
+            std::cout << "[Replay] Failed after " << result.turns << " turns: " << result.error << "\n";
+            return 1;
+        }
+        std::cout << "[Replay] " << result.turns << " turns, " << result.checksums
+            << " checksums verified. Winner: " << result.winner << "\n";
+        return 0;
     }
 
-    // Priority 2: Attack
-    if (actor->checkRange(*target, actor->getWeapon().range)) {
-        actor->attack(*target, grid);
-        actor->addTicks(COST_ATTACK);
+    if (!damageSource.empty()) {
+        return printDamageReport(damageSource, damageArmor, damageHp);
     }
-    else {
-        int dx = target->getX() - actor->getX();
-        int dy = target->getY() - actor->getY();
-        int moveX = (std::abs(dx) > std::abs(dy)) ? ((dx > 0) ? 1 : -1) : 0;
-        int moveY = (moveX == 0) ? ((dy > 0) ? 1 : -1) : 0;
 
-        std::cout << " >> AI moving to attack...\n";
-        int cost = grid.moveCombatant(actor, moveX, moveY);
-        if (cost == 0) cost = COST_MOVE_BASE;
-        actor->addTicks(cost);
+    if (replayBattles > 0) {
+        runReplayBenchmark(replayBattles, seed).print();
+        return 0;
     }
-}
 
-void handleBrokenUnit(Combatant* actor, Grid& grid) {
-    std::cout << " >> " << actor->getName() << " is BROKEN and panics!\n";
-    int x = actor->getX();
-    int y = actor->getY();
-    int w = grid.getWidth();
-    int h = grid.getHeight();
-
-    int distN = y, distS = h - 1 - y, distW = x, distE = w - 1 - x;
-    int dx = 0, dy = -1, minDist = distN;
+    if (snapshotUnits > 0) {
+        runSnapshotBenchmark(snapshotUnits).print();
+        return 0;
+    }
 
-    if (distS < minDist) { minDist = distS; dx = 0; dy = 1; }
-    if (distW < minDist) { minDist = distW; dx = -1; dy = 0; }
-    if (distE < minDist) { minDist = distE; dx = 1; dy = 0; }
+    if (mctsBattles > 0) {
+        mcts.threads = threads;
+        mcts.seed = seed;
+        runMctsEvaluation(mctsBattles, mctsUnits, mcts).print();
+        return 0;
+    }
 
-    int cost = grid.moveCombatant(actor, dx, dy);
-    if (cost > 0 && !actor->hasFled()) actor->regainMorale(2);
-    if (cost == 0) cost = COST_MOVE_BASE;
-    actor->addTicks(cost);
-}
+    if (!saveScenarioPath.empty()) {
+        auto built = skirmishUnits > 0 ? buildSkirmishScenario(skirmishUnits) : buildDefaultScenario();
+        built->manager.getRng().reseed(seed, 0);
+        if (!saveBattleFile(saveScenarioPath, *built)) {
+            std::cout << "Cannot write " << saveScenarioPath << "\n";
+            return 1;
+        }
+        std::cout << "[Info] Scenario saved to " << saveScenarioPath << "\n";
+        return 0;
+    }
 
-// ==========================================
-// Main Execution
-// ==========================================
+    BattleFile scenarioFile;
+    if (!scenarioPath.empty() && !scenarioFile.open(scenarioPath)) {
+        std::cout << "Cannot load battle file " << scenarioPath << "\n";
+        return 1;
+    }
 
-int main() {
-    // 1. Items
-    Item healthPotion("Health Potion", 1, 4.0f, "Healing", 50);
-    Item magicPotion("Magic Potion", 1, 4.0f, "RestoreMP", 40);
+    if (benchLoads > 0) {
+        if (scenarioPath.empty()) {
+            printUsage();
+            return 1;
+        }
+        runScenarioLoadBenchmark(scenarioPath, benchLoads).print();
+        return 0;
+    }
 
-    // 2. Weapons
-    Weapon ironSword("Iron Sword", 50, 0.9f, 1.5f, 1, "Physical");
-    Weapon woodenStaff("Wooden Staff", 20, 0.67f, 1.5f, 1, "Magical");
-    Weapon woodBow("Wood Bow", 40, 0.5f, 11.0f, 1, "Physical");
+    if (!sweepPath.empty()) {
+        SweepSpec spec;
+        SweepResult result;
+        std::string error;
+        sweep.threads = threads;
+        sweep.seed = seed;
+        sweep.skirmishUnits = skirmishUnits;
+        sweep.scenario = scenarioPath.empty() ? nullptr : &scenarioFile.getView();
+        if (!spec.loadFile(sweepPath, error) || !runSweep(spec, sweep, result, error)) {
+            std::cout << "[Sweep] " << error << "\n";
+            return 1;
+        }
+        result.print();
+        return 0;
+    }
 
-    // 3. Armor
-    Armor ironArmor("Iron Armor", 40, 0, 0.0f, "Standard", 0);
-    Armor clothArmor("Cloth Armor", 10, 0, 0.0f, "Magical", 0);
-    Armor woodenArmor("Wooden Armor", 20, 0, 0.0f, "Standard", 0);
+    if (!servePath.empty()) {
+        ServerConfig config;
+        config.socketPath = servePath;
+        config.threads = threads;
+        return runServer(config);
+    }
 
-    // 4. Spells (AOE 2, Debuff)
-    // Name, Matk, Cost, Range, Duration, Element, AOE, Category
-    Spell fireball("Fireball", 64, 15, 15.0f, 0, "Fire", 2, "Debuff");
+    if (!load.socketPath.empty() || benchServerActions > 0) {
+        // --bench-server hosts its own server in a private scratch directory.
+        std::unique_ptr<BattleServer> server;
+        std::string error;
+        if (benchServerActions > 0) {
+            ServerConfig config;
+            config.threads = threads;
+            server = std::make_unique<BattleServer>(config);
+            if (!server->start(error)) {
+                std::cout << "[Server] " << error << "\n";
+                return 1;
+            }
+            load.socketPath = server->socketPath();
+            load.actions = benchServerActions;
+        }
+        load.skirmishUnits = skirmishUnits;
+        load.seed = seed;
+        LoadResult result;
+        if (!runLoadGenerator(load, result, error)) {
+            std::cout << "[Load] " << error << "\n";
+            return 1;
+        }
+        result.print();
+        return 0;
+    }
 
-    // 5. Combatants (Good Guys)
-    auto dwayne = std::make_shared<Combatant>("Dwayne", "Good Guys", 200, 0, 5, 100);
-    dwayne->equipWeapon(ironSword);
-    dwayne->equipArmor(ironArmor);
-    dwayne->addItem(healthPotion);
+    if (solve) {
+        auto built = !scenarioPath.empty() ? scenarioFile.instantiate()
+            : skirmishUnits > 0 ? buildSkirmishScenario(skirmishUnits) : buildDefaultScenario();
+        solver.threads = threads;
+        solver.seed = seed;
+        solveBattle(*built, solver).print();
+        return 0;
+    }
 
-    auto elizabeth = std::make_shared<Combatant>("Elizabeth", "Good Guys", 100, 75, 7, 70);
-    elizabeth->equipWeapon(woodenStaff);
-    elizabeth->equipArmor(clothArmor);
-    elizabeth->addItem(magicPotion);
-    elizabeth->learnSpell(fireball);
+    if (simulateBattles > 0) {
+        BattleAnalytics stats;
+        runSimulation(simulateBattles, threads, seed, scenarioPath.empty() ? nullptr : &scenarioFile.getView(),
+            analytics ? &stats : nullptr).print();
+        if (analytics) stats.print(std::cout);
+        return 0;
+    }
 
-    // 6. Combatants (Bad Guys)
-    auto goblin1 = std::make_shared<Combatant>("Goblin Archer A", "Bad Guys", 90, 0, 9, 40);
-    goblin1->equipWeapon(woodBow);
-    goblin1->equipArmor(woodenArmor);
+    auto scenario = scenarioPath.empty() ? buildDefaultScenario() : scenarioFile.instantiate();
+    BattleManager& battle = scenario->manager;
 
-    auto goblin2 = std::make_shared<Combatant>("Goblin Archer B", "Bad Guys", 90, 0, 9, 40);
-    goblin2->equipWeapon(woodBow);
-    goblin2->equipArmor(woodenArmor);
+    // A loaded file carries its own RNG position; only an explicit seed overrides it.
+    if (scenarioPath.empty() || seeded) {
+        if (!seeded) {
+            std::random_device rd;
+            seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        }
+        battle.getRng().reseed(seed, 0);
+    }
 
-    // 7. Grid Setup (12x12 to fit 10,0 and 0,10)
-    Grid battleGrid(12, 12);
-    battleGrid.placeCombatant(dwayne.get(), 0, 0);
-    battleGrid.placeCombatant(elizabeth.get(), 2, 0);
-    battleGrid.placeCombatant(goblin1.get(), 10, 0);
-    battleGrid.placeCombatant(goblin2.get(), 0, 10);
+    TextEventSink narrator(std::cout);
+    battle.setEventSink(&narrator);
 
-    BattleManager battle;
-    battle.addParticipant(dwayne.get());
-    battle.addParticipant(elizabeth.get());
-    battle.addParticipant(goblin1.get());
-    battle.addParticipant(goblin2.get());
+    ReplayRecorder recorder;
+    if (!recordPath.empty()) recorder.begin(*scenario);
 
-    // 8. Game Loop
+    // Game Loop
     std::cout << "=== BATTLE START ===\n";
-    std::cout << "Dwayne & Elizabeth vs Two Goblin Archers!\n";
+    if (scenarioPath.empty()) {
+        std::cout << "Dwayne & Elizabeth vs Two Goblin Archers!\n";
+        std::cout << "[Info] Battle seed: " << seed << " (replay with --seed)\n";
+    }
+    else {
+        std::cout << "[Info] Loaded " << scenarioPath << "\n";
+    }
 
-    while (true) {
-        // A. Victory Check
-        std::string winner = battle.getWinner();
-        if (winner != "None") {
-            std::cout << "\n=================================\n";
-            std::cout << "       " << winner << " TEAM WINS!       \n";
-            std::cout << "=================================\n";
-            break;
+    // Human turns answer from the console, or from a script for headless runs.
+    std::ifstream script;
+    if (!inputScriptPath.empty()) {
+        script.open(inputScriptPath);
+        if (!script) {
+            std::cout << "Cannot read input script " << inputScriptPath << "\n";
+            return 1;
         }
+    }
+    TurnInput input;
+    Task<std::string> game = playBattle(*scenario, input, std::cout, checkpointPath,
+        recordPath.empty() ? nullptr : &recorder);
+    if (!feedBattle(game, input, inputScriptPath.empty() ? std::cin : script)) {
+        std::cout << "\n[Info] Input ended before the battle did\n";
+    }
 
-        // B. Get Next Actor
-        Combatant* actor = battle.getNextActiveCombatant();
-        if (!actor) break;
-
-        battleGrid.drawGrid();
-        actor->startTurn();
-
-        std::cout << "\n>>> TURN: " << actor->getName()
-            << " (HP:" << actor->getHP() << " MP:" << actor->getMP() << ")\n";
-
-        // C. Handle Turn Type
-        if (actor->isBroken()) {
-            handleBrokenUnit(actor, battleGrid);
-        }
-        else if (actor->getTeam() == "Good Guys") {
-            runHumanTurn(actor, battle, battleGrid);
-        }
-        else {
-            runAITurn(actor, battle, battleGrid);
-        }
+    if (!recordPath.empty()) {
+        recorder.finish(*scenario);
+        if (writeReplayFile(recordPath, recorder.getData()))
+            std::cout << "[Info] Replay saved to " << recordPath << "\n";
+        else
+            std::cout << "[Info] Could not write replay to " << recordPath << "\n";
     }
     return 0;
 }
\ No newline at end of file
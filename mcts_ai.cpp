@@ -0,0 +1,220 @@
+#include "mcts_ai.h"
+#include "battle_ai.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Share of the surviving HP held by each team, or 1/0 once a side is wiped
+// out; indexed by team id.
+void scoreTeams(const CombatantStore& units, std::vector<double>& scores) {
+    int teams = 0;
+    for (int i = 0; i < units.size(); ++i) teams = std::max(teams, units.teamId[i] + 1);
+    std::vector<long long> health(teams, 0);
+    long long total = 0;
+    for (int i = 0; i < units.size(); ++i) {
+        if (!units.isAlive(i)) continue;
+        health[units.teamId[i]] += units.currentHealth[i];
+        total += units.currentHealth[i];
+    }
+    scores.assign(teams, 0.5);
+    if (total == 0) return;
+    for (int t = 0; t < teams; ++t) scores[t] = static_cast<double>(health[t]) / total;
+}
+
+} // namespace
+
+MctsPlanner::MctsPlanner(const Battle& battle, const MctsConfig& cfg) : config(cfg) {
+    if (config.rolloutsPerDecision <= 0 && config.timeBudgetMs <= 0.0) config.rolloutsPerDecision = 2000;
+    int count = config.threads > 0 ? config.threads : static_cast<int>(std::thread::hardware_concurrency());
+    if (count <= 0) count = 1;
+
+    workers.resize(count);
+    for (auto& worker : workers) worker.battle = battle.clone();
+    for (int i = 0; i < count; ++i) threads.emplace_back(&MctsPlanner::workerLoop, this, i);
+}
+
+MctsPlanner::~MctsPlanner() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void MctsPlanner::workerLoop(int index) {
+    long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        search(workers[index], index);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--running == 0) finished.notify_one();
+        }
+    }
+}
+
+void MctsPlanner::search(Worker& worker, int index) {
+    worker.tree.clear();
+    worker.tree.emplace_back();
+    worker.rollouts = 0;
+
+    long long budget = 0;
+    if (rolloutBudget > 0) {
+        long long count = static_cast<long long>(workers.size());
+        budget = (rolloutBudget + count - 1) / count;
+    }
+    // Stream layout: decision | worker | iteration, so no two rollouts share one.
+    uint64_t streamBase = (static_cast<uint64_t>(decisions) << 40) | (static_cast<uint64_t>(index) << 32);
+    while (budget == 0 || worker.rollouts < budget) {
+        if (config.timeBudgetMs > 0.0 && std::chrono::steady_clock::now() >= deadline) break;
+        iterate(worker, streamBase | static_cast<uint64_t>(worker.rollouts));
+        worker.rollouts++;
+    }
+}
+
+int MctsPlanner::selectEdge(Worker& worker, int node, Combatant* actor) {
+    Battle& battle = *worker.battle;
+    worker.actions.clear();
+    legalActions(battle.manager, battle.grid, actor, worker.actions);
+
+    Node& current = worker.tree[node];
+    current.visits++;
+
+    // Expand the first legal action not tried yet from this node.
+    int best = -1;
+    double bestScore = -1.0;
+    double logVisits = std::log(static_cast<double>(current.visits));
+    for (const auto& action : worker.actions) {
+        int found = -1;
+        for (int e = 0; e < static_cast<int>(current.edges.size()); ++e) {
+            if (current.edges[e].action == action) {
+                found = e;
+                break;
+            }
+        }
+        if (found == -1) {
+            Edge edge;
+            edge.action = action;
+            current.edges.push_back(edge);
+            return static_cast<int>(current.edges.size()) - 1;
+        }
+        const Edge& edge = current.edges[found];
+        double score = edge.value / edge.visits + config.exploration * std::sqrt(logVisits / edge.visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = found;
+        }
+    }
+    return best;
+}
+
+void MctsPlanner::iterate(Worker& worker, uint64_t stream) {
+    Battle& battle = *worker.battle;
+    battle.restoreState(root);
+    battle.manager.getRng().reseed(config.seed, stream);
+
+    worker.path.clear();
+    worker.pathTeams.clear();
+    Combatant* actor = battle.manager.getParticipants()[rootSlot];
+    int node = 0;
+    int rolloutTurns = config.rolloutTurns;
+
+    while (true) {
+        if (actor->isBroken()) {
+            handleBrokenUnit(actor, battle.manager, battle.grid);
+        }
+        else if (node != -1) {
+            int e = selectEdge(worker, node, actor);
+            worker.path.emplace_back(node, e);
+            worker.pathTeams.push_back(actor->getTeamId());
+
+            // Grow the tree by one node per iteration, then switch to rollout.
+            int child = worker.tree[node].edges[e].child;
+            if (child == -1) {
+                worker.tree[node].edges[e].child = static_cast<int>(worker.tree.size());
+                worker.tree.emplace_back();
+                node = -1;
+            }
+            else {
+                node = child;
+            }
+            BattleAction action = worker.tree[worker.path.back().first].edges[e].action;
+            if (!applyAction(actor, action, battle.manager, battle.grid)) {
+                runAITurn(actor, battle.manager, battle.grid);
+            }
+        }
+        else {
+            if (rolloutTurns-- <= 0) break;
+            runAITurn(actor, battle.manager, battle.grid);
+        }
+
+        if (battle.manager.getWinner() != "None") break;
+        actor = battle.manager.getNextActiveCombatant();
+        if (!actor) break;
+        actor->startTurn();
+    }
+
+    std::vector<double> scores;
+    scoreTeams(battle.manager.getStore(), scores);
+    for (size_t i = 0; i < worker.path.size(); ++i) {
+        Edge& edge = worker.tree[worker.path[i].first].edges[worker.path[i].second];
+        edge.visits++;
+        edge.value += scores[worker.pathTeams[i]];
+    }
+}
+
+BattleAction MctsPlanner::chooseAction(const Battle& battle, const Combatant* actor) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        battle.saveState(root);
+        rootSlot = actor->getSlot();
+        rolloutBudget = config.rolloutsPerDecision;
+        deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(config.timeBudgetMs));
+        running = static_cast<int>(workers.size());
+        generation++;
+        wake.notify_all();
+        finished.wait(guard, [&]() { return running == 0; });
+    }
+    decisions++;
+
+    // Sum root visits per action over every worker's tree.
+    std::vector<Edge> totals;
+    lastStats = MctsStats();
+    for (const auto& worker : workers) {
+        lastStats.rollouts += worker.rollouts;
+        lastStats.treeNodes += static_cast<long long>(worker.tree.size());
+        for (const auto& edge : worker.tree[0].edges) {
+            auto it = std::find_if(totals.begin(), totals.end(),
+                [&](const Edge& e) { return e.action == edge.action; });
+            if (it == totals.end()) totals.push_back(edge);
+            else it->visits += edge.visits;
+        }
+    }
+    lastStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BattleAction best;
+    int bestVisits = -1;
+    for (const auto& edge : totals) {
+        if (edge.visits > bestVisits) {
+            bestVisits = edge.visits;
+            best = edge.action;
+        }
+    }
+    return best;
+}
+
+void runMctsTurn(Combatant* actor, Battle& battle, MctsPlanner& planner) {
+    BattleAction action = planner.chooseAction(battle, actor);
+    if (!applyAction(actor, action, battle.manager, battle.grid)) {
+        runAITurn(actor, battle.manager, battle.grid);
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef MCTS_AI_H
+#define MCTS_AI_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "battle_action.h"
+#include "battle_state.h"
+#include "scenario.h"
+
+// ==========================================
+// Monte-Carlo Tree Search Policy
+// ==========================================
+struct MctsConfig {
+    int threads = 0;                // Search workers (0 = one per hardware thread)
+    int rolloutsPerDecision = 2000; // Node budget shared by all workers (0 = no limit)
+    double timeBudgetMs = 0.0;      // Wall-clock budget per decision (0 = no limit)
+    int rolloutTurns = 200;         // Greedy turns played past the tree before scoring
+    double exploration = 0.7;       // UCB1 exploration constant
+    uint64_t seed = 0;
+};
+
+struct MctsStats {
+    long long rollouts = 0;
+    long long treeNodes = 0;
+    double seconds = 0.0;
+
+    double rolloutsPerSecond() const { return seconds > 0.0 ? rollouts / seconds : 0.0; }
+};
+
+// Root-parallel open-loop UCT. Each worker owns a private clone of the battle
+// and its own tree; every iteration restores the clone from the decision's
+// snapshot, draws a fresh RNG stream, descends the tree with UCB1 (each step
+// scored from the acting team's side), then finishes the fight with the greedy
+// policy. Root visit counts are summed across workers to pick the move.
+// Workers persist between decisions.
+class MctsPlanner {
+private:
+    struct Edge {
+        BattleAction action;
+        int child = -1;
+        int visits = 0;
+        double value = 0.0;
+    };
+    struct Node {
+        int visits = 0;
+        std::vector<Edge> edges;
+    };
+    struct Worker {
+        std::unique_ptr<Battle> battle;
+        std::vector<Node> tree;
+        std::vector<BattleAction> actions;
+        std::vector<std::pair<int, int>> path;  // (node, edge) per tree step
+        std::vector<int> pathTeams;
+        long long rollouts = 0;
+    };
+
+    MctsConfig config;
+    std::vector<Worker> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    long long generation = 0;
+    int running = 0;
+    bool stopping = false;
+
+    // The decision being searched.
+    BattleState root;
+    int rootSlot = -1;
+    long long rolloutBudget = 0;
+    std::chrono::steady_clock::time_point deadline;
+    long long decisions = 0;
+
+    MctsStats lastStats;
+
+    void workerLoop(int index);
+    void search(Worker& worker, int index);
+    void iterate(Worker& worker, uint64_t stream);
+    int selectEdge(Worker& worker, int node, Combatant* actor);
+
+public:
+    MctsPlanner(const Battle& battle, const MctsConfig& config);
+    ~MctsPlanner();
+    MctsPlanner(const MctsPlanner&) = delete;
+    MctsPlanner& operator=(const MctsPlanner&) = delete;
+
+    // Picks `actor`'s action in `battle`'s current state. `battle` must be the
+    // one the planner was built from (or one built the same way), with
+    // `actor`'s turn already started.
+    BattleAction chooseAction(const Battle& battle, const Combatant* actor);
+    const MctsStats& getLastStats() const { return lastStats; }
+};
+
+// Plays `actor`'s turn with the planner's choice, falling back to the greedy
+// policy if the action is refused.
+void runMctsTurn(Combatant* actor, Battle& battle, MctsPlanner& planner);
+
+#endif
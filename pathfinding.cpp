@@ -0,0 +1,282 @@
+#include "pathfinding.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+const int STEP_X[] = { 0, 0, 1, -1 };
+const int STEP_Y[] = { 1, -1, 0, 0 };
+
+int countTrailingZeros(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+} // namespace
+
+const int Pathfinder::UNREACHABLE;
+
+Pathfinder::Pathfinder(Grid& g)
+    : grid(g), teamFields(g.getMemoryResource()), exitField(g.getMemoryResource()), enterCosts(g.getMemoryResource()),
+    ring(RING_SIZE, g.getMemoryResource()), seeds(g.getMemoryResource()), frontier(g.getMemoryResource()),
+    stale(g.getMemoryResource()), sourceCells(g.getMemoryResource()), pathCost(g.getMemoryResource()),
+    pathParent(g.getMemoryResource()) {
+}
+
+void Pathfinder::refreshCosts() {
+    if (costsVersion == grid.getTerrainVersion()) return;
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    enterCosts.resize(width * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) enterCosts[y * width + x] = grid.getEnterCost(x, y);
+    }
+    costsVersion = grid.getTerrainVersion();
+}
+
+void Pathfinder::relax(Field& field) {
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    std::sort(seeds.begin(), seeds.end());
+
+    size_t nextSeed = 0;
+    int pending = 0;
+    int d = seeds.empty() ? 0 : seeds[0].first;
+    while (nextSeed < seeds.size() || pending > 0) {
+        if (pending == 0 && seeds[nextSeed].first > d) d = seeds[nextSeed].first;
+        for (; nextSeed < seeds.size() && seeds[nextSeed].first == d; ++nextSeed) {
+            ring[d % RING_SIZE].push_back(seeds[nextSeed].second);
+            pending++;
+        }
+
+        // Every step costs at least 1 and less than RING_SIZE, so cells
+        // reached from this bucket land in a different one.
+        std::pmr::vector<int>& bucket = ring[d % RING_SIZE];
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            int u = bucket[i];
+            pending--;
+            if (field.dist[u] != d) continue;
+
+            // Fields are walked backwards: a neighbour v reaches the source
+            // via u by stepping onto u.
+            int cost = enterCosts[u];
+            if (cost < 0) continue;
+            int next = d + cost;
+            int ux = u % width;
+            int uy = u / width;
+            for (int k = 0; k < 4; ++k) {
+                int vx = ux + STEP_X[k];
+                int vy = uy + STEP_Y[k];
+                if (vx < 0 || vx >= width || vy < 0 || vy >= height) continue;
+                int v = vy * width + vx;
+                if (next < field.dist[v]) {
+                    field.dist[v] = next;
+                    field.owner[v] = field.owner[u];
+                    ring[next % RING_SIZE].push_back(v);
+                    pending++;
+                }
+            }
+        }
+        bucket.clear();
+        d++;
+    }
+    seeds.clear();
+}
+
+void Pathfinder::rebuild(Field& field, const std::pmr::vector<int>& sources) {
+    int cells = grid.getWidth() * grid.getHeight();
+    field.dist.assign(cells, UNREACHABLE);
+    field.owner.assign(cells, -1);
+    field.terrainVersion = grid.getTerrainVersion();
+    for (int cell : sources) {
+        field.dist[cell] = 0;
+        field.owner[cell] = cell;
+        seeds.emplace_back(0, cell);
+    }
+    relax(field);
+}
+
+void Pathfinder::patch(Field& field, const std::pmr::vector<uint64_t>& sources) {
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    stale.clear();
+
+    // A vacated source takes down exactly the cells measured to it; every
+    // other distance is still exact, so only that region is recomputed from
+    // its surviving border.
+    for (size_t w = 0; w < sources.size(); ++w) {
+        uint64_t removed = field.sources[w] & ~sources[w];
+        while (removed) {
+            int source = static_cast<int>(w * 64) + countTrailingZeros(removed);
+            removed &= removed - 1;
+            size_t first = stale.size();
+            stale.push_back(source);
+            field.owner[source] = -1;
+            field.dist[source] = UNREACHABLE;
+            for (size_t i = first; i < stale.size(); ++i) {
+                int cx = stale[i] % width;
+                int cy = stale[i] / width;
+                for (int k = 0; k < 4; ++k) {
+                    int nx = cx + STEP_X[k];
+                    int ny = cy + STEP_Y[k];
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+                    int n = ny * width + nx;
+                    if (field.owner[n] == source) {
+                        field.owner[n] = -1;
+                        field.dist[n] = UNREACHABLE;
+                        stale.push_back(n);
+                    }
+                }
+            }
+        }
+    }
+    for (int cell : stale) {
+        int cx = cell % width;
+        int cy = cell / width;
+        for (int k = 0; k < 4; ++k) {
+            int nx = cx + STEP_X[k];
+            int ny = cy + STEP_Y[k];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+            int n = ny * width + nx;
+            if (field.owner[n] != -1) seeds.emplace_back(field.dist[n], n);
+        }
+    }
+
+    for (size_t w = 0; w < sources.size(); ++w) {
+        uint64_t added = sources[w] & ~field.sources[w];
+        while (added) {
+            int source = static_cast<int>(w * 64) + countTrailingZeros(added);
+            added &= added - 1;
+            field.dist[source] = 0;
+            field.owner[source] = source;
+            seeds.emplace_back(0, source);
+        }
+    }
+    relax(field);
+}
+
+const std::pmr::vector<int>& Pathfinder::distanceToTeam(int teamId) {
+    if (teamId >= static_cast<int>(teamFields.size())) teamFields.resize(teamId + 1);
+    Field& field = teamFields[teamId];
+    const std::pmr::vector<uint64_t>& board = grid.getTeamBoard(teamId);
+    refreshCosts();
+
+    if (field.terrainVersion != grid.getTerrainVersion()) {
+        sourceCells.clear();
+        for (size_t w = 0; w < board.size(); ++w) {
+            uint64_t bits = board[w];
+            while (bits) {
+                sourceCells.push_back(static_cast<int>(w * 64) + countTrailingZeros(bits));
+                bits &= bits - 1;
+            }
+        }
+        rebuild(field, sourceCells);
+    }
+    else if (field.sources != board) {
+        patch(field, board);
+    }
+    field.sources = board;
+    return field.dist;
+}
+
+const std::pmr::vector<int>& Pathfinder::distanceToExit() {
+    refreshCosts();
+    if (exitField.terrainVersion != grid.getTerrainVersion()) {
+        int width = grid.getWidth();
+        int height = grid.getHeight();
+        sourceCells.clear();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (x == 0 || y == 0 || x == width - 1 || y == height - 1) sourceCells.push_back(y * width + x);
+            }
+        }
+        rebuild(exitField, sourceCells);
+    }
+    return exitField.dist;
+}
+
+bool Pathfinder::bestStep(const std::pmr::vector<int>& field, int x, int y, int preferDx, int preferDy, int& dx, int& dy) {
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    int best = field[y * width + x];
+    bool found = false;
+
+    auto consider = [&](int sx, int sy) {
+        int nx = x + sx;
+        int ny = y + sy;
+        if (nx < 0 || nx >= width || ny < 0 || ny >= height) return;
+        if (grid.getEnterCost(nx, ny) < 0 || grid.getCombatantAt(nx, ny)) return;
+        int d = field[ny * width + nx];
+        if (d < best) {
+            best = d;
+            dx = sx;
+            dy = sy;
+            found = true;
+        }
+    };
+    if (preferDx != 0 || preferDy != 0) consider(preferDx, preferDy);
+    for (int i = 0; i < 4; ++i) consider(STEP_X[i], STEP_Y[i]);
+    return found;
+}
+
+int Pathfinder::findPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>& path) {
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    path.clear();
+    if (gx < 0 || gx >= width || gy < 0 || gy >= height) return -1;
+
+    int cells = width * height;
+    int start = sy * width + sx;
+    int goal = gy * width + gx;
+    pathCost.assign(cells, UNREACHABLE);
+    pathParent.assign(cells, -1);
+    std::pmr::vector<int>& cost = pathCost;
+    std::pmr::vector<int>& parent = pathParent;
+    auto heuristic = [&](int cell) {
+        return (std::abs(cell % width - gx) + std::abs(cell / width - gy)) * COST_MOVE_BASE;
+    };
+    auto later = std::greater<std::pair<int, int>>();
+
+    frontier.clear();
+    cost[start] = 0;
+    frontier.emplace_back(heuristic(start), start);
+    while (!frontier.empty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), later);
+        int u = frontier.back().second;
+        int estimate = frontier.back().first;
+        frontier.pop_back();
+        if (estimate > cost[u] + heuristic(u)) continue;
+        if (u == goal) break;
+
+        int ux = u % width;
+        int uy = u / width;
+        for (int i = 0; i < 4; ++i) {
+            int vx = ux + STEP_X[i];
+            int vy = uy + STEP_Y[i];
+            if (vx < 0 || vx >= width || vy < 0 || vy >= height) continue;
+            int v = vy * width + vx;
+            int step = grid.getEnterCost(vx, vy);
+            if (step < 0 || (v != goal && grid.getCombatantAt(vx, vy))) continue;
+            if (cost[u] + step < cost[v]) {
+                cost[v] = cost[u] + step;
+                parent[v] = u;
+                frontier.emplace_back(cost[v] + heuristic(v), v);
+                std::push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+    }
+
+    if (cost[goal] == UNREACHABLE) return -1;
+    for (int cell = goal; cell != start; cell = parent[cell]) path.emplace_back(cell % width, cell / width);
+    std::reverse(path.begin(), path.end());
+    return cost[goal];
+}
@@ -0,0 +1,84 @@
+#ifndef PATHFINDING_H
+#define PATHFINDING_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include "rpg_system.h"
+
+// ==========================================
+// Pathfinder: terrain-aware routes over one Grid
+// ==========================================
+// Step costs follow Grid::getEnterCost (the engagement penalty is ignored).
+// Distance fields are cached and brought up to date lazily: a team's field is
+// patched from the cells its units left or entered since the last query, so
+// every AI unit moving against that team in a turn shares one computation.
+class Pathfinder {
+public:
+    static const int UNREACHABLE = 0x3FFFFFFF;
+
+    // Fields and scratch are allocated from the grid's memory resource.
+    explicit Pathfinder(Grid& grid);
+
+    // A* from (sx, sy) to (gx, gy) through cells that are passable and not
+    // occupied (the goal may be). Fills `path` with the cells after the start
+    // and returns the total tick cost, or -1 if there is no route.
+    int findPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>& path);
+
+    // Per-cell cost to walk onto the nearest living unit of `teamId`.
+    const std::pmr::vector<int>& distanceToTeam(int teamId);
+    // Per-cell cost to reach a border cell, from which one more step leaves the grid.
+    const std::pmr::vector<int>& distanceToExit();
+
+    // Picks the free neighbour of (x, y) with the lowest `field` value, if it
+    // improves on (x, y). Ties go to (preferDx, preferDy), then to the order
+    // (0,+1), (0,-1), (+1,0), (-1,0). Returns false when no step helps.
+    bool bestStep(const std::pmr::vector<int>& field, int x, int y, int preferDx, int preferDy, int& dx, int& dy);
+
+private:
+    struct Field {
+        std::pmr::vector<int> dist;
+        std::pmr::vector<int> owner;             // Source cell each distance was measured to
+        std::pmr::vector<uint64_t> sources;      // Team board the field was built from
+        int terrainVersion = -1;
+
+        // Allocator-aware, so fields in teamFields share its resource.
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+        explicit Field(const allocator_type& alloc = {}) : dist(alloc), owner(alloc), sources(alloc) {}
+        Field(const Field& other, const allocator_type& alloc)
+            : dist(other.dist, alloc), owner(other.owner, alloc), sources(other.sources, alloc),
+            terrainVersion(other.terrainVersion) {}
+        Field(Field&& other, const allocator_type& alloc)
+            : dist(std::move(other.dist), alloc), owner(std::move(other.owner), alloc),
+            sources(std::move(other.sources), alloc), terrainVersion(other.terrainVersion) {}
+    };
+
+    Grid& grid;
+    std::pmr::vector<Field> teamFields;
+    Field exitField;
+
+    // Grid::getEnterCost per cell, refreshed when the terrain version moves.
+    std::pmr::vector<int> enterCosts;
+    int costsVersion = -1;
+
+    // Dijkstra scratch, reused between updates. Step costs are small
+    // integers, so fields use a ring of buckets one longer than the largest
+    // step; `seeds` holds the starting cells, each at its own distance.
+    static const int RING_SIZE = 8;
+    static_assert(COST_MOVE_BASE + maxTerrainMoveCost() < RING_SIZE, "RING_SIZE must exceed the largest step cost");
+    std::pmr::vector<std::pmr::vector<int>> ring;
+    std::pmr::vector<std::pair<int, int>> seeds;     // (distance, cell)
+    std::pmr::vector<std::pair<int, int>> frontier;  // (estimate, cell) min-heap for A*
+    std::pmr::vector<int> stale;
+    std::pmr::vector<int> sourceCells;
+    std::pmr::vector<int> pathCost;
+    std::pmr::vector<int> pathParent;
+
+    void rebuild(Field& field, const std::pmr::vector<int>& sources);
+    void patch(Field& field, const std::pmr::vector<uint64_t>& sources);
+    void relax(Field& field);
+    void refreshCosts();
+};
+
+#endif
@@ -0,0 +1,504 @@
+#include "replay.h"
+#include "battle_file.h"
+#include "varint.h"
+#include "content_catalog.h"
+#include <fstream>
+
+namespace {
+
+const char REPLAY_MAGIC[4] = { 'R', 'P', 'G', 'R' };
+const uint64_t REPLAY_VERSION = 1;
+
+// Reads an enum stored as one byte, failing the stream if it is out of range.
+template <typename E>
+E readEnum(VarintReader& in, int count) {
+    uint8_t v = in.readByte();
+    if (v >= count) in.fail();
+    return in.failed() ? E() : static_cast<E>(v);
+}
+
+void writeWeapon(std::vector<uint8_t>& out, const Weapon& w) {
+    writeString(out, w.name);
+    writeSignedVarint(out, w.physicalAttack);
+    writeFloat(out, w.accuracy);
+    writeFloat(out, w.range);
+    writeSignedVarint(out, w.numberOfAttacks);
+    out.push_back(static_cast<uint8_t>(w.element));
+}
+
+Weapon readWeapon(VarintReader& in) {
+    Weapon w;
+    w.name = in.readString();
+    w.physicalAttack = static_cast<int>(in.readSigned());
+    w.accuracy = in.readFloat();
+    w.range = in.readFloat();
+    w.numberOfAttacks = static_cast<int>(in.readSigned());
+    w.element = readEnum<Element>(in, ELEMENT_COUNT);
+    return w;
+}
+
+void writeArmor(std::vector<uint8_t>& out, const Armor& a) {
+    writeString(out, a.name);
+    writeSignedVarint(out, a.damageResistance);
+    writeSignedVarint(out, a.damageThreshold);
+    writeFloat(out, a.evasion);
+    out.push_back(static_cast<uint8_t>(a.element));
+    writeSignedVarint(out, a.magicalDefense);
+}
+
+Armor readArmor(VarintReader& in) {
+    Armor a;
+    a.name = in.readString();
+    a.damageResistance = static_cast<int>(in.readSigned());
+    a.damageThreshold = static_cast<int>(in.readSigned());
+    a.evasion = in.readFloat();
+    a.element = readEnum<Element>(in, ELEMENT_COUNT);
+    a.magicalDefense = static_cast<int>(in.readSigned());
+    return a;
+}
+
+void writeSpell(std::vector<uint8_t>& out, const Spell& s) {
+    writeString(out, s.name);
+    writeSignedVarint(out, s.magicalAttack);
+    writeSignedVarint(out, s.mpCost);
+    writeFloat(out, s.range);
+    writeSignedVarint(out, s.duration);
+    out.push_back(static_cast<uint8_t>(s.element));
+    writeSignedVarint(out, s.aoe);
+    out.push_back(static_cast<uint8_t>(s.category));
+}
+
+Spell readSpell(VarintReader& in) {
+    Spell s("", 0, 0, 0.0f, 0, "None", 0, "Debuff");
+    s.name = in.readString();
+    s.magicalAttack = static_cast<int>(in.readSigned());
+    s.mpCost = static_cast<int>(in.readSigned());
+    s.range = in.readFloat();
+    s.duration = static_cast<int>(in.readSigned());
+    s.element = readEnum<Element>(in, ELEMENT_COUNT);
+    s.aoe = static_cast<int>(in.readSigned());
+    s.category = readEnum<SpellCategory>(in, static_cast<int>(SpellCategory::Count));
+    return s;
+}
+
+void writeItem(std::vector<uint8_t>& out, const Item& item, int quantity) {
+    writeString(out, item.name);
+    writeSignedVarint(out, quantity);
+    writeFloat(out, item.range);
+    out.push_back(static_cast<uint8_t>(item.category));
+    writeSignedVarint(out, item.potency);
+}
+
+Item readItem(VarintReader& in, int& quantity) {
+    Item item("", 0.0f, "None", 0);
+    item.name = in.readString();
+    quantity = static_cast<int>(in.readSigned());
+    item.range = in.readFloat();
+    item.category = readEnum<ItemCategory>(in, static_cast<int>(ItemCategory::Count));
+    item.potency = static_cast<int>(in.readSigned());
+    return item;
+}
+
+void writeBattle(std::vector<uint8_t>& out, const Battle& battle, BattleState& scratch) {
+    battle.saveState(scratch);
+    const Grid& grid = battle.grid;
+    int w = grid.getWidth();
+    int h = grid.getHeight();
+    writeVarint(out, w);
+    writeVarint(out, h);
+
+    // Terrain as (type, run length) pairs in row-major order.
+    for (int cell = 0; cell < w * h;) {
+        Terrain t = grid.getTerrain(cell % w, cell / w);
+        int run = 1;
+        while (cell + run < w * h && grid.getTerrain((cell + run) % w, (cell + run) / w) == t) run++;
+        out.push_back(static_cast<uint8_t>(t));
+        writeVarint(out, run);
+        cell += run;
+    }
+
+    const CombatantStore& rows = scratch.units;
+    writeVarint(out, battle.units.size());
+    for (int slot = 0; slot < static_cast<int>(battle.units.size()); ++slot) {
+        const Combatant& unit = *battle.units[slot];
+        writeString(out, unit.getName());
+        writeString(out, unit.getTeam());
+        writeWeapon(out, unit.getWeapon());
+        writeArmor(out, unit.getArmor());
+        const ContentCatalog& catalog = contentCatalog();
+        writeVarint(out, unit.getSpells().size());
+        for (SpellId spell : unit.getSpells()) writeSpell(out, catalog.spell(spell));
+        writeVarint(out, unit.getInventory().size());
+        for (const auto& stack : unit.getInventory()) writeItem(out, catalog.item(stack.item), stack.quantity);
+
+        writeSignedVarint(out, rows.currentHealth[slot]);
+        writeSignedVarint(out, rows.maxHealth[slot]);
+        writeSignedVarint(out, rows.currentMagicPoints[slot]);
+        writeSignedVarint(out, rows.maxMagicPoints[slot]);
+        writeSignedVarint(out, rows.initiative[slot]);
+        writeSignedVarint(out, rows.morale[slot]);
+        writeSignedVarint(out, rows.xPos[slot]);
+        writeSignedVarint(out, rows.yPos[slot]);
+        out.push_back(rows.flags[slot]);
+        const StatusList& statuses = rows.statuses[slot];
+        writeVarint(out, statuses.count);
+        for (int i = 0; i < statuses.count; ++i) {
+            out.push_back(static_cast<uint8_t>(statuses[i].type));
+            writeSignedVarint(out, statuses[i].durationTicks);
+            writeSignedVarint(out, statuses[i].potency);
+            writeVarint(out, statuses[i].stacks);
+        }
+        writeVarint(out, scratch.schedulePos[slot] + 1);
+    }
+
+    writeVarint(out, scratch.occupants.size());
+    for (int slot : scratch.occupants) writeVarint(out, slot);
+
+    writeVarint(out, scratch.rng.getSeed());
+    writeVarint(out, scratch.rng.getStream());
+    writeVarint(out, scratch.rng.tell());
+}
+
+std::unique_ptr<Battle> readBattle(VarintReader& in) {
+    uint64_t w = in.read();
+    uint64_t h = in.read();
+    if (in.failed() || w == 0 || h == 0 || w > 4096 || h > 4096) return nullptr;
+    int width = static_cast<int>(w);
+    int cells = width * static_cast<int>(h);
+    auto battle = std::make_unique<Battle>(width, static_cast<int>(h));
+
+    for (int cell = 0; cell < cells;) {
+        Terrain t = readEnum<Terrain>(in, static_cast<int>(Terrain::Count));
+        uint64_t run = in.read();
+        if (in.failed() || run == 0 || run > static_cast<uint64_t>(cells - cell)) return nullptr;
+        for (uint64_t i = 0; i < run; ++i, ++cell) {
+            if (t != Terrain::Open) battle->grid.setTerrain(cell % width, cell / width, t);
+        }
+    }
+
+    // Every unit takes well over one byte, which bounds the count.
+    uint64_t count = in.read();
+    if (in.failed() || count > in.remaining()) return nullptr;
+
+    // Units are spawned from their cold data first; their live rows are then
+    // written over a snapshot of the fresh battle, keeping its team ids.
+    CombatantStore live;
+    std::vector<int> schedulePos;
+    for (uint64_t slot = 0; slot < count; ++slot) {
+        std::string name = in.readString();
+        std::string team = in.readString();
+        Weapon weapon = readWeapon(in);
+        Armor armor = readArmor(in);
+        std::vector<Spell> spells;
+        uint64_t spellCount = in.read();
+        if (spellCount > in.remaining()) in.fail();
+        for (uint64_t i = 0; i < spellCount && !in.failed(); ++i) {
+            spells.push_back(readSpell(in));
+            // Area stencils are built per radius, so keep the radius on the map.
+            if (spells.back().aoe < 0 || spells.back().aoe > width + static_cast<int>(h)) in.fail();
+        }
+        std::vector<Item> items;
+        std::vector<int> quantities;
+        uint64_t itemCount = in.read();
+        if (itemCount > in.remaining()) in.fail();
+        for (uint64_t i = 0; i < itemCount && !in.failed(); ++i) {
+            int quantity;
+            items.push_back(readItem(in, quantity));
+            quantities.push_back(quantity);
+        }
+
+        int hp = static_cast<int>(in.readSigned());
+        int maxHp = static_cast<int>(in.readSigned());
+        int mp = static_cast<int>(in.readSigned());
+        int maxMp = static_cast<int>(in.readSigned());
+        int init = static_cast<int>(in.readSigned());
+        int morale = static_cast<int>(in.readSigned());
+        int row = live.addRow(0, hp, mp, init, morale);
+        live.maxHealth[row] = maxHp;
+        live.maxMagicPoints[row] = maxMp;
+        live.xPos[row] = static_cast<int>(in.readSigned());
+        live.yPos[row] = static_cast<int>(in.readSigned());
+        live.flags[row] = in.readByte();
+
+        std::vector<StatusEffect> statuses;
+        uint64_t statusCount = in.read();
+        if (statusCount > in.remaining()) in.fail();
+        for (uint64_t i = 0; i < statusCount && !in.failed(); ++i) {
+            StatusEffect e;
+            e.type = readEnum<StatusType>(in, StatusList::TYPE_COUNT);
+            int64_t duration = in.readSigned();
+            int64_t potency = in.readSigned();
+            uint64_t stacks = in.read();
+            // Checked before narrowing, so wrapped values cannot pass validStatuses.
+            if (duration != static_cast<int>(duration) || potency != static_cast<int>(potency) ||
+                stacks > StatusList::MAX_STACKS) {
+                in.fail();
+            }
+            e.durationTicks = static_cast<int>(duration);
+            e.potency = static_cast<int>(potency);
+            e.stacks = static_cast<int>(stacks);
+            statuses.push_back(e);
+        }
+        if (!validStatuses(statuses)) in.fail();
+        for (const StatusEffect& e : statuses) live.statuses[row].push(e);
+        schedulePos.push_back(static_cast<int>(in.read()) - 1);
+        if (in.failed()) return nullptr;
+
+        Combatant* c = battle->spawn(name, team, maxHp, maxMp, init, morale);
+        c->equipWeapon(weapon);
+        c->equipArmor(armor);
+        for (const auto& spell : spells) c->learnSpell(spell);
+        for (size_t i = 0; i < items.size(); ++i) c->addItem(items[i], quantities[i]);
+    }
+
+    BattleState state;
+    battle->saveState(state);
+    for (int slot = 0; slot < static_cast<int>(count); ++slot) {
+        int team = state.units.teamId[slot];
+        state.units.currentHealth[slot] = live.currentHealth[slot];
+        state.units.maxHealth[slot] = live.maxHealth[slot];
+        state.units.currentMagicPoints[slot] = live.currentMagicPoints[slot];
+        state.units.maxMagicPoints[slot] = live.maxMagicPoints[slot];
+        state.units.initiative[slot] = live.initiative[slot];
+        state.units.morale[slot] = live.morale[slot];
+        state.units.xPos[slot] = live.xPos[slot];
+        state.units.yPos[slot] = live.yPos[slot];
+        state.units.flags[slot] = live.flags[slot];
+        state.units.statuses[slot] = live.statuses[slot];
+        state.units.teamId[slot] = team;
+    }
+
+    std::vector<ScheduleSlot> schedule;
+    for (int slot = 0; slot < static_cast<int>(count); ++slot) {
+        schedule.push_back(ScheduleSlot{ schedulePos[slot], live.initiative[slot], live.isAlive(slot) });
+    }
+    if (!validSchedule(schedule)) return nullptr;
+    state.schedulePos = schedulePos;
+
+    uint64_t occupantCount = in.read();
+    if (in.failed() || occupantCount > count) return nullptr;
+    state.occupants.clear();
+    for (uint64_t i = 0; i < occupantCount; ++i) {
+        uint64_t slot = in.read();
+        if (in.failed() || slot >= count) return nullptr;
+        int x = state.units.xPos[slot];
+        int y = state.units.yPos[slot];
+        if (x < 0 || x >= width || y < 0 || y >= static_cast<int>(h)) return nullptr;
+        int& cell = state.cells[y * width + x];
+        if (cell != -1) return nullptr;
+        cell = static_cast<int>(slot);
+        state.occupants.push_back(static_cast<int>(slot));
+    }
+
+    uint64_t seed = in.read();
+    uint64_t stream = in.read();
+    uint64_t position = in.read();
+    if (in.failed()) return nullptr;
+    state.rng.reseed(seed, stream);
+    state.rng.seek(position);
+
+    battle->restoreState(state);
+    return battle;
+}
+
+std::unique_ptr<Battle> readHeader(VarintReader& in) {
+    for (char c : REPLAY_MAGIC) {
+        if (in.readByte() != static_cast<uint8_t>(c)) return nullptr;
+    }
+    if (in.read() != REPLAY_VERSION || in.failed()) return nullptr;
+    return readBattle(in);
+}
+
+// FNV-1a over 64-bit words.
+struct Checksum {
+    uint64_t h = 0xCBF29CE484222325ull;
+
+    void add(uint64_t v) { h = (h ^ v) * 0x100000001B3ull; }
+    template <typename Allocator>
+    void add(const std::vector<int, Allocator>& values) {
+        add(values.size());
+        for (int v : values) add(static_cast<uint64_t>(static_cast<int64_t>(v)));
+    }
+};
+
+} // namespace
+
+uint64_t checksumState(const BattleState& state) {
+    Checksum sum;
+    const CombatantStore& u = state.units;
+    sum.add(u.currentHealth);
+    sum.add(u.maxHealth);
+    sum.add(u.currentMagicPoints);
+    sum.add(u.maxMagicPoints);
+    sum.add(u.initiative);
+    sum.add(u.morale);
+    sum.add(u.xPos);
+    sum.add(u.yPos);
+    for (size_t slot = 0; slot < u.flags.size(); ++slot) {
+        sum.add(u.flags[slot]);
+        const StatusList& statuses = u.statuses[slot];
+        sum.add(statuses.count);
+        for (int i = 0; i < statuses.count; ++i) {
+            const StatusEffect& e = statuses[i];
+            sum.add(static_cast<uint64_t>(e.type));
+            sum.add(static_cast<uint64_t>(static_cast<int64_t>(e.durationTicks)));
+            sum.add(static_cast<uint64_t>(static_cast<int64_t>(e.potency)));
+            sum.add(static_cast<uint64_t>(e.stacks));
+        }
+    }
+    sum.add(state.schedulePos);
+    sum.add(state.rng.getSeed());
+    sum.add(state.rng.getStream());
+    sum.add(state.rng.tell());
+    sum.add(state.cells);
+    sum.add(state.occupants);
+    sum.add(state.itemQuantities);
+    return sum.h;
+}
+
+// ==========================================
+// Recording
+// ==========================================
+ReplayRecorder::ReplayRecorder(int interval) : checksumInterval(interval > 0 ? interval : 1) {}
+
+void ReplayRecorder::begin(const Battle& battle) {
+    data.clear();
+    turns = 0;
+    for (char c : REPLAY_MAGIC) data.push_back(static_cast<uint8_t>(c));
+    writeVarint(data, REPLAY_VERSION);
+    writeBattle(data, battle, scratch);
+}
+
+void ReplayRecorder::recordTurn(const Combatant* actor, const BattleAction& action, const Battle& battle) {
+    data.push_back(static_cast<uint8_t>(action.type));
+    writeVarint(data, actor->getSlot());
+    switch (action.type) {
+    case ActionType::Attack:
+        writeVarint(data, action.target);
+        break;
+    case ActionType::Spell:
+    case ActionType::Item:
+        writeVarint(data, action.target);
+        writeVarint(data, action.index);
+        break;
+    case ActionType::Move:
+    case ActionType::Panic:
+        data.push_back(static_cast<uint8_t>((action.dx + 1) * 3 + (action.dy + 1)));
+        break;
+    case ActionType::Guard:
+    case ActionType::Wait:
+        break;
+    }
+    if (++turns % checksumInterval == 0) writeChecksum(battle);
+}
+
+void ReplayRecorder::finish(const Battle& battle) {
+    writeChecksum(battle);
+    data.push_back(REPLAY_END);
+}
+
+void ReplayRecorder::writeChecksum(const Battle& battle) {
+    battle.saveState(scratch);
+    data.push_back(REPLAY_CHECKSUM);
+    writeFixed(data, checksumState(scratch), 8);
+}
+
+// ==========================================
+// Playback
+// ==========================================
+std::unique_ptr<Battle> loadReplayBattle(const std::vector<uint8_t>& data) {
+    VarintReader in(data.data(), data.size());
+    return readHeader(in);
+}
+
+ReplayResult playReplay(const std::vector<uint8_t>& data, CombatEventSink* sink) {
+    ReplayResult result;
+    VarintReader in(data.data(), data.size());
+    auto battle = readHeader(in);
+    if (!battle) {
+        result.error = "malformed replay header";
+        return result;
+    }
+    if (sink) battle->manager.setEventSink(sink);
+
+    const std::pmr::vector<Combatant*>& participants = battle->manager.getParticipants();
+    const int count = static_cast<int>(participants.size());
+    BattleState scratch;
+    auto fail = [&](const std::string& why) {
+        result.error = "turn " + std::to_string(result.turns) + ": " + why;
+        return result;
+    };
+
+    while (true) {
+        uint8_t tag = in.readByte();
+        if (in.failed()) return fail("stream ends without an end marker");
+        if (tag == REPLAY_END) break;
+
+        if (tag == REPLAY_CHECKSUM) {
+            uint64_t expected = in.readFixed(8);
+            if (in.failed()) return fail("truncated checksum");
+            battle->saveState(scratch);
+            if (checksumState(scratch) != expected) return fail("state checksum mismatch");
+            result.checksums++;
+            continue;
+        }
+        if (tag > static_cast<uint8_t>(ActionType::Panic)) return fail("unknown record");
+
+        BattleAction action;
+        action.type = static_cast<ActionType>(tag);
+        uint64_t slot = in.read();
+        switch (action.type) {
+        case ActionType::Attack:
+            action.target = static_cast<int>(in.read());
+            break;
+        case ActionType::Spell:
+        case ActionType::Item:
+            action.target = static_cast<int>(in.read());
+            action.index = static_cast<int>(in.read());
+            break;
+        case ActionType::Move:
+        case ActionType::Panic: {
+            uint8_t step = in.readByte();
+            if (step >= 9) in.fail();
+            action.dx = step / 3 - 1;
+            action.dy = step % 3 - 1;
+            break;
+        }
+        case ActionType::Guard:
+        case ActionType::Wait:
+            break;
+        }
+        if (in.failed()) return fail("truncated turn");
+
+        Combatant* actor = battle->manager.getNextActiveCombatant();
+        if (!actor || static_cast<uint64_t>(actor->getSlot()) != slot) return fail("recorded actor is not next in turn order");
+        bool targeted = action.type == ActionType::Attack || action.type == ActionType::Spell ||
+            action.type == ActionType::Item;
+        if (targeted && (action.target < 0 || action.target >= count)) return fail("target out of range");
+        if (action.type == ActionType::Spell && (action.index < 0 || action.index >= static_cast<int>(actor->getSpells().size())))
+            return fail("spell index out of range");
+        if (action.type == ActionType::Item && (action.index < 0 || action.index >= static_cast<int>(actor->getInventory().size())))
+            return fail("item index out of range");
+
+        actor->startTurn();
+        playTurn(actor, action, battle->manager, battle->grid);
+        result.turns++;
+    }
+
+    result.winner = battle->manager.getWinner();
+    result.ok = true;
+    return result;
+}
+
+bool writeReplayFile(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+bool readReplayFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
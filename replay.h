@@ -0,0 +1,72 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "scenario.h"
+#include "battle_action.h"
+
+// ==========================================
+// Battle Replays
+// ==========================================
+// A replay is a varint stream (see varint.h):
+//   "RPGR", version
+//   battle: grid size, terrain runs, then per unit its name, team, weapon,
+//           armor, spells and items followed by its live row (HP, MP,
+//           initiative, morale, position, flags, statuses, heap position);
+//           grid occupants and the RNG (seed, stream, position)
+//   records: a turn is its ActionType byte, the actor's slot and whichever of
+//            target / index / step that type uses; REPLAY_CHECKSUM is
+//            followed by a 64-bit state checksum; REPLAY_END closes the stream.
+// Only decisions are stored: dice rolls come from the recorded RNG, so a
+// typical turn costs two or three bytes.
+const uint8_t REPLAY_CHECKSUM = 0x40;
+const uint8_t REPLAY_END = 0x7F;
+
+// Order-sensitive 64-bit hash of everything in a snapshot.
+uint64_t checksumState(const BattleState& state);
+
+class ReplayRecorder {
+private:
+    std::vector<uint8_t> data;
+    BattleState scratch;
+    int checksumInterval;
+    long long turns = 0;
+
+    void writeChecksum(const Battle& battle);
+
+public:
+    // A checksum is written after every `checksumInterval` turns and at the end.
+    explicit ReplayRecorder(int checksumInterval = 32);
+
+    // Starts a new replay of `battle` from its current state.
+    void begin(const Battle& battle);
+    // Records a turn after it has been played.
+    void recordTurn(const Combatant* actor, const BattleAction& action, const Battle& battle);
+    void finish(const Battle& battle);
+
+    const std::vector<uint8_t>& getData() const { return data; }
+};
+
+struct ReplayResult {
+    bool ok = false;
+    long long turns = 0;
+    long long checksums = 0;
+    std::string winner;         // getWinner() once the stream ends
+    std::string error;          // Set when !ok
+};
+
+// Rebuilds the battle stored at the head of a replay, or returns null if
+// the header is malformed.
+std::unique_ptr<Battle> loadReplayBattle(const std::vector<uint8_t>& data);
+
+// Rebuilds the battle and re-drives every recorded turn through playTurn,
+// checking that each actor is the one the scheduler picks and that every
+// checksum matches. `sink`, if set, narrates the replay.
+ReplayResult playReplay(const std::vector<uint8_t>& data, CombatEventSink* sink = nullptr);
+
+bool writeReplayFile(const std::string& path, const std::vector<uint8_t>& data);
+bool readReplayFile(const std::string& path, std::vector<uint8_t>& data);
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Supplies the outcome of each draw in place of the generator, so a solver
+// can walk every way a turn can go instead of sampling one (battle_solver.h).
+class DrawScript {
+public:
+    virtual ~DrawScript() = default;
+    virtual int drawInt(int min, int max) = 0;
+    virtual bool drawChance(float probability) = 0;
+};
+
+// ==========================================
+// BattleRng: Philox4x32-10 counter-based generator
+// ==========================================
+// The whole state is (seed, stream, block counter), so every battle can own one,
+// parallel workers can jump straight to stream N without locking, and a battle
+// is replayed bit-exactly by re-creating the generator with the same seed/stream.
+class BattleRng {
+private:
+    uint32_t key[2];
+    uint32_t counter[4];   // [0..1] block index, [2..3] stream
+    uint32_t block[4];
+    int blockIndex = 4;    // 4 = current block consumed
+    DrawScript* script = nullptr;
+
+    static uint32_t mulhilo(uint32_t a, uint32_t b, uint32_t& hi) {
+        uint64_t product = static_cast<uint64_t>(a) * b;
+        hi = static_cast<uint32_t>(product >> 32);
+        return static_cast<uint32_t>(product);
+    }
+
+    void generateBlock() {
+        uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+        uint32_t k[2] = { key[0], key[1] };
+        for (int round = 0; round < 10; ++round) {
+            uint32_t hi0, hi1;
+            uint32_t lo0 = mulhilo(0xD2511F53u, c[0], hi0);
+            uint32_t lo1 = mulhilo(0xCD9E8D57u, c[2], hi1);
+            c[0] = hi1 ^ c[1] ^ k[0];
+            c[1] = lo1;
+            c[2] = hi0 ^ c[3] ^ k[1];
+            c[3] = lo0;
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        for (int i = 0; i < 4; ++i) block[i] = c[i];
+        blockIndex = 0;
+        if (++counter[0] == 0) ++counter[1];
+    }
+
+public:
+    explicit BattleRng(uint64_t seed = 0, uint64_t stream = 0) { reseed(seed, stream); }
+
+    // Restarts the generator at the beginning of `stream` under `seed`.
+    void reseed(uint64_t seed, uint64_t stream) {
+        key[0] = static_cast<uint32_t>(seed);
+        key[1] = static_cast<uint32_t>(seed >> 32);
+        counter[0] = 0;
+        counter[1] = 0;
+        counter[2] = static_cast<uint32_t>(stream);
+        counter[3] = static_cast<uint32_t>(stream >> 32);
+        blockIndex = 4;
+    }
+
+    uint64_t getSeed() const { return (static_cast<uint64_t>(key[1]) << 32) | key[0]; }
+    uint64_t getStream() const { return (static_cast<uint64_t>(counter[3]) << 32) | counter[2]; }
+
+    // Number of 32-bit outputs drawn since the start of the stream.
+    uint64_t tell() const {
+        uint64_t blocks = (static_cast<uint64_t>(counter[1]) << 32) | counter[0];
+        return blocks * 4 - (4 - blockIndex);
+    }
+
+    // Jumps to output `position` of the current stream.
+    void seek(uint64_t position) {
+        uint64_t blocks = position / 4;
+        counter[0] = static_cast<uint32_t>(blocks);
+        counter[1] = static_cast<uint32_t>(blocks >> 32);
+        blockIndex = 4;
+        if (position % 4 != 0) {
+            generateBlock();
+            blockIndex = static_cast<int>(position % 4);
+        }
+    }
+
+    // While a script is set, nextInt and chance ask it instead of drawing.
+    void setScript(DrawScript* drawScript) { script = drawScript; }
+
+    uint32_t nextU32() {
+        if (blockIndex == 4) generateBlock();
+        return block[blockIndex++];
+    }
+
+    // Uniform integer in [min, max] (Lemire's unbiased multiply-shift).
+    int nextInt(int min, int max) {
+        if (script) return script->drawInt(min, max);
+        uint32_t range = static_cast<uint32_t>(max - min) + 1u;
+        if (range == 0) return static_cast<int>(nextU32());
+        uint64_t m = static_cast<uint64_t>(nextU32()) * range;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < range) {
+            uint32_t threshold = (0u - range) % range;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(nextU32()) * range;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return min + static_cast<int>(m >> 32);
+    }
+
+    // Uniform float in [0, 1) with 24 bits of precision.
+    float nextFloat() {
+        return (nextU32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // True when nextFloat() <= probability; consumes exactly that one draw.
+    bool chance(float probability) {
+        if (script) return script->drawChance(probability);
+        return nextFloat() <= probability;
+    }
+
+    // The exact odds chance(probability) returns true, counting the 2^24
+    // values nextFloat can produce.
+    static double chanceOdds(float probability) {
+        if (probability < 0.0f) return 0.0;
+        if (probability >= 1.0f) return 1.0;
+        uint32_t steps = static_cast<uint32_t>(static_cast<double>(probability) * 16777216.0) + 1u;
+        return steps / 16777216.0;
+    }
+};
+
+#endif
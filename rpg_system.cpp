@@ -1,47 +1,67 @@
 #include "rpg_system.h"
-#include <random>
+#include "battle_state.h"
+#include "pathfinding.h"
+#include "content_catalog.h"
+#include "battle_arena.h"
 #include <algorithm> 
 #include <limits>    
 #include <cmath>     
-
-// Helper functions for Random Number Generation
-int getRandomInt(int min, int max) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(min, max);
-    return dis(gen);
-}
-
-float getRandomFloat(float min, float max) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(min, max);
-    return dis(gen);
-}
+#include <mutex>
 
 float getDistance(int x1, int y1, int x2, int y2) {
     return std::sqrt(std::pow(x2 - x1, 2) + std::pow(y2 - y1, 2));
 }
 
 // ==========================================
-// Elemental Relationships
+// Content Name Interning
 // ==========================================
-float getElementalMultiplier(const std::string& atk, const std::string& def) {
-    if (atk == def && atk != "None" && atk != "") return 0.5f;
+static const char* const ELEMENT_NAMES[] = {
+    "None", "Physical", "Magical", "Standard",
+    "Fire", "Ice", "Psi", "Bio", "Electricity", "Earth", "Wind", "Poison", "Acid", "Naughtium",
+    "Reflect"
+};
+static const char* const SPELL_CATEGORY_NAMES[] = { "Debuff", "Buff" };
+static const char* const ITEM_CATEGORY_NAMES[] = { "None", "Healing", "RestoreMP", "Buff", "Debuff" };
+static const char* const STATUS_NAMES[] = { "Burn", "Acid" };
+static_assert(sizeof(SPELL_CATEGORY_NAMES) / sizeof(*SPELL_CATEGORY_NAMES) == static_cast<int>(SpellCategory::Count), "SPELL_CATEGORY_NAMES out of date");
+static_assert(sizeof(ITEM_CATEGORY_NAMES) / sizeof(*ITEM_CATEGORY_NAMES) == static_cast<int>(ItemCategory::Count), "ITEM_CATEGORY_NAMES out of date");
+
+template <typename Enum, size_t N>
+static Enum lookupName(const char* const (&names)[N], const std::string& name) {
+    for (size_t i = 0; i < N; ++i) {
+        if (name == names[i]) return static_cast<Enum>(i);
+    }
+    return static_cast<Enum>(0);
+}
+
+Element elementFromName(const std::string& name) { return lookupName<Element>(ELEMENT_NAMES, name); }
+SpellCategory spellCategoryFromName(const std::string& name) { return lookupName<SpellCategory>(SPELL_CATEGORY_NAMES, name); }
+ItemCategory itemCategoryFromName(const std::string& name) { return lookupName<ItemCategory>(ITEM_CATEGORY_NAMES, name); }
 
-    if ((atk == "Fire" && def == "Ice") || (atk == "Ice" && def == "Fire")) return 2.0f;
-    if ((atk == "Psi" && def == "Bio") || (atk == "Bio" && def == "Psi")) return 2.0f;
-    if ((atk == "Electricity" && def == "Earth") || (atk == "Earth" && def == "Electricity")) return 2.0f;
-    if ((atk == "Wind" && def == "Poison") || (atk == "Poison" && def == "Wind")) return 2.0f;
+const char* elementName(Element element) { return ELEMENT_NAMES[static_cast<int>(element)]; }
+const char* spellCategoryName(SpellCategory category) { return SPELL_CATEGORY_NAMES[static_cast<int>(category)]; }
+const char* itemCategoryName(ItemCategory category) { return ITEM_CATEGORY_NAMES[static_cast<int>(category)]; }
+const char* statusName(StatusType type) { return STATUS_NAMES[static_cast<int>(type)]; }
 
-    return 1.0f;
+// ==========================================
+// Team Interning
+// ==========================================
+int internTeam(std::string_view name) {
+    static std::mutex lock;
+    static std::vector<std::string> teams;
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < teams.size(); ++i) {
+        if (teams[i] == name) return static_cast<int>(i);
+    }
+    teams.emplace_back(name);
+    return static_cast<int>(teams.size()) - 1;
 }
 
 // ==========================================
 // Item Implementation
 // ==========================================
-Item::Item(std::string n, int qty, float rng, std::string cat, int pot)
-    : name(n), quantity(qty), range(rng), category(cat), potency(pot) {
+Item::Item(std::string n, float rng, std::string cat, int pot)
+    : name(n), range(rng), category(itemCategoryFromName(cat)), potency(pot) {
 }
 
 // ==========================================
@@ -49,26 +69,26 @@ Item::Item(std::string n, int qty, float rng, std::string cat, int pot)
 // ==========================================
 Armor::Armor(std::string n, int dr, int dt, float eva, std::string elem, int magDef)
     : name(n), damageResistance(dr), damageThreshold(dt),
-    evasion(eva), elementType(elem), magicalDefense(magDef)
+    evasion(eva), element(elementFromName(elem)), magicalDefense(magDef)
 {
-    if (elementType != "Wind") this->evasion = 0.0f;
-    if (elementType != "Earth") this->damageThreshold = 0;
-    if (elementType != "Naughtium") this->magicalDefense = 0;
+    if (element != Element::Wind) this->evasion = 0.0f;
+    if (element != Element::Earth) this->damageThreshold = 0;
+    if (element != Element::Naughtium) this->magicalDefense = 0;
 }
 
 Armor::Armor()
-    : name("Naked"), damageResistance(0), damageThreshold(0), evasion(0), elementType("Standard"), magicalDefense(0) {
+    : name("Naked"), damageResistance(0), damageThreshold(0), evasion(0), element(Element::Standard), magicalDefense(0) {
 }
 
 // ==========================================
 // Weapon Implementation
 // ==========================================
 Weapon::Weapon(std::string n, int atk, float acc, float rng, int num, std::string elem)
-    : name(n), physicalAttack(atk), accuracy(acc), range(rng), numberOfAttacks(num), elementType(elem) {
+    : name(n), physicalAttack(atk), accuracy(acc), range(rng), numberOfAttacks(num), element(elementFromName(elem)) {
 }
 
 Weapon::Weapon()
-    : name("Fists"), physicalAttack(1), accuracy(1.0f), range(1.0f), numberOfAttacks(1), elementType("Physical") {
+    : name("Fists"), physicalAttack(1), accuracy(1.0f), range(1.0f), numberOfAttacks(1), element(Element::Physical) {
 }
 
 // ==========================================
@@ -76,267 +96,534 @@ Weapon::Weapon()
 // ==========================================
 // Updated Constructor
 Spell::Spell(std::string n, int matk, int cost, float rng, int dur, std::string elem, int area, std::string cat)
-    : name(n), magicalAttack(matk), mpCost(cost), range(rng), duration(dur), elementType(elem), aoe(area), category(cat) {
+    : name(n), magicalAttack(matk), mpCost(cost), range(rng), duration(dur), element(elementFromName(elem)), aoe(area), category(spellCategoryFromName(cat)) {
 }
 
 // ==========================================
-// Combatant Implementation
+// Combatant Store Implementation
 // ==========================================
-Combatant::Combatant(std::string n, std::string teamName, int hp, int mp, int init, int mor)
-    : name(n), team(teamName), maxHealth(hp), currentHealth(hp),
-    maxMagicPoints(mp), currentMagicPoints(mp),
-    initiative(init), morale(mor) {
-}
-
-std::string Combatant::getName() const { return name; }
-std::string Combatant::getTeam() const { return team; }
-int Combatant::getHP() const { return currentHealth; }
-int Combatant::getMP() const { return currentMagicPoints; }
-int Combatant::getX() const { return xPos; }
-int Combatant::getY() const { return yPos; }
-int Combatant::getInitiative() const { return initiative; }
-int Combatant::getMorale() const { return morale; }
-bool Combatant::isAlive() const { return currentHealth > 0 && !fled; }
-bool Combatant::isGuarding() const { return guarding; }
-bool Combatant::hasFled() const { return fled; }
-bool Combatant::isBroken() const { return morale < 0; }
-
-const Armor& Combatant::getArmor() const { return equippedArmor; }
+CombatantStore::CombatantStore(std::pmr::memory_resource* memory)
+    : currentHealth(memory), maxHealth(memory), currentMagicPoints(memory), maxMagicPoints(memory),
+    initiative(memory), morale(memory), xPos(memory), yPos(memory), teamId(memory), flags(memory),
+    statuses(memory) {
+}
 
-int Combatant::getEffectiveDR() const {
-    int dr = equippedArmor.damageResistance;
-    for (const auto& s : statuses) {
-        if (s.name == "Acid") {
-            dr -= s.potency;
+int CombatantStore::size() const { return static_cast<int>(currentHealth.size()); }
+
+int CombatantStore::addRow(int team, int hp, int mp, int init, int mor) {
+    currentHealth.push_back(hp);
+    maxHealth.push_back(hp);
+    currentMagicPoints.push_back(mp);
+    maxMagicPoints.push_back(mp);
+    initiative.push_back(init);
+    morale.push_back(mor);
+    xPos.push_back(-1);
+    yPos.push_back(-1);
+    teamId.push_back(team);
+    flags.push_back(0);
+    statuses.emplace_back();
+    return size() - 1;
+}
+
+int CombatantStore::copyRow(const CombatantStore& src, int srcSlot) {
+    int row = addRow(src.teamId[srcSlot], src.maxHealth[srcSlot], src.maxMagicPoints[srcSlot],
+        src.initiative[srcSlot], src.morale[srcSlot]);
+    currentHealth[row] = src.currentHealth[srcSlot];
+    currentMagicPoints[row] = src.currentMagicPoints[srcSlot];
+    xPos[row] = src.xPos[srcSlot];
+    yPos[row] = src.yPos[srcSlot];
+    flags[row] = src.flags[srcSlot];
+    statuses[row] = src.statuses[srcSlot];
+    return row;
+}
+
+// ==========================================
+// Status List Implementation
+// ==========================================
+static_assert(StatusList::TYPE_COUNT == static_cast<int>(StatusType::Acid) + 1, "StatusList::TYPE_COUNT out of date");
+
+StatusList::StatusList(const StatusList& other, const allocator_type& alloc)
+    : overflow(other.overflow, alloc), count(other.count) {
+    for (int i = 0; i < CAPACITY; ++i) entries[i] = other.entries[i];
+    for (int t = 0; t < TYPE_COUNT; ++t) potencyTotal[t] = other.potencyTotal[t];
+}
+
+void StatusList::add(const StatusEffect& effect) {
+    if (count == 0 || (*this)[count - 1].type != effect.type || (*this)[count - 1].durationTicks != effect.durationTicks) {
+        push(effect);
+        return;
+    }
+    StatusEffect& last = (*this)[count - 1];
+    last.potency += effect.potency;
+    last.stacks += effect.stacks;
+    potencyTotal[static_cast<int>(effect.type)] += effect.potency;
+}
+
+void StatusList::push(const StatusEffect& effect) {
+    if (count < CAPACITY) entries[count] = effect;
+    else overflow.push_back(effect);
+    ++count;
+    potencyTotal[static_cast<int>(effect.type)] += effect.potency;
+}
+
+void StatusList::clear() {
+    overflow.clear();
+    for (int t = 0; t < TYPE_COUNT; ++t) potencyTotal[t] = 0;
+    count = 0;
+}
+
+int StatusList::advance(int ticks, int& hp, StatusEffect* expired) {
+    if (ticks <= 0 || count == 0) return 0;
+
+    // Works on one contiguous array: the inline entries, or a per-thread copy
+    // of the whole list once it has spilled (written back at the end).
+    StatusEffect* list = entries;
+    int inlineScratch[3 * CAPACITY];
+    int* scratch = inlineScratch;
+    if (count > CAPACITY) {
+        thread_local std::vector<StatusEffect> spilledList;
+        thread_local std::vector<int> spilledScratch;
+        spilledList.assign(entries, entries + CAPACITY);
+        spilledList.insert(spilledList.end(), overflow.begin(), overflow.end());
+        spilledScratch.resize(3 * static_cast<size_t>(count));
+        list = spilledList.data();
+        scratch = spilledScratch.data();
+    }
+
+    // A status is processed on ticks 1..life and fades at the end of tick life.
+    int* life = scratch;
+    int* burns = scratch + count;
+    int burnCount = 0;
+    long long rate = 0;
+    for (int i = 0; i < count; ++i) {
+        life[i] = list[i].durationTicks > 1 ? list[i].durationTicks : 1;
+        if (list[i].type == StatusType::Burn) {
+            burns[burnCount++] = i;
+            if (list[i].potency > 0) rate += list[i].potency;
+        }
+    }
+
+    // Find the tick on which Burn damage kills; ticking stops after it. The
+    // damage rate only falls as burns run out, so walk burns by lifetime.
+    int span = ticks;
+    if (hp <= 0) {
+        span = 1;
+    }
+    else if (rate > 0) {
+        for (int i = 1; i < burnCount; ++i) {
+            int b = burns[i];
+            int j = i;
+            for (; j > 0 && life[burns[j - 1]] > life[b]; --j) burns[j] = burns[j - 1];
+            burns[j] = b;
         }
+        long long remaining = hp;
+        int t = 0;
+        for (int k = 0; k < burnCount && t < ticks; ++k) {
+            int segmentEnd = life[burns[k]] < ticks ? life[burns[k]] : ticks;
+            if (segmentEnd > t && rate > 0) {
+                long long segmentDamage = rate * (segmentEnd - t);
+                if (segmentDamage >= remaining) {
+                    span = t + static_cast<int>((remaining + rate - 1) / rate);
+                    break;
+                }
+                remaining -= segmentDamage;
+                t = segmentEnd;
+            }
+            if (list[burns[k]].potency > 0) rate -= list[burns[k]].potency;
+        }
+    }
+
+    long long burnDamage = 0;
+    bool burned = false;
+    for (int k = 0; k < burnCount; ++k) {
+        const StatusEffect& burn = list[burns[k]];
+        int activeTicks = life[burns[k]] < span ? life[burns[k]] : span;
+        if (burn.potency > 0) burnDamage += static_cast<long long>(burn.potency) * activeTicks;
+        burned = true;
     }
+    if (burned) {
+        hp = (burnDamage >= hp) ? 0 : hp - static_cast<int>(burnDamage);
+    }
+
+    // Statuses fade tick by tick, in list order within a tick.
+    int* faded = scratch + 2 * count;
+    int fadedCount = 0;
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (life[i] <= span) {
+            int j = fadedCount++;
+            for (; j > 0 && life[faded[j - 1]] > life[i]; --j) faded[j] = faded[j - 1];
+            faded[j] = i;
+        }
+    }
+    for (int k = 0; k < fadedCount; ++k) {
+        const StatusEffect& e = list[faded[k]];
+        expired[k] = e;
+        potencyTotal[static_cast<int>(e.type)] -= e.potency;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (life[i] > span) {
+            list[kept] = list[i];
+            list[kept].durationTicks -= span;
+            ++kept;
+        }
+    }
+    count = kept;
+    if (list != entries) {
+        for (int i = 0; i < CAPACITY && i < kept; ++i) entries[i] = list[i];
+        overflow.assign(list + (kept < CAPACITY ? kept : CAPACITY), list + kept);
+    }
+    return fadedCount;
+}
+
+// ==========================================
+// Combatant Implementation
+// ==========================================
+Combatant::Combatant(std::string_view n, std::string_view teamName, int hp, int mp, int init, int mor,
+    std::pmr::memory_resource* memory)
+    : memory(memory), name(n, memory), team(teamName, memory), ownStore(newObject<CombatantStore>(memory, memory)),
+    knownSpells(memory), inventory(memory) {
+    store = ownStore;
+    slot = store->addRow(internTeam(teamName), hp, mp, init, mor);
+}
+
+Combatant::~Combatant() { deleteObject(memory, ownStore); }
+
+const std::pmr::string& Combatant::getName() const { return name; }
+const std::pmr::string& Combatant::getTeam() const { return team; }
+int Combatant::getTeamId() const { return store->teamId[slot]; }
+int Combatant::getHP() const { return store->currentHealth[slot]; }
+int Combatant::getMaxHP() const { return store->maxHealth[slot]; }
+int Combatant::getMP() const { return store->currentMagicPoints[slot]; }
+int Combatant::getMaxMP() const { return store->maxMagicPoints[slot]; }
+int Combatant::getX() const { return store->xPos[slot]; }
+int Combatant::getY() const { return store->yPos[slot]; }
+int Combatant::getInitiative() const { return store->initiative[slot]; }
+int Combatant::getMorale() const { return store->morale[slot]; }
+bool Combatant::isAlive() const { return store->isAlive(slot); }
+bool Combatant::isGuarding() const { return (store->flags[slot] & CombatantStore::FLAG_GUARDING) != 0; }
+bool Combatant::hasFled() const { return (store->flags[slot] & CombatantStore::FLAG_FLED) != 0; }
+bool Combatant::isBroken() const { return store->morale[slot] < 0; }
+
+const Armor& Combatant::getArmor() const { return contentCatalog().armor(armorId); }
+
+int Combatant::getEffectiveDR() const {
+    int dr = getArmor().damageResistance - store->statuses[slot].totalPotency(StatusType::Acid);
     if (dr < -80) dr = -80;
     return dr;
 }
 
-const std::vector<Item>& Combatant::getInventory() const { return inventory; }
-const std::vector<Spell>& Combatant::getSpells() const { return knownSpells; }
-const Weapon& Combatant::getWeapon() const { return equippedWeapon; }
+int Combatant::getStatusPotency(StatusType type) const { return store->statuses[slot].totalPotency(type); }
 
-void Combatant::setPosition(int x, int y) { xPos = x; yPos = y; }
-void Combatant::equipArmor(const Armor& armor) { equippedArmor = armor; }
-void Combatant::equipWeapon(const Weapon& weapon) { equippedWeapon = weapon; }
-void Combatant::learnSpell(const Spell& spell) { knownSpells.push_back(spell); }
+MatchupTable& Combatant::matchups() const {
+    if (scheduler) return scheduler->getMatchups();
+    static thread_local MatchupTable unscheduled;
+    return unscheduled;
+}
 
-void Combatant::addItem(const Item& item) {
-    for (auto& i : inventory) {
-        if (i.name == item.name) {
-            i.quantity += item.quantity;
-            return;
-        }
+const Weapon& Combatant::getWeapon() const { return contentCatalog().weapon(weaponId); }
+const Spell& Combatant::getSpell(int spellIndex) const { return contentCatalog().spell(knownSpells[spellIndex]); }
+const Item& Combatant::getItem(int itemIndex) const { return contentCatalog().item(inventory[itemIndex].item); }
+
+int Combatant::findItem(ItemId item) const {
+    for (size_t i = 0; i < inventory.size(); ++i) {
+        if (inventory[i].item == item) return static_cast<int>(i);
     }
-    inventory.push_back(item);
+    return -1;
 }
 
+void Combatant::setPosition(int x, int y) { store->xPos[slot] = x; store->yPos[slot] = y; }
+void Combatant::setEventSink(CombatEventSink* sink) { eventSink = normalizeSink(sink); }
+CombatEventSink* Combatant::getEventSink() const { return eventSink; }
+
+int Combatant::getSlot() const { return slot; }
+
+void Combatant::moveToStore(CombatantStore& target, BattleManager* manager) {
+    int newSlot = target.copyRow(*store, slot);
+    store = &target;
+    slot = newSlot;
+    deleteObject(memory, ownStore);
+    ownStore = nullptr;
+    scheduler = manager;
+}
+
+void Combatant::setGrid(Grid* g) { grid = g; }
+
+void Combatant::notifyStateChanged() {
+    if (scheduler) scheduler->reschedule(slot);
+    if (grid) grid->refreshOccupant(this);
+}
+void Combatant::equipArmor(ArmorId armor) { armorId = armor; }
+void Combatant::equipWeapon(WeaponId weapon) { weaponId = weapon; }
+void Combatant::learnSpell(SpellId spell) { knownSpells.push_back(spell); }
+void Combatant::replaceSpell(int spellIndex, SpellId spell) { knownSpells[spellIndex] = spell; }
+
+void Combatant::addItem(ItemId item, int quantity) {
+    int index = findItem(item);
+    if (index != -1) inventory[index].quantity += quantity;
+    else inventory.push_back(InventoryEntry{ item, quantity });
+}
+
+void Combatant::equipArmor(const Armor& armor) { equipArmor(contentCatalog().intern(armor)); }
+void Combatant::equipWeapon(const Weapon& weapon) { equipWeapon(contentCatalog().intern(weapon)); }
+void Combatant::learnSpell(const Spell& spell) { learnSpell(contentCatalog().intern(spell)); }
+void Combatant::addItem(const Item& item, int quantity) { addItem(contentCatalog().intern(item), quantity); }
+
+void Combatant::setItemQuantity(int itemIndex, int quantity) { inventory[itemIndex].quantity = quantity; }
+
 void Combatant::startTurn() {
-    if (guarding) {
-        std::cout << " >> " << name << " drops their guard.\n";
-        guarding = false;
+    if (isGuarding()) {
+        emit(CombatEventType::GuardDropped);
+        store->flags[slot] &= ~CombatantStore::FLAG_GUARDING;
     }
 }
 
 void Combatant::addTicks(int ticks) {
-    initiative += ticks;
-    for (int t = 0; t < ticks; ++t) {
-        for (auto it = statuses.begin(); it != statuses.end(); ) {
-            if (it->name == "Burn") {
-                currentHealth -= it->potency;
-                if (currentHealth < 0) currentHealth = 0;
-            }
-            it->durationTicks--;
-            if (it->durationTicks <= 0) {
-                if (it->name == "Burn") std::cout << " >> " << name << "'s burns fade.\n";
-                if (it->name == "Acid") std::cout << " >> Acid drips off " << name << "'s armor.\n";
-                it = statuses.erase(it);
-            }
-            else {
-                ++it;
-            }
-        }
-        if (currentHealth <= 0) break;
+    store->initiative[slot] += ticks;
+    StatusList& statuses = store->statuses[slot];
+    if (statuses.count <= StatusList::CAPACITY) {
+        StatusEffect expired[StatusList::CAPACITY];
+        emitExpired(expired, statuses.advance(ticks, store->currentHealth[slot], expired));
+    }
+    else {
+        std::vector<StatusEffect> expired(statuses.count);
+        emitExpired(expired.data(), statuses.advance(ticks, store->currentHealth[slot], expired.data()));
     }
-    if (currentHealth <= 0 && !fled) {
-        std::cout << " >> " << name << " succumbed to damage!\n";
+    notifyStateChanged();
+    if (store->currentHealth[slot] <= 0 && !hasFled()) {
+        emit(CombatEventType::Succumbed);
+    }
+}
+
+void Combatant::emitExpired(const StatusEffect* expired, int count) {
+    for (int i = 0; i < count; ++i) {
+        for (int s = 0; s < expired[i].stacks; ++s) {
+            emit(CombatEventType::StatusExpired, nullptr, 0, 0, static_cast<uint8_t>(expired[i].type));
+        }
     }
 }
 
 void Combatant::guard() {
-    guarding = true;
-    std::cout << " >> " << name << " enters Guard Stance! (+100 DR)\n";
+    store->flags[slot] |= CombatantStore::FLAG_GUARDING;
+    emit(CombatEventType::Guarded);
 }
 
 void Combatant::flee() {
-    fled = true;
-    xPos = -1;
-    yPos = -1;
+    store->flags[slot] |= CombatantStore::FLAG_FLED;
+    store->xPos[slot] = -1;
+    store->yPos[slot] = -1;
+    notifyStateChanged();
 }
 
 void Combatant::reduceMorale(int amount) {
-    morale -= amount;
-    if (morale < 0) {
-        std::cout << " >> " << name << " is MENTALLY BROKEN! (Morale: " << morale << ")\n";
+    store->morale[slot] -= amount;
+    if (store->morale[slot] < 0) {
+        emit(CombatEventType::MoraleBroken, nullptr, amount, store->morale[slot]);
     }
 }
 
 void Combatant::regainMorale(int amount) {
-    morale += amount;
-    std::cout << " >> " << name << " regains " << amount << " Morale. (Current: " << morale << ")\n";
+    store->morale[slot] += amount;
+    emit(CombatEventType::MoraleRegained, nullptr, amount, store->morale[slot]);
 }
 
 void Combatant::drainMP(int amount) {
-    currentMagicPoints -= amount;
-    if (currentMagicPoints < 0) currentMagicPoints = 0;
-    std::cout << " >> " << name << " loses " << amount << " MP! (MP: " << currentMagicPoints << ")\n";
+    store->currentMagicPoints[slot] -= amount;
+    if (store->currentMagicPoints[slot] < 0) store->currentMagicPoints[slot] = 0;
+    emit(CombatEventType::MPDrained, nullptr, amount, store->currentMagicPoints[slot]);
 }
 
 void Combatant::restoreMP(int amount) {
-    currentMagicPoints += amount;
-    if (currentMagicPoints > maxMagicPoints) currentMagicPoints = maxMagicPoints;
-    std::cout << " >> " << name << " restores " << amount << " MP! (MP: " << currentMagicPoints << "/" << maxMagicPoints << ")\n";
+    store->currentMagicPoints[slot] += amount;
+    if (store->currentMagicPoints[slot] > store->maxMagicPoints[slot]) store->currentMagicPoints[slot] = store->maxMagicPoints[slot];
+    emit(CombatEventType::MPRestored, nullptr, amount, store->currentMagicPoints[slot]);
 }
 
-void Combatant::applyStatus(std::string name, int duration, int potency) {
-    StatusEffect effect;
-    effect.name = name;
-    effect.durationTicks = duration;
-    effect.potency = potency;
-    statuses.push_back(effect);
-    std::cout << " >> " << this->name << " is affected by " << name << "! (" << duration << " ticks)\n";
+void Combatant::applyStatus(StatusType type, int duration, int potency) {
+    store->statuses[slot].add(StatusEffect{ type, duration, potency });
+    emit(CombatEventType::StatusApplied, nullptr, duration, potency, static_cast<uint8_t>(type));
 }
 
-void Combatant::takeDamage(int amount, std::string element, Grid* grid) {
-    currentHealth -= amount;
-    if (currentHealth < 0) currentHealth = 0;
-    std::cout << " >> " << name << " takes " << amount << " damage! (HP: " << currentHealth << "/" << maxHealth << ")\n";
+void Combatant::takeDamage(int amount, Element element, Grid* battleGrid) {
+    store->currentHealth[slot] -= amount;
+    if (store->currentHealth[slot] < 0) store->currentHealth[slot] = 0;
+    notifyStateChanged();
+    emit(CombatEventType::DamageTaken, nullptr, amount, store->currentHealth[slot], static_cast<uint8_t>(element));
 
-    if (element == "Psi") {
-        std::cout << " >> Psi attack strikes the mind!\n";
+    if (element == Element::Psi) {
+        emit(CombatEventType::PsiStrike);
         reduceMorale(amount);
     }
-    if (element == "Electricity") {
+    if (element == Element::Electricity) {
         drainMP(amount / 2);
     }
 
-    if (equippedArmor.elementType == "Poison" && grid != nullptr && xPos != -1) {
+    if (getArmor().element == Element::Poison && battleGrid != nullptr && store->xPos[slot] != -1) {
         int reflectDmg = amount / 2;
         if (reflectDmg > 0) {
-            std::cout << " >> Poison Armor spews toxins! Reflecting " << reflectDmg << " damage!\n";
+            emit(CombatEventType::PoisonReflect, nullptr, reflectDmg);
             int checkX[] = { 0, 0, 1, -1 };
             int checkY[] = { 1, -1, 0, 0 };
+            // Re-read the mask each step: a reflected hit can itself kill or chain.
             for (int i = 0; i < 4; ++i) {
-                Combatant* neighbor = grid->getCombatantAt(xPos + checkX[i], yPos + checkY[i]);
-                if (neighbor && neighbor->isAlive() && neighbor->getTeam() != team) {
-                    neighbor->takeDamage(reflectDmg, "Reflect", grid);
+                if (battleGrid->adjacentEnemyMask(store->xPos[slot], store->yPos[slot], store->teamId[slot]) & (1u << i)) {
+                    Combatant* neighbor = battleGrid->getCombatantAt(store->xPos[slot] + checkX[i], store->yPos[slot] + checkY[i]);
+                    neighbor->takeDamage(reflectDmg, Element::Reflect, battleGrid);
                 }
             }
         }
     }
 
-    if (currentHealth == 0) {
-        std::cout << " >> " << name << " has been defeated!\n";
+    if (store->currentHealth[slot] == 0) {
+        emit(CombatEventType::Defeated);
     }
 }
 
 void Combatant::heal(int amount) {
-    currentHealth += amount;
-    if (currentHealth > maxHealth) currentHealth = maxHealth;
-    std::cout << " >> " << name << " recovers " << amount << " HP! (HP: " << currentHealth << "/" << maxHealth << ")\n";
+    store->currentHealth[slot] += amount;
+    if (store->currentHealth[slot] > store->maxHealth[slot]) store->currentHealth[slot] = store->maxHealth[slot];
+    notifyStateChanged();
+    emit(CombatEventType::Healed, nullptr, amount, store->currentHealth[slot]);
 }
 
 void Combatant::printStats() const {
-    std::cout << "Name: " << name << " | HP: " << currentHealth << "/" << maxHealth
-        << " | MP: " << currentMagicPoints << "/" << maxMagicPoints
-        << " | Init: " << initiative
-        << " | Morale: " << morale
+    std::cout << "Name: " << name << " | HP: " << store->currentHealth[slot] << "/" << store->maxHealth[slot]
+        << " | MP: " << store->currentMagicPoints[slot] << "/" << store->maxMagicPoints[slot]
+        << " | Init: " << store->initiative[slot]
+        << " | Morale: " << store->morale[slot]
         << (isBroken() ? " [BROKEN]" : "")
-        << (guarding ? " [GUARDING]" : "")
-        << " | Wpn: " << equippedWeapon.name
-        << " | Armor: " << equippedArmor.name << "\n";
+        << (isGuarding() ? " [GUARDING]" : "")
+        << " | Wpn: " << getWeapon().name
+        << " | Armor: " << getArmor().name << "\n";
 }
 
 bool Combatant::checkRange(const Combatant& target, float range) const {
-    if (xPos == -1 || target.getX() == -1) return true;
-	float dist = getDistance(xPos, yPos, target.getX(), target.getY());
-    if (dist > range) {
+    if (store->xPos[slot] == -1 || target.getX() == -1) return true;
+    int distSq = getSquaredDistance(store->xPos[slot], store->yPos[slot], target.getX(), target.getY());
+    if (static_cast<float>(distSq) > range * range) {
         return false;
     }
     return true;
 }
 
+// ------------------------------------------
+// MATCHUP COEFFICIENTS
+// ------------------------------------------
+
+int AttackMatchup::damageAt(int multiplier, int effectiveDR) {
+    int index = multiplier - ATTACK_MULTIPLIER_MIN;
+    if (effectiveDR != columnDR) {
+        columnDR = effectiveDR;
+        columnFilled = 0;
+    }
+    if (!(columnFilled & (1u << index))) {
+        int damageAfterThreshold = product[index] - damageThreshold;
+        if (damageAfterThreshold < 1) damageAfterThreshold = 1;
+        damage[index] = static_cast<int>(((damageAfterThreshold * 100) / (100 + effectiveDR)) * elemMult);
+        columnFilled |= 1u << index;
+    }
+    return damage[index];
+}
+
+AttackMatchup& MatchupTable::attack(WeaponId weaponId, ArmorId armorId) {
+    uint64_t key = (static_cast<uint64_t>(weaponId) << 16) | armorId;
+    AttackMatchup& entry = attacks[(weaponId * 31u + armorId) & (CAPACITY - 1)];
+    if (entry.key == key) return entry;
+
+    const Weapon& weapon = contentCatalog().weapon(weaponId);
+    const Armor& armor = contentCatalog().armor(armorId);
+    entry.key = key;
+    entry.hitChance = weapon.accuracy - armor.evasion;
+    entry.elemMult = getElementalMultiplier(weapon.element, armor.element);
+    entry.damageThreshold = armor.damageThreshold;
+    for (int i = 0; i < ATTACK_MULTIPLIER_COUNT; ++i) {
+        entry.product[i] = (weapon.physicalAttack * (ATTACK_MULTIPLIER_MIN + i)) / 10;
+    }
+    entry.columnFilled = 0;
+    return entry;
+}
+
+const SpellMatchup& MatchupTable::spell(SpellId spellId, ArmorId armorId) {
+    uint64_t key = (static_cast<uint64_t>(spellId) << 16) | armorId;
+    SpellMatchup& entry = spells[(spellId * 31u + armorId) & (CAPACITY - 1)];
+    if (entry.key == key) return entry;
+
+    const Spell& spell = contentCatalog().spell(spellId);
+    const Armor& armor = contentCatalog().armor(armorId);
+    int magicDef = armor.magicalDefense;
+    if (magicDef < -80) magicDef = -80;
+    entry.key = key;
+    entry.elemMult = getElementalMultiplier(spell.element, armor.element);
+    entry.damage = static_cast<int>(((spell.magicalAttack * 100) / (100 + magicDef)) * entry.elemMult);
+    return entry;
+}
+
 // ------------------------------------------
 // CORE COMBAT LOGIC
 // ------------------------------------------
 
-bool Combatant::attack(Combatant& target, Grid& grid) {
+bool Combatant::attack(Combatant& target, Grid& grid, BattleRng& rng) {
+    const Weapon& equippedWeapon = getWeapon();
     if (!checkRange(target, equippedWeapon.range)) {
-        std::cout << " >> Target out of range for attack!\n";
+        emit(CombatEventType::OutOfRange, &target, 0, 0, static_cast<uint8_t>(EventSource::Attack));
         return false;
     }
 
-    std::cout << name << " attacks " << target.getName() << " with " << equippedWeapon.name << " (" << equippedWeapon.elementType << ")!\n";
+    emit(CombatEventType::AttackDeclared, &target);
+    // Equipment cannot change mid-attack, so one lookup serves every swing.
+    AttackMatchup& matchup = matchups().attack(weaponId, target.getArmorId());
 
     for (int i = 0; i < equippedWeapon.numberOfAttacks; ++i) {
         if (!target.isAlive()) break;
 
-        float hitChance = equippedWeapon.accuracy - target.getArmor().evasion;
-        float roll = getRandomFloat(0.0f, 1.0f);
-
-        if (roll > hitChance) {
-            std::cout << " - Attack " << (i + 1) << " MISSED!\n";
+        if (!rng.chance(matchup.hitChance)) {
+            emit(CombatEventType::AttackMissed, &target, i + 1);
             continue;
         }
 
-        int multiplier = getRandomInt(7, 13);
-        int productDamage = (equippedWeapon.physicalAttack * multiplier) / 10;
+        int multiplier = rng.nextInt(ATTACK_MULTIPLIER_MIN, ATTACK_MULTIPLIER_MAX);
+        int productDamage = matchup.product[multiplier - ATTACK_MULTIPLIER_MIN];
         int critDamage = 0;
 		int finalDamage = 0;
 
-        bool isCrit = getRandomFloat(0.0f, 1.0f) <= 0.05f;
+        bool isCrit = rng.chance(0.05f);
 
         if (isCrit) {
-            std::cout << " - CRITICAL HIT! ";
+            emit(CombatEventType::CriticalHit, &target);
             critDamage = productDamage;
         }
         else {
-            int damageAfterThreshold = productDamage - target.getArmor().damageThreshold;
-            if (damageAfterThreshold < 1) damageAfterThreshold = 1;
-
             int baseDR = target.getEffectiveDR();
             if (target.isGuarding()) baseDR += 100;
             if (baseDR < -80) baseDR = -80;
 
-            finalDamage = (damageAfterThreshold * 100) / (100 + baseDR);
+            // Threshold, DR and the elemental multiplier, as cached for this DR.
+            finalDamage = matchup.damageAt(multiplier, baseDR);
         }
 
-        float elemMult = getElementalMultiplier(equippedWeapon.elementType, target.getArmor().elementType);
-        finalDamage = static_cast<int>(finalDamage * elemMult);
+        float elemMult = matchup.elemMult;
 
-        if (elemMult > 1.0f) std::cout << "(Weakness Hit!) ";
-        if (elemMult < 1.0f) std::cout << "(Resisted) ";
+        if (elemMult > 1.0f) emit(CombatEventType::Weakness, &target, 0, 0, static_cast<uint8_t>(EventSource::Attack));
+        if (elemMult < 1.0f) emit(CombatEventType::Resisted, &target, 0, 0, static_cast<uint8_t>(EventSource::Attack));
 
-        std::string elem = equippedWeapon.elementType;
+        Element elem = equippedWeapon.element;
 
-        if (elem == "Fire") {
+        if (elem == Element::Fire) {
             int burnDmg = productDamage / 20;
-            target.applyStatus("Burn", 5, burnDmg);
+            target.applyStatus(StatusType::Burn, 5, burnDmg);
         }
-        else if (elem == "Acid") {
+        else if (elem == Element::Acid) {
             int acidPotency = finalDamage / 3;
-            target.applyStatus("Acid", 7, acidPotency);
+            target.applyStatus(StatusType::Acid, 7, acidPotency);
         }
-        else if (elem == "Ice") {
+        else if (elem == Element::Ice) {
             int ticksToAdd = static_cast<int>(std::ceil(finalDamage * 0.01));
-            std::cout << " >> Ice chills " << target.getName() << "! (+" << ticksToAdd << " Init Ticks)\n";
+            emit(CombatEventType::IceChill, &target, ticksToAdd, 0, static_cast<uint8_t>(EventSource::Attack));
             target.addTicks(ticksToAdd);
         }
-        else if (elem == "Bio") {
+        else if (elem == Element::Bio) {
             int healAmt = finalDamage / 2;
-            std::cout << " >> Bio-leech absorbs health!\n";
+            emit(CombatEventType::BioLeech, &target, 0, 0, static_cast<uint8_t>(EventSource::Attack));
             this->heal(healAmt);
         }
 		int damageTaken = finalDamage + critDamage;
@@ -347,58 +634,56 @@ bool Combatant::attack(Combatant& target, Grid& grid) {
 
 bool Combatant::castSpell(Combatant& primaryTarget, int spellIndex, Grid& grid) {
     if (spellIndex < 0 || spellIndex >= knownSpells.size()) {
-        std::cout << "Invalid spell selection.\n";
+        emit(CombatEventType::InvalidSpell, nullptr, spellIndex);
         return false;
     }
-    const Spell& spell = knownSpells[spellIndex];
+    const Spell& spell = getSpell(spellIndex);
 
-    if (currentMagicPoints < spell.mpCost) {
-        std::cout << " >> Not enough MP! (Cost: " << spell.mpCost << ", Have: " << currentMagicPoints << ")\n";
+    if (store->currentMagicPoints[slot] < spell.mpCost) {
+        emit(CombatEventType::NotEnoughMP, nullptr, spell.mpCost, store->currentMagicPoints[slot]);
         return false;
     }
 
     // Range Check to Center Target
     if (!checkRange(primaryTarget, spell.range)) {
-        std::cout << " >> Target out of range for spell!\n";
+        emit(CombatEventType::OutOfRange, &primaryTarget, 0, 0, static_cast<uint8_t>(EventSource::Spell));
         return false;
     }
 
-    currentMagicPoints -= spell.mpCost;
-    std::cout << name << " casts " << spell.name << " (" << spell.elementType << ")!\n";
+    store->currentMagicPoints[slot] -= spell.mpCost;
+    emit(CombatEventType::SpellCast, &primaryTarget, spellIndex);
 
     // Define Spell Effect Application Lambda
+    MatchupTable& table = matchups();
+    SpellId spellId = knownSpells[spellIndex];
     auto applySpellEffect = [&](Combatant* victim) {
-        int magicDef = victim->getArmor().magicalDefense;
-        if (magicDef < -80) magicDef = -80;
-
-        int damage = (spell.magicalAttack * 100) / (100 + magicDef);
-
-        float elemMult = getElementalMultiplier(spell.elementType, victim->getArmor().elementType);
-        damage = static_cast<int>(damage * elemMult);
+        const SpellMatchup& hit = table.spell(spellId, victim->getArmorId());
+        int damage = hit.damage;
+        float elemMult = hit.elemMult;
 
         // Log individual hit
-        std::cout << "  -> Hit " << victim->getName() << ": ";
-        if (elemMult > 1.0f) std::cout << "(Weakness) ";
-        if (elemMult < 1.0f) std::cout << "(Resisted) ";
+        emit(CombatEventType::SpellHit, victim);
+        if (elemMult > 1.0f) emit(CombatEventType::Weakness, victim, 0, 0, static_cast<uint8_t>(EventSource::Spell));
+        if (elemMult < 1.0f) emit(CombatEventType::Resisted, victim, 0, 0, static_cast<uint8_t>(EventSource::Spell));
 
-        std::string elem = spell.elementType;
+        Element elem = spell.element;
 
-        if (elem == "Fire") {
+        if (elem == Element::Fire) {
             int burnDmg = spell.magicalAttack / 20;
-            victim->applyStatus("Burn", 5, burnDmg);
+            victim->applyStatus(StatusType::Burn, 5, burnDmg);
         }
-        else if (elem == "Acid") {
+        else if (elem == Element::Acid) {
             int acidPotency = damage / 3;
-            victim->applyStatus("Acid", 7, acidPotency);
+            victim->applyStatus(StatusType::Acid, 7, acidPotency);
         }
-        else if (elem == "Ice") {
+        else if (elem == Element::Ice) {
             int ticksToAdd = static_cast<int>(std::ceil(damage * 0.01));
-            std::cout << "Ice chills! (+" << ticksToAdd << " Init Ticks) ";
+            emit(CombatEventType::IceChill, victim, ticksToAdd, 0, static_cast<uint8_t>(EventSource::Spell));
             victim->addTicks(ticksToAdd);
         }
-        else if (elem == "Bio") {
+        else if (elem == Element::Bio) {
             int healAmt = damage / 2;
-            std::cout << "Bio-leech! ";
+            emit(CombatEventType::BioLeech, victim, 0, 0, static_cast<uint8_t>(EventSource::Spell));
             this->heal(healAmt);
         }
 
@@ -408,29 +693,22 @@ bool Combatant::castSpell(Combatant& primaryTarget, int spellIndex, Grid& grid)
     // AOE Logic
     if (primaryTarget.getX() == -1) return false;
 
-    // Scan the grid for all valid targets in AOE
-    for (int y = 0; y < grid.getHeight(); ++y) {
-        for (int x = 0; x < grid.getWidth(); ++x) {
-            Combatant* potential = grid.getCombatantAt(x, y);
-            if (potential && potential->isAlive()) {
-                // Distance to Primary Target
-				float dist = getDistance(primaryTarget.getX(), primaryTarget.getY(), x, y);
-
-                // Check if within AOE radius
-                if (dist <= spell.aoe) {
-                    // Team Filter
-                    bool isAlly = (potential->getTeam() == this->team);
-
-                    if (spell.category == "Buff") {
-                        // Buffs only hit same team
-                        if (isAlly) applySpellEffect(potential);
-                    }
-                    else { // Debuff / Attack
-                        // Debuffs only hit different team
-                        if (!isAlly) applySpellEffect(potential);
-                    }
-                }
-            }
+    // Gather everything inside the AOE radius around the primary target
+    const std::pmr::vector<Combatant*>& inArea = grid.unitsInRadius(primaryTarget.getX(), primaryTarget.getY(), spell.aoe);
+
+    for (Combatant* potential : inArea) {
+        if (!potential->isAlive()) continue;
+
+        // Team Filter
+        bool isAlly = (potential->getTeamId() == store->teamId[slot]);
+
+        if (spell.category == SpellCategory::Buff) {
+            // Buffs only hit same team
+            if (isAlly) applySpellEffect(potential);
+        }
+        else { // Debuff / Attack
+            // Debuffs only hit different team
+            if (!isAlly) applySpellEffect(potential);
         }
     }
 
@@ -440,31 +718,32 @@ bool Combatant::castSpell(Combatant& primaryTarget, int spellIndex, Grid& grid)
 bool Combatant::useItem(Combatant& target, int itemIndex) {
     if (itemIndex < 0 || itemIndex >= inventory.size()) return false;
 
-    Item& item = inventory[itemIndex];
-    if (item.quantity <= 0) {
-        std::cout << " >> Not enough items!\n";
+    InventoryEntry& stack = inventory[itemIndex];
+    const Item& item = getItem(itemIndex);
+    if (stack.quantity <= 0) {
+        emit(CombatEventType::NotEnoughItems, nullptr, itemIndex);
         return false;
     }
 
     if (!checkRange(target, item.range)) {
-        std::cout << " >> Target out of range for item!\n";
+        emit(CombatEventType::OutOfRange, &target, 0, 0, static_cast<uint8_t>(EventSource::Item));
         return false;
     }
 
-    item.quantity--;
-    std::cout << name << " uses " << item.name << " on " << target.getName() << "!\n";
+    stack.quantity--;
+    emit(CombatEventType::ItemUsed, &target, itemIndex);
 
-    if (item.category == "Healing") {
+    if (item.category == ItemCategory::Healing) {
         target.heal(item.potency);
     }
-    else if (item.category == "RestoreMP") {
+    else if (item.category == ItemCategory::RestoreMP) {
         target.restoreMP(item.potency);
     }
-    else if (item.category == "Buff") {
-        std::cout << " >> " << target.getName() << " is Buffed!\n";
+    else if (item.category == ItemCategory::Buff) {
+        emit(CombatEventType::ItemBuffed, &target);
     }
-    else if (item.category == "Debuff") {
-        std::cout << " >> " << target.getName() << " is Debuffed!\n";
+    else if (item.category == ItemCategory::Debuff) {
+        emit(CombatEventType::ItemDebuffed, &target);
     }
     return true;
 }
@@ -474,52 +753,138 @@ bool Combatant::useItem(Combatant& target, int itemIndex) {
 // Battle Manager Implementation
 // ==========================================
 
+BattleManager::BattleManager(uint64_t seed, uint64_t stream, std::pmr::memory_resource* memory)
+    : participants(memory), units(memory), rng(seed, stream), heap(memory), heapPos(memory), tiedSlots(memory),
+    tieStack(memory) {
+}
+
+BattleRng& BattleManager::getRng() { return rng; }
+
 void BattleManager::addParticipant(Combatant* c) {
+    int slot = static_cast<int>(participants.size());
     participants.push_back(c);
+    heapPos.push_back(-1);
+    c->moveToStore(units, this);
+    if (eventSink) c->setEventSink(eventSink);
+    reschedule(slot);
+}
+
+void BattleManager::setEventSink(CombatEventSink* sink) {
+    eventSink = normalizeSink(sink);
+    for (auto c : participants) c->setEventSink(eventSink);
 }
 
-const std::vector<Combatant*>& BattleManager::getParticipants() const {
+CombatEventSink* BattleManager::getEventSink() const { return eventSink; }
+
+const std::pmr::vector<Combatant*>& BattleManager::getParticipants() const {
     return participants;
 }
 
-Combatant* BattleManager::getNextActiveCombatant() {
-    int minInit = std::numeric_limits<int>::max();
-    std::vector<Combatant*> tiedCombatants;
+const CombatantStore& BattleManager::getStore() const { return units; }
 
-    for (auto c : participants) {
-        if (!c->isAlive()) continue;
+bool BattleManager::scheduledBefore(const ScheduleEntry& a, const ScheduleEntry& b) {
+    if (a.initiative != b.initiative) return a.initiative < b.initiative;
+    return a.slot < b.slot;
+}
 
-        int init = c->getInitiative();
-        if (init < minInit) {
-            minInit = init;
-            tiedCombatants.clear();
-            tiedCombatants.push_back(c);
-        }
-        else if (init == minInit) {
-            tiedCombatants.push_back(c);
-        }
+void BattleManager::placeEntry(int index, const ScheduleEntry& entry) {
+    heap[index] = entry;
+    heapPos[entry.slot] = index;
+}
+
+void BattleManager::siftUp(int index) {
+    ScheduleEntry entry = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!scheduledBefore(entry, heap[parent])) break;
+        placeEntry(index, heap[parent]);
+        index = parent;
     }
+    placeEntry(index, entry);
+}
 
-    if (tiedCombatants.empty()) return nullptr;
+void BattleManager::siftDown(int index) {
+    ScheduleEntry entry = heap[index];
+    int size = static_cast<int>(heap.size());
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= size) break;
+        if (child + 1 < size && scheduledBefore(heap[child + 1], heap[child])) child++;
+        if (!scheduledBefore(heap[child], entry)) break;
+        placeEntry(index, heap[child]);
+        index = child;
+    }
+    placeEntry(index, entry);
+}
 
-    if (tiedCombatants.size() == 1) {
-        return tiedCombatants[0];
+void BattleManager::reschedule(int slot) {
+    int pos = heapPos[slot];
+
+    if (!units.isAlive(slot)) {
+        if (pos == -1) return;
+        ScheduleEntry last = heap.back();
+        heap.pop_back();
+        heapPos[slot] = -1;
+        if (pos < static_cast<int>(heap.size())) {
+            placeEntry(pos, last);
+            siftUp(pos);
+            siftDown(heapPos[last.slot]);
+        }
+        return;
     }
-    else {
-        int idx = getRandomInt(0, tiedCombatants.size() - 1);
-        std::cout << "[Info] Tie detected for Initiative " << minInit << ". Randomly resolving...\n";
-        return tiedCombatants[idx];
+
+    ScheduleEntry entry{ units.initiative[slot], slot };
+    if (pos == -1) {
+        heap.push_back(entry);
+        siftUp(static_cast<int>(heap.size()) - 1);
+    }
+    else if (heap[pos].initiative != entry.initiative) {
+        placeEntry(pos, entry);
+        siftUp(pos);
+        siftDown(heapPos[slot]);
     }
 }
 
+Combatant* BattleManager::getNextActiveCombatant() {
+    if (heap.empty()) return nullptr;
+
+    int minInit = heap[0].initiative;
+    int size = static_cast<int>(heap.size());
+    bool tied = (size > 1 && heap[1].initiative == minInit) || (size > 2 && heap[2].initiative == minInit);
+    if (!tied) return participants[heap[0].slot];
+
+    // Every unit sharing the lowest initiative lives in the subtree of the root
+    // whose keys equal minInit; walk only that part of the heap.
+    tiedSlots.clear();
+    tieStack.clear();
+    tieStack.push_back(0);
+    while (!tieStack.empty()) {
+        int index = tieStack.back();
+        tieStack.pop_back();
+        if (index >= size || heap[index].initiative != minInit) continue;
+        tiedSlots.push_back(heap[index].slot);
+        tieStack.push_back(2 * index + 1);
+        tieStack.push_back(2 * index + 2);
+    }
+
+    // Resolve in participant order so the draw matches a linear scan.
+    std::sort(tiedSlots.begin(), tiedSlots.end());
+    int idx = rng.nextInt(0, static_cast<int>(tiedSlots.size()) - 1);
+    emitEvent(eventSink, CombatEventType::InitiativeTie, nullptr, nullptr, minInit);
+    return participants[tiedSlots[idx]];
+}
+
 std::string BattleManager::getWinner() {
+    static const int goodTeam = internTeam("Good Guys");
+    static const int badTeam = internTeam("Bad Guys");
     bool goodAlive = false;
     bool badAlive = false;
 
-    for (auto c : participants) {
-        if (c->isAlive()) {
-            if (c->getTeam() == "Good Guys") goodAlive = true;
-            if (c->getTeam() == "Bad Guys") badAlive = true;
+    int count = units.size();
+    for (int i = 0; i < count; ++i) {
+        if (units.isAlive(i)) {
+            if (units.teamId[i] == goodTeam) goodAlive = true;
+            if (units.teamId[i] == badTeam) badAlive = true;
         }
     }
 
@@ -530,31 +895,153 @@ std::string BattleManager::getWinner() {
     return "None";
 }
 
+void BattleManager::saveState(BattleState& state) const {
+    state.units = units;
+    state.schedulePos.assign(heapPos.begin(), heapPos.end());
+    state.rng = rng;
+}
+
+void BattleManager::restoreState(const BattleState& state) {
+    units = state.units;
+    heapPos.assign(state.schedulePos.begin(), state.schedulePos.end());
+    rng = state.rng;
+
+    // Heap entries are keyed on the restored initiatives, so the heap is
+    // rebuilt exactly from each slot's recorded position.
+    int scheduled = 0;
+    for (int pos : heapPos) {
+        if (pos != -1) scheduled++;
+    }
+    heap.resize(scheduled);
+    for (int slot = 0; slot < static_cast<int>(heapPos.size()); ++slot) {
+        if (heapPos[slot] != -1) heap[heapPos[slot]] = ScheduleEntry{ units.initiative[slot], slot };
+    }
+}
+
 // ==========================================
 // Grid Implementation
 // ==========================================
-Grid::Grid(int w, int h) : width(w), height(h) {
-    terrainMap.resize(h, std::vector<int>(w, 0));
-    combatantMap.resize(h, std::vector<Combatant*>(w, nullptr));
+Grid::Grid(int w, int h, std::pmr::memory_resource* memory)
+    : memory(memory), width(w), height(h), boardWords((w * h + 63) / 64),
+    terrainMap(w * h, Terrain::Open, memory), combatantMap(w * h, nullptr, memory), aliveBoard(boardWords, 0, memory),
+    teamBoards(memory), bucketsWide((w + BUCKET_SIZE - 1) >> BUCKET_SHIFT),
+    bucketsHigh((h + BUCKET_SIZE - 1) >> BUCKET_SHIFT), buckets(memory), nearestScratch(memory), occupants(memory),
+    diskStencils(memory), areaScratch(memory) {
+}
+
+Grid::~Grid() { deleteObject(memory, pathfinder); }
+
+void Grid::setTerrain(int x, int y, Terrain terrain) {
+    terrainMap[cellIndex(x, y)] = terrain;
+    terrainVersion++;
+}
+
+int Grid::getEnterCost(int x, int y) const {
+    int extra = TERRAIN_MOVE_COST[static_cast<int>(terrainMap[cellIndex(x, y)])];
+    return extra < 0 ? -1 : COST_MOVE_BASE + extra;
+}
+
+const std::pmr::vector<uint64_t>& Grid::getTeamBoard(int teamId) { return teamBoard(teamId); }
+
+Pathfinder& Grid::getPathfinder() {
+    if (!pathfinder) pathfinder = newObject<Pathfinder>(memory, *this);
+    return *pathfinder;
 }
 
 Combatant* Grid::getCombatantAt(int x, int y) {
     if (x < 0 || x >= width || y < 0 || y >= height) return nullptr;
-    return combatantMap[y][x];
+    return combatantMap[cellIndex(x, y)];
+}
+
+std::pmr::vector<uint64_t>& Grid::teamBoard(int teamId) {
+    if (teamId >= static_cast<int>(teamBoards.size())) {
+        // No prototype row: it would come from the global heap.
+        size_t first = teamBoards.size();
+        teamBoards.resize(teamId + 1);
+        for (size_t i = first; i < teamBoards.size(); ++i) teamBoards[i].assign(boardWords, 0);
+    }
+    return teamBoards[teamId];
+}
+
+void Grid::setAliveBit(int cell, int teamId, bool alive) {
+    uint64_t bit = uint64_t(1) << (cell & 63);
+    int word = cell >> 6;
+    std::pmr::vector<uint64_t>& team = teamBoard(teamId);
+    if (alive) {
+        aliveBoard[word] |= bit;
+        team[word] |= bit;
+    }
+    else {
+        aliveBoard[word] &= ~bit;
+        team[word] &= ~bit;
+    }
+}
+
+std::pmr::vector<Grid::BucketEntry>& Grid::bucketOf(int cell, int teamId) {
+    size_t perTeam = static_cast<size_t>(bucketsWide) * bucketsHigh;
+    if (buckets.size() < (teamId + 1) * perTeam) buckets.resize((teamId + 1) * perTeam);
+    int bucket = ((cell / width) >> BUCKET_SHIFT) * bucketsWide + ((cell % width) >> BUCKET_SHIFT);
+    return buckets[teamId * perTeam + bucket];
+}
+
+void Grid::setOccupantAlive(Combatant* c, int cell, bool alive) {
+    bool wasAlive = (aliveBoard[cell >> 6] >> (cell & 63)) & 1;
+    setAliveBit(cell, c->getTeamId(), alive);
+    if (alive == wasAlive) return;
+
+    std::pmr::vector<BucketEntry>& bucket = bucketOf(cell, c->getTeamId());
+    if (alive) {
+        bucket.push_back(BucketEntry{ cell % width, cell / width, c->getSlot(), c });
+    }
+    else {
+        auto it = std::find_if(bucket.begin(), bucket.end(), [c](const BucketEntry& e) { return e.unit == c; });
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+}
+
+bool Grid::isEnemyCell(int cell, int teamId) const {
+    int word = cell >> 6;
+    uint64_t enemies = aliveBoard[word];
+    if (teamId < static_cast<int>(teamBoards.size())) enemies &= ~teamBoards[teamId][word];
+    return (enemies >> (cell & 63)) & 1;
+}
+
+unsigned Grid::adjacentEnemyMask(int x, int y, int teamId) const {
+    int cell = cellIndex(x, y);
+    unsigned mask = 0;
+    if (y + 1 < height && isEnemyCell(cell + width, teamId)) mask |= 1u;
+    if (y > 0 && isEnemyCell(cell - width, teamId)) mask |= 2u;
+    if (x + 1 < width && isEnemyCell(cell + 1, teamId)) mask |= 4u;
+    if (x > 0 && isEnemyCell(cell - 1, teamId)) mask |= 8u;
+    return mask;
+}
+
+void Grid::refreshOccupant(Combatant* c) {
+    if (c->getX() == -1) return;
+    setOccupantAlive(c, cellIndex(c->getX(), c->getY()), c->isAlive());
 }
 
 bool Grid::placeCombatant(Combatant* c, int x, int y) {
     if (x < 0 || x >= width || y < 0 || y >= height) return false;
-    if (combatantMap[y][x] != nullptr) return false;
+    int cell = cellIndex(x, y);
+    if (combatantMap[cell] != nullptr) return false;
 
     int oldX = c->getX();
     int oldY = c->getY();
     if (oldX != -1 && oldY != -1) {
-        combatantMap[oldY][oldX] = nullptr;
+        int oldCell = cellIndex(oldX, oldY);
+        combatantMap[oldCell] = nullptr;
+        setOccupantAlive(c, oldCell, false);
+    }
+    else {
+        occupants.push_back(c);
     }
 
-    combatantMap[y][x] = c;
+    combatantMap[cell] = c;
     c->setPosition(x, y);
+    c->setGrid(this);
+    setOccupantAlive(c, cell, c->isAlive());
     return true;
 }
 
@@ -562,25 +1049,10 @@ int Grid::moveCombatant(Combatant* c, int dx, int dy) {
     int curX = c->getX();
     int curY = c->getY();
     if (curX == -1) return 0;
+    int curCell = cellIndex(curX, curY);
 
     // 1. Check Adjacency Rule
-    bool isEngaged = false;
-    int checkX[] = { 0, 0, 1, -1 };
-    int checkY[] = { 1, -1, 0, 0 };
-
-    for (int i = 0; i < 4; ++i) {
-        int nx = curX + checkX[i];
-        int ny = curY + checkY[i];
-
-        if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-            if (combatantMap[ny][nx] != nullptr) {
-                if (combatantMap[ny][nx]->getTeam() != c->getTeam() && combatantMap[ny][nx]->isAlive()) {
-                    isEngaged = true;
-                    break;
-                }
-            }
-        }
-    }
+    bool isEngaged = adjacentEnemyMask(curX, curY, c->getTeamId()) != 0;
 
     int tickCost = isEngaged ? (COST_MOVE_BASE + COST_MOVE_PENALTY) : COST_MOVE_BASE;
 
@@ -590,49 +1062,205 @@ int Grid::moveCombatant(Combatant* c, int dx, int dy) {
 
     // Flee check
     if (newX < 0 || newX >= width || newY < 0 || newY >= height) {
-        std::cout << " >> " << c->getName() << " runs off the battlefield!\n";
+        emitEvent(c->getEventSink(), CombatEventType::Fled, c);
+        combatantMap[curCell] = nullptr;
+        setOccupantAlive(c, curCell, false);
+        occupants.erase(std::find(occupants.begin(), occupants.end(), c));
+        c->setGrid(nullptr);
         c->flee();
-        combatantMap[curY][curX] = nullptr;
         return tickCost;
     }
 
     // Occupied check
-    if (combatantMap[newY][newX] != nullptr) {
-        std::cout << "[Movement] Blocked (Occupied by " << combatantMap[newY][newX]->getName() << ")\n";
+    int newCell = cellIndex(newX, newY);
+    if (combatantMap[newCell] != nullptr) {
+        emitEvent(c->getEventSink(), CombatEventType::MoveBlocked, c, combatantMap[newCell]);
         return 0; // Failed
     }
 
+    int terrainCost = TERRAIN_MOVE_COST[static_cast<int>(terrainMap[newCell])];
+    if (terrainCost < 0) {
+        emitEvent(c->getEventSink(), CombatEventType::MoveImpassable, c, nullptr, newX, newY);
+        return 0;
+    }
+    tickCost += terrainCost;
+
     // 3. Execute Move
-    combatantMap[curY][curX] = nullptr;
-    combatantMap[newY][newX] = c;
+    combatantMap[curCell] = nullptr;
+    combatantMap[newCell] = c;
+    setOccupantAlive(c, curCell, false);
+    setOccupantAlive(c, newCell, c->isAlive());
     c->setPosition(newX, newY);
-    std::cout << "[Movement] " << c->getName() << " moved to (" << newX << "," << newY << "). ";
-
-    if (isEngaged) std::cout << "(Engaged move: +" << tickCost << " ticks)\n";
-    else std::cout << "(Standard move: +" << tickCost << " ticks)\n";
+    emitEvent(c->getEventSink(), CombatEventType::Moved, c, nullptr, tickCost, isEngaged ? 1 : 0);
 
     return tickCost;
 }
 
-void Grid::drawGrid() {
-    std::cout << "\n--- Battlefield ---\n";
+Combatant* Grid::nearestOfTeam(int x, int y, int teamId) {
+    collectNearest(x, y, teamId, 1);
+    return nearestScratch.empty() ? nullptr : nearestScratch[0].unit;
+}
+
+void Grid::nearestOfTeam(int x, int y, int teamId, int k, std::pmr::vector<Combatant*>& out) {
+    collectNearest(x, y, teamId, k);
+    for (const auto& candidate : nearestScratch) out.push_back(candidate.unit);
+}
+
+void Grid::collectNearest(int x, int y, int teamId, int k) {
+    nearestScratch.clear();
+    size_t perTeam = static_cast<size_t>(bucketsWide) * bucketsHigh;
+    if (k <= 0 || buckets.size() < (teamId + 1) * perTeam) return;
+    const std::pmr::vector<BucketEntry>* teamBuckets = &buckets[teamId * perTeam];
+    auto before = [](const NearestCandidate& a, const NearestCandidate& b) {
+        return a.distSq != b.distSq ? a.distSq < b.distSq : a.slot < b.slot;
+    };
+
+    int bx = std::min(std::max(x, 0), width - 1) >> BUCKET_SHIFT;
+    int by = std::min(std::max(y, 0), height - 1) >> BUCKET_SHIFT;
+    int maxRing = std::max(std::max(bx, bucketsWide - 1 - bx), std::max(by, bucketsHigh - 1 - by));
+
+    auto scanBucket = [&](int cx, int cy) {
+        if (cx < 0 || cx >= bucketsWide || cy < 0 || cy >= bucketsHigh) return;
+        const std::pmr::vector<BucketEntry>& bucket = teamBuckets[cy * bucketsWide + cx];
+        if (bucket.empty()) return;
+
+        // Skip blocks that cannot hold anything closer than the current k-th.
+        if (static_cast<int>(nearestScratch.size()) == k) {
+            int left = cx << BUCKET_SHIFT;
+            int top = cy << BUCKET_SHIFT;
+            int gapX = std::max(std::max(left - x, x - (left + BUCKET_SIZE - 1)), 0);
+            int gapY = std::max(std::max(top - y, y - (top + BUCKET_SIZE - 1)), 0);
+            if (gapX * gapX + gapY * gapY > nearestScratch.back().distSq) return;
+        }
+
+        for (const BucketEntry& e : bucket) {
+            NearestCandidate candidate{ getSquaredDistance(x, y, e.x, e.y), e.slot, e.unit };
+            if (static_cast<int>(nearestScratch.size()) == k && !before(candidate, nearestScratch.back())) continue;
+            auto pos = std::upper_bound(nearestScratch.begin(), nearestScratch.end(), candidate, before);
+            nearestScratch.insert(pos, candidate);
+            if (static_cast<int>(nearestScratch.size()) > k) nearestScratch.pop_back();
+        }
+    };
+
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        if (ring == 0) {
+            scanBucket(bx, by);
+        }
+        else {
+            for (int cx = bx - ring; cx <= bx + ring; ++cx) {
+                scanBucket(cx, by - ring);
+                scanBucket(cx, by + ring);
+            }
+            for (int cy = by - ring + 1; cy <= by + ring - 1; ++cy) {
+                scanBucket(bx - ring, cy);
+                scanBucket(bx + ring, cy);
+            }
+        }
+        // Cells in the next ring are at least ring * BUCKET_SIZE + 1 away on one axis.
+        if (static_cast<int>(nearestScratch.size()) == k) {
+            int reach = ring * BUCKET_SIZE + 1;
+            if (nearestScratch.back().distSq < reach * reach) break;
+        }
+    }
+}
+
+const std::pmr::vector<std::pair<int, int>>& Grid::getDiskStencil(int radius) {
+    if (radius >= static_cast<int>(diskStencils.size())) {
+        diskStencils.resize(radius + 1);
+    }
+    auto& stencil = diskStencils[radius];
+    if (stencil.empty()) {
+        int radiusSq = radius * radius;
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                if (dx * dx + dy * dy <= radiusSq) stencil.emplace_back(dx, dy);
+            }
+        }
+    }
+    return stencil;
+}
+
+void Grid::queryRadius(int cx, int cy, int radius, std::pmr::vector<Combatant*>& out) {
+    if (radius < 0) return;
+
+    // Disk area is roughly pi*r^2; walk whichever set is smaller.
+    long long approxArea = 3LL * radius * radius + 4LL * radius + 1;
+    if (approxArea <= static_cast<long long>(occupants.size())) {
+        for (const auto& offset : getDiskStencil(radius)) {
+            Combatant* c = getCombatantAt(cx + offset.first, cy + offset.second);
+            if (c) out.push_back(c);
+        }
+        return;
+    }
+
+    size_t first = out.size();
+    int radiusSq = radius * radius;
+    for (Combatant* c : occupants) {
+        if (getSquaredDistance(cx, cy, c->getX(), c->getY()) <= radiusSq) out.push_back(c);
+    }
+    std::sort(out.begin() + first, out.end(), [](const Combatant* a, const Combatant* b) {
+        if (a->getY() != b->getY()) return a->getY() < b->getY();
+        return a->getX() < b->getX();
+    });
+}
+
+const std::pmr::vector<Combatant*>& Grid::unitsInRadius(int cx, int cy, int radius) {
+    areaScratch.clear();
+    queryRadius(cx, cy, radius, areaScratch);
+    return areaScratch;
+}
+
+void Grid::saveState(BattleState& state) const {
+    state.cells.resize(combatantMap.size());
+    for (size_t i = 0; i < combatantMap.size(); ++i) {
+        state.cells[i] = combatantMap[i] ? combatantMap[i]->getSlot() : -1;
+    }
+    state.occupants.resize(occupants.size());
+    for (size_t i = 0; i < occupants.size(); ++i) {
+        state.occupants[i] = occupants[i]->getSlot();
+    }
+}
+
+void Grid::restoreState(const BattleState& state, const std::pmr::vector<Combatant*>& participants) {
+    for (size_t i = 0; i < combatantMap.size(); ++i) {
+        combatantMap[i] = state.cells[i] == -1 ? nullptr : participants[state.cells[i]];
+    }
+
+    std::fill(aliveBoard.begin(), aliveBoard.end(), 0);
+    for (auto& board : teamBoards) std::fill(board.begin(), board.end(), 0);
+    for (auto& bucket : buckets) bucket.clear();
+    for (Combatant* c : participants) c->setGrid(nullptr);
+
+    occupants.clear();
+    for (int slot : state.occupants) {
+        Combatant* c = participants[slot];
+        occupants.push_back(c);
+        c->setGrid(this);
+        setOccupantAlive(c, cellIndex(c->getX(), c->getY()), c->isAlive());
+    }
+}
+
+void Grid::drawGrid(std::ostream& out) {
+    out << "\n--- Battlefield ---\n";
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
-            std::cout << "[";
-            if (combatantMap[y][x] != nullptr) {
-                if (combatantMap[y][x]->isAlive())
-                    std::cout << combatantMap[y][x]->getName()[0];
+            out << "[";
+            Combatant* c = combatantMap[cellIndex(x, y)];
+            if (c != nullptr) {
+                if (c->isAlive())
+                    out << c->getName()[0];
                 else
-                    std::cout << "x";
+                    out << "x";
             }
             else {
-                std::cout << " ";
+                static const char TERRAIN_GLYPHS[] = { ' ', ':', '^', '~', '#' };
+                out << TERRAIN_GLYPHS[static_cast<int>(terrainMap[cellIndex(x, y)])];
             }
-            std::cout << "]";
+            out << "]";
         }
-        std::cout << "\n";
+        out << "\n";
     }
-    std::cout << "-------------------\n";
+    out << "-------------------\n";
 }
 
 // ==========================================
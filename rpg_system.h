@@ -2,12 +2,21 @@
 #define RPG_SYSTEM_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <iostream>
+#include <utility>
+#include <cstdint>
+#include "rng.h"
+#include "combat_events.h"
 
 class Combatant;
 class Grid;
+class BattleManager;
+class Pathfinder;
+struct BattleState;
 
 enum ActionCost {
     COST_MOVE_BASE = 1,
@@ -18,28 +27,154 @@ enum ActionCost {
     COST_ATTACK = 6
 };
 
+// Extra ticks to step onto each terrain, on top of the move cost; -1 = impassable.
+enum class Terrain : uint8_t { Open, Rough, Forest, Water, Wall, Count };
+constexpr int TERRAIN_MOVE_COST[] = { 0, 1, 2, 4, -1 };
+static_assert(sizeof(TERRAIN_MOVE_COST) / sizeof(int) == static_cast<int>(Terrain::Count), "TERRAIN_MOVE_COST out of date");
+
+constexpr int maxTerrainMoveCost() {
+    int most = 0;
+    for (int cost : TERRAIN_MOVE_COST) most = cost > most ? cost : most;
+    return most;
+}
+
+// ==========================================
+// Interned Content IDs
+// ==========================================
+// Content names are resolved to these once at construction; the combat path
+// only ever compares small integers. Unknown names resolve to the first entry.
+enum class Element : uint8_t {
+    None, Physical, Magical, Standard,
+    Fire, Ice, Psi, Bio, Electricity, Earth, Wind, Poison, Acid, Naughtium,
+    Reflect,
+    Count
+};
+
+enum class SpellCategory : uint8_t { Debuff, Buff, Count };
+enum class ItemCategory : uint8_t { None, Healing, RestoreMP, Buff, Debuff, Count };
+enum class StatusType : uint8_t { Burn, Acid };
+
+Element elementFromName(const std::string& name);
+SpellCategory spellCategoryFromName(const std::string& name);
+ItemCategory itemCategoryFromName(const std::string& name);
+
+const char* elementName(Element element);
+const char* spellCategoryName(SpellCategory category);
+const char* itemCategoryName(ItemCategory category);
+const char* statusName(StatusType type);
+
+// ==========================================
+// Elemental Relationships
+// ==========================================
+constexpr int ELEMENT_COUNT = static_cast<int>(Element::Count);
+
+struct ElementalTable {
+    float multiplier[ELEMENT_COUNT][ELEMENT_COUNT];
+};
+
+constexpr ElementalTable buildElementalTable() {
+    ElementalTable table{};
+    for (int a = 0; a < ELEMENT_COUNT; ++a) {
+        for (int d = 0; d < ELEMENT_COUNT; ++d) {
+            table.multiplier[a][d] = (a == d && a != static_cast<int>(Element::None)) ? 0.5f : 1.0f;
+        }
+    }
+    const Element opposed[][2] = {
+        { Element::Fire, Element::Ice },
+        { Element::Psi, Element::Bio },
+        { Element::Electricity, Element::Earth },
+        { Element::Wind, Element::Poison },
+    };
+    for (const auto& pair : opposed) {
+        int a = static_cast<int>(pair[0]);
+        int b = static_cast<int>(pair[1]);
+        table.multiplier[a][b] = 2.0f;
+        table.multiplier[b][a] = 2.0f;
+    }
+    return table;
+}
+
+constexpr ElementalTable ELEMENTAL_TABLE = buildElementalTable();
+
+constexpr float getElementalMultiplier(Element atk, Element def) {
+    return ELEMENTAL_TABLE.multiplier[static_cast<int>(atk)][static_cast<int>(def)];
+}
+
 // ==========================================
 // Status Effect Struct
 // ==========================================
 struct StatusEffect {
-    std::string name;
+    StatusType type;
     int durationTicks;
     int potency;
+    int stacks = 1;     // Identical statuses applied back to back share one entry
+};
+
+// A unit's active statuses, kept in application order, with running potency
+// totals per StatusType. A status matching the last entry's type and
+// duration stacks onto it (multi-hit weapons). The first CAPACITY entries
+// live inline; any beyond that spill into `overflow`, which allocates from
+// the owning store's memory resource.
+struct StatusList {
+    static const int CAPACITY = 8;
+    static const int TYPE_COUNT = 2;
+    static const int MAX_STACKS = 0xFFFF;  // Loaders reject more; each stack is reported as it fades
+    using allocator_type = std::pmr::polymorphic_allocator<StatusEffect>;
+
+    StatusEffect entries[CAPACITY];
+    std::pmr::vector<StatusEffect> overflow;    // Entries CAPACITY..count-1
+    int potencyTotal[TYPE_COUNT] = {};
+    int count = 0;
+
+    StatusList() = default;
+    explicit StatusList(const allocator_type& alloc) : overflow(alloc) {}
+    StatusList(const StatusList& other) = default;
+    StatusList(const StatusList& other, const allocator_type& alloc);
+    StatusList& operator=(const StatusList& other) = default;
+
+    StatusEffect& operator[](int i) { return i < CAPACITY ? entries[i] : overflow[i - CAPACITY]; }
+    const StatusEffect& operator[](int i) const { return i < CAPACITY ? entries[i] : overflow[i - CAPACITY]; }
+
+    void add(const StatusEffect& effect);
+    // Appends without stacking, for decoders restoring a saved list.
+    void push(const StatusEffect& effect);
+    void clear();
+    int totalPotency(StatusType type) const { return potencyTotal[static_cast<int>(type)]; }
+
+    // Advances every status by `ticks` at once, applying Burn damage to `hp`
+    // (clamped at 0). Stops after the tick on which `hp` reaches 0, exactly as
+    // ticking one at a time would.
+    // Statuses that ran out are written to `expired`, which must have room
+    // for `count` entries, in the order they would have faded (each entry
+    // fading `stacks` times); returns how many there were.
+    int advance(int ticks, int& hp, StatusEffect* expired);
 };
 
 // ==========================================
 // 1. Item & Ability Classes
 // ==========================================
+// These are content definitions. Each distinct one lives once in the
+// ContentCatalog (content_catalog.h); combatants refer to them by id.
+typedef uint16_t WeaponId;
+typedef uint16_t ArmorId;
+typedef uint16_t SpellId;
+typedef uint16_t ItemId;
+const int CONTENT_ID_LIMIT = 1 << 16;
 
 class Item {
 public:
     std::string name;
-    int quantity;
     float range;
-    std::string category;
+    ItemCategory category;
     int potency;
 
-    Item(std::string n, int qty, float rng, std::string cat, int pot);
+    Item(std::string n, float rng, std::string cat, int pot);
+};
+
+// One inventory stack: the item type and how many this unit carries.
+struct InventoryEntry {
+    ItemId item;
+    int quantity;
 };
 
 class Armor {
@@ -48,7 +183,7 @@ public:
     int damageResistance;
     int damageThreshold;
     float evasion;
-    std::string elementType;
+    Element element;
     int magicalDefense;
 
     Armor(std::string n, int dr, int dt, float eva, std::string elem, int magDef);
@@ -62,7 +197,7 @@ public:
     float accuracy;
     float range;
     int numberOfAttacks;
-    std::string elementType;
+    Element element;
 
     Weapon(std::string n, int atk, float acc, float rng, int num, std::string elem);
     Weapon();
@@ -75,48 +210,152 @@ public:
     int mpCost;
     float range;
     int duration;
-    std::string elementType;
-    int aoe;               // New: Area of Effect
-    std::string category;  // New: "Buff" or "Debuff"
+    Element element;
+    int aoe;                 // New: Area of Effect
+    SpellCategory category;  // New: Buff or Debuff
 
     Spell(std::string n, int matk, int cost, float rng, int dur, std::string elem, int area, std::string cat);
 };
 
 // ==========================================
-// 2. Combatant Class
+// Matchup Coefficients
+// ==========================================
+// A physical hit rolls productDamage = attack * multiplier / 10.
+const int ATTACK_MULTIPLIER_MIN = 7;
+const int ATTACK_MULTIPLIER_MAX = 13;
+const int ATTACK_MULTIPLIER_COUNT = ATTACK_MULTIPLIER_MAX - ATTACK_MULTIPLIER_MIN + 1;
+
+// The dice-free part of one weapon's swings against one armor.
+struct AttackMatchup {
+    uint64_t key = ~0ull;
+    float hitChance = 0.0f;
+    float elemMult = 1.0f;
+    int damageThreshold = 0;
+    int product[ATTACK_MULTIPLIER_COUNT] = {};     // productDamage per multiplier
+    // Non-crit damage per multiplier after threshold, DR and element, for the
+    // effective DR `columnDR`; filled lazily, one bit per multiplier.
+    int columnDR = 0;
+    uint32_t columnFilled = 0;
+    int damage[ATTACK_MULTIPLIER_COUNT] = {};
+
+    int damageAt(int multiplier, int effectiveDR);
+};
+
+// One spell's damage against one armor; spells have no dice.
+struct SpellMatchup {
+    uint64_t key = ~0ull;
+    float elemMult = 1.0f;
+    int damage = 0;
+};
+
+// Per-battle cache of weapon x armor and spell x armor coefficients, so a
+// swing is a lookup plus the random multiplier. Content ids never change
+// meaning, so entries never go stale: equipping something else just looks
+// up another entry. The one live input, the target's effective DR (armor,
+// acid, guard), versions the damage column: a swing against a different DR
+// rebuilds it. Direct-mapped; a colliding matchup evicts the old one, and
+// a returned reference lasts until the next lookup of the same kind.
+class MatchupTable {
+public:
+    static const int CAPACITY = 64;
+
+    AttackMatchup& attack(WeaponId weapon, ArmorId armor);
+    const SpellMatchup& spell(SpellId spell, ArmorId armor);
+
+private:
+    AttackMatchup attacks[CAPACITY];
+    SpellMatchup spells[CAPACITY];
+};
+
+// ==========================================
+// 2. Combatant Store & Class
 // ==========================================
 
+// Hot per-unit state lives here in parallel arrays indexed by a dense slot, so
+// whole-battle loops (winner checks, target search, scheduling) stream through
+// a few contiguous arrays instead of chasing Combatant pointers.
+struct CombatantStore {
+    enum Flags : uint8_t {
+        FLAG_GUARDING = 1,
+        FLAG_FLED = 2
+    };
+
+    std::pmr::vector<int> currentHealth;
+    std::pmr::vector<int> maxHealth;
+    std::pmr::vector<int> currentMagicPoints;
+    std::pmr::vector<int> maxMagicPoints;
+    std::pmr::vector<int> initiative;
+    std::pmr::vector<int> morale;
+    std::pmr::vector<int> xPos;
+    std::pmr::vector<int> yPos;
+    std::pmr::vector<int> teamId;
+    std::pmr::vector<uint8_t> flags;
+    std::pmr::vector<StatusList> statuses;
+
+    explicit CombatantStore(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    int size() const;
+    int addRow(int team, int hp, int mp, int init, int mor);
+    // Appends a copy of `src`'s row `srcSlot` and returns the new slot.
+    int copyRow(const CombatantStore& src, int srcSlot);
+
+    bool isAlive(int slot) const {
+        return currentHealth[slot] > 0 && !(flags[slot] & FLAG_FLED);
+    }
+};
+
+// A Combatant is a handle onto one store row plus its cold data (names,
+// equipment, spells, inventory). A freshly built combatant owns a
+// one-row store; joining a BattleManager moves the row into the battle's store.
+// Names, lists and the own store are allocated from `memory`.
 class Combatant {
 private:
-    std::string name;
-    std::string team;
-    int maxHealth;
-    int currentHealth;
-    int maxMagicPoints;
-    int currentMagicPoints;
-
-    int initiative;
-    int morale;
-    bool guarding = false;
-    bool fled = false;
-
-    Armor equippedArmor;
-    Weapon equippedWeapon;
-    std::vector<Spell> knownSpells;
-    std::vector<Item> inventory;
-    std::vector<StatusEffect> statuses;
-
-    int xPos = -1;
-    int yPos = -1;
+    std::pmr::memory_resource* memory;
+    std::pmr::string name;
+    std::pmr::string team;
+
+    CombatantStore* ownStore;
+    CombatantStore* store;
+    int slot;
+
+    WeaponId weaponId = 0;
+    ArmorId armorId = 0;
+    std::pmr::vector<SpellId> knownSpells;
+    std::pmr::vector<InventoryEntry> inventory;
+
+    CombatEventSink* eventSink = nullptr;
+
+    BattleManager* scheduler = nullptr;
+    Grid* grid = nullptr;
+
+    // The battle's matchup cache, or a per-thread one outside a battle.
+    MatchupTable& matchups() const;
+
+    // Re-keys this unit in its battle's initiative queue and the grid's
+    // occupancy boards after a change to initiative or to whether it can act.
+    void notifyStateChanged();
+
+    void emit(CombatEventType type, const Combatant* target = nullptr, int value = 0, int extra = 0, uint8_t detail = 0) const {
+        emitEvent(eventSink, type, this, target, value, extra, detail);
+    }
+    // One StatusExpired per stack of each faded status.
+    void emitExpired(const StatusEffect* expired, int count);
 
 public:
-    Combatant(std::string n, std::string teamName, int hp, int mp, int init, int mor);
+    Combatant(std::string_view n, std::string_view teamName, int hp, int mp, int init, int mor,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    ~Combatant();
+    Combatant(const Combatant&) = delete;
+    Combatant& operator=(const Combatant&) = delete;
 
     // Getters
-    std::string getName() const;
-    std::string getTeam() const;
+    const std::pmr::string& getName() const;
+    const std::pmr::string& getTeam() const;
+    int getTeamId() const;
     int getHP() const;
+    int getMaxHP() const;
     int getMP() const;
+    int getMaxMP() const;
     int getX() const;
     int getY() const;
     int getInitiative() const;
@@ -127,28 +366,52 @@ public:
     int getMorale() const;
 
     const Armor& getArmor() const;
+    ArmorId getArmorId() const { return armorId; }
     int getEffectiveDR() const;
-    const std::vector<Item>& getInventory() const;
-    const std::vector<Spell>& getSpells() const;
+    // Summed potency of every active status of `type`.
+    int getStatusPotency(StatusType type) const;
     const Weapon& getWeapon() const;
+    WeaponId getWeaponId() const { return weaponId; }
+    const std::pmr::vector<SpellId>& getSpells() const { return knownSpells; }
+    const Spell& getSpell(int spellIndex) const;
+    const std::pmr::vector<InventoryEntry>& getInventory() const { return inventory; }
+    const Item& getItem(int itemIndex) const;
+    // Index of the stack holding `item`, or -1.
+    int findItem(ItemId item) const;
 
     // Actions
     void setPosition(int x, int y);
+    void setEventSink(CombatEventSink* sink);
+    CombatEventSink* getEventSink() const;
+    void setGrid(Grid* g);
+    // Slot of this unit's row in its current store (its participant index once
+    // it has joined a battle).
+    int getSlot() const;
+    void moveToStore(CombatantStore& target, BattleManager* manager);
+    void equipArmor(ArmorId armor);
+    void equipWeapon(WeaponId weapon);
+    void learnSpell(SpellId spell);
+    // Swaps the spell known at `spellIndex` for `spell`, keeping its index.
+    void replaceSpell(int spellIndex, SpellId spell);
+    // Adds to the stack of the same item type, or starts a new one.
+    void addItem(ItemId item, int quantity);
+    // By-value forms intern the definition into the catalog first.
     void equipArmor(const Armor& armor);
     void equipWeapon(const Weapon& weapon);
     void learnSpell(const Spell& spell);
-    void addItem(const Item& item);
+    void addItem(const Item& item, int quantity);
+    void setItemQuantity(int itemIndex, int quantity);
     void printStats() const;
 
     // Status Changes
-    void takeDamage(int amount, std::string element = "None", Grid* grid = nullptr);
+    void takeDamage(int amount, Element element = Element::None, Grid* battleGrid = nullptr);
     void drainMP(int amount);
     void heal(int amount);
     void restoreMP(int amount);
     void flee();
     void reduceMorale(int amount);
     void regainMorale(int amount);
-    void applyStatus(std::string name, int duration, int potency);
+    void applyStatus(StatusType type, int duration, int potency);
 
     // Turn Management
     void startTurn();
@@ -159,7 +422,7 @@ public:
     bool checkRange(const Combatant& target, float range) const;
 
     // Combat Functions 
-    bool attack(Combatant& target, Grid& grid);
+    bool attack(Combatant& target, Grid& grid, BattleRng& rng);
     bool castSpell(Combatant& target, int spellIndex, Grid& grid);
     bool useItem(Combatant& target, int itemIndex);
 };
@@ -169,13 +432,49 @@ public:
 // ==========================================
 class BattleManager {
 private:
-    std::vector<Combatant*> participants;
+    std::pmr::vector<Combatant*> participants;
+    CombatantStore units;
+    BattleRng rng;
+    CombatEventSink* eventSink = nullptr;
+    MatchupTable matchups;
+
+    // Indexed binary min-heap of living participants keyed on
+    // (initiative, participant slot). heapPos[slot] is -1 when unscheduled.
+    struct ScheduleEntry {
+        int initiative;
+        int slot;
+    };
+    std::pmr::vector<ScheduleEntry> heap;
+    std::pmr::vector<int> heapPos;
+    std::pmr::vector<int> tiedSlots;
+    std::pmr::vector<int> tieStack;
+
+    static bool scheduledBefore(const ScheduleEntry& a, const ScheduleEntry& b);
+    void placeEntry(int index, const ScheduleEntry& entry);
+    void siftUp(int index);
+    void siftDown(int index);
 
 public:
+    explicit BattleManager(uint64_t seed = 0, uint64_t stream = 0,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    BattleRng& getRng();
+    // Attaches `sink` to the battle and every participant (nullptr detaches).
+    void setEventSink(CombatEventSink* sink);
+    CombatEventSink* getEventSink() const;
     void addParticipant(Combatant* c);
     Combatant* getNextActiveCombatant();
+    // Called by a participant whenever its initiative or liveness changes.
+    void reschedule(int slot);
     std::string getWinner();
-    const std::vector<Combatant*>& getParticipants() const;
+    const std::pmr::vector<Combatant*>& getParticipants() const;
+    const CombatantStore& getStore() const;
+    // Damage coefficients cached for this battle's participants. Not part of
+    // the saved state: it only ever holds values derived from content.
+    MatchupTable& getMatchups() { return matchups; }
+
+    // Copies unit rows, turn order and RNG position to or from `state`.
+    void saveState(BattleState& state) const;
+    void restoreState(const BattleState& state);
 };
 
 // ==========================================
@@ -183,20 +482,116 @@ public:
 // ==========================================
 class Grid {
 private:
+    std::pmr::memory_resource* memory;
     int width;
     int height;
-    std::vector<std::vector<int>> terrainMap;
-    std::vector<std::vector<Combatant*>> combatantMap;
+    int boardWords;
+
+    // Row-major cell storage: cell (x, y) lives at y * width + x.
+    std::pmr::vector<Terrain> terrainMap;
+    std::pmr::vector<Combatant*> combatantMap;
+    int terrainVersion = 0;
+
+    // One bit per cell: living occupants of any team, and per team id.
+    std::pmr::vector<uint64_t> aliveBoard;
+    std::pmr::vector<std::pmr::vector<uint64_t>> teamBoards;
+
+    int cellIndex(int x, int y) const { return y * width + x; }
+    std::pmr::vector<uint64_t>& teamBoard(int teamId);
+    void setAliveBit(int cell, int teamId, bool alive);
+    bool isEnemyCell(int cell, int teamId) const;
+
+    // Living occupants bucketed per team by BUCKET_SIZE x BUCKET_SIZE block of
+    // cells, kept in step with the alive bits for nearest-unit queries.
+    // Team t's buckets start at t * bucketsWide * bucketsHigh.
+    static const int BUCKET_SHIFT = 3;
+    static const int BUCKET_SIZE = 1 << BUCKET_SHIFT;
+    int bucketsWide;
+    int bucketsHigh;
+    struct BucketEntry {
+        int x;
+        int y;
+        int slot;
+        Combatant* unit;
+    };
+    std::pmr::vector<std::pmr::vector<BucketEntry>> buckets;
+    std::pmr::vector<BucketEntry>& bucketOf(int cell, int teamId);
+    // Sets `c`'s alive bit at `cell` and adds it to or drops it from the buckets.
+    void setOccupantAlive(Combatant* c, int cell, bool alive);
+
+    struct NearestCandidate {
+        int distSq;
+        int slot;
+        Combatant* unit;
+    };
+    std::pmr::vector<NearestCandidate> nearestScratch;
+    // Leaves the k nearest living occupants of `teamId` in nearestScratch.
+    void collectNearest(int x, int y, int teamId, int k);
+
+    // Everything currently standing on the grid, in placement order.
+    std::pmr::vector<Combatant*> occupants;
+
+    // diskStencils[r] lists the (dx, dy) offsets with dx*dx + dy*dy <= r*r in
+    // row-major order; built on first use of each radius.
+    std::pmr::vector<std::pmr::vector<std::pair<int, int>>> diskStencils;
+    const std::pmr::vector<std::pair<int, int>>& getDiskStencil(int radius);
+
+    Pathfinder* pathfinder = nullptr;
+
+    std::pmr::vector<Combatant*> areaScratch;
 
 public:
-    Grid(int w, int h);
+    Grid(int w, int h, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    ~Grid();
+    Grid(const Grid&) = delete;
+    Grid& operator=(const Grid&) = delete;
     int getWidth() const { return width; }
     int getHeight() const { return height; }
     Combatant* getCombatantAt(int x, int y);
 
+    Terrain getTerrain(int x, int y) const { return terrainMap[cellIndex(x, y)]; }
+    void setTerrain(int x, int y, Terrain terrain);
+    // Ticks to step onto (x, y) before any engagement penalty; -1 if impassable.
+    int getEnterCost(int x, int y) const;
+    // Bumped on every terrain change so cached paths know to rebuild.
+    int getTerrainVersion() const { return terrainVersion; }
+
+    // Cells holding living units of `teamId`, one bit per cell.
+    const std::pmr::vector<uint64_t>& getTeamBoard(int teamId);
+    Pathfinder& getPathfinder();
+    // Where the grid, its pathfinder and their scratch allocate from.
+    std::pmr::memory_resource* getMemoryResource() const { return memory; }
+
     bool placeCombatant(Combatant* c, int x, int y);
     int moveCombatant(Combatant* c, int dx, int dy);
-    void drawGrid();
+    void drawGrid(std::ostream& out = std::cout);
+
+    // Bit i is set when the neighbour at (0,+1), (0,-1), (+1,0), (-1,0)[i]
+    // is a living unit that is not on `teamId`.
+    unsigned adjacentEnemyMask(int x, int y, int teamId) const;
+
+    // Re-syncs the occupancy boards after `c` died, fled or was revived.
+    void refreshOccupant(Combatant* c);
+
+    // Nearest living occupant of `teamId` to (x, y) by straight-line distance,
+    // ties going to the lowest participant slot; nullptr if there is none.
+    Combatant* nearestOfTeam(int x, int y, int teamId);
+    // Appends up to `k` living occupants of `teamId` to `out`, nearest first,
+    // in the same order. Searches outward ring by ring of buckets and stops
+    // once no unsearched bucket can hold anything closer.
+    void nearestOfTeam(int x, int y, int teamId, int k, std::pmr::vector<Combatant*>& out);
+
+    // Appends every occupant within `radius` of (cx, cy) to `out` in row-major
+    // order. Cost is bounded by the smaller of the disk area and the occupant count.
+    void queryRadius(int cx, int cy, int radius, std::pmr::vector<Combatant*>& out);
+    // The same into a buffer the grid reuses; valid until the next call.
+    const std::pmr::vector<Combatant*>& unitsInRadius(int cx, int cy, int radius);
+
+    // Copies cell occupancy to or from `state`. Restore after the battle's
+    // manager, since the occupancy boards are rebuilt from the restored rows;
+    // `participants` maps the saved slots back to units.
+    void saveState(BattleState& state) const;
+    void restoreState(const BattleState& state, const std::pmr::vector<Combatant*>& participants);
 };
 
 // ==========================================
@@ -216,7 +611,14 @@ public:
 };
 
 // Helper
-float getElementalMultiplier(const std::string& atkElem, const std::string& defElem);
+// Maps a team name to a small stable id, shared by every battle in the process.
+int internTeam(std::string_view name);
 float getDistance(int x1, int y1, int x2, int y2);
 
+inline int getSquaredDistance(int x1, int y1, int x2, int y2) {
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    return dx * dx + dy * dy;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "scenario.h"
+#include "content_catalog.h"
+#include <iostream>
+
+namespace {
+
+// Content used by the built-in scenarios, in content file format. Loaded
+// the first time a scenario is built, after any --content file, so names a
+// content file already defines keep that file's stats.
+const char* const BUILTIN_CONTENT = R"(
+item   "Health Potion"  range=4 category=Healing potency=50
+item   "Magic Potion"   range=4 category=RestoreMP potency=40
+
+weapon "Iron Sword"     attack=50 accuracy=0.9 range=1.5 hits=1 element=Physical
+weapon "Wooden Staff"   attack=20 accuracy=0.67 range=1.5 hits=1 element=Magical
+weapon "Wood Bow"       attack=40 accuracy=0.5 range=11 hits=1 element=Physical
+weapon "Flame Blade"    attack=40 accuracy=0.85 range=1.5 hits=2 element=Fire
+weapon "Acid Bow"       attack=35 accuracy=0.6 range=9 hits=1 element=Acid
+
+armor  "Iron Armor"     dr=40 element=Standard
+armor  "Cloth Armor"    dr=10 element=Magical
+armor  "Wooden Armor"   dr=20 element=Standard
+
+spell  "Fireball"       attack=64 cost=15 range=15 duration=0 element=Fire aoe=2 category=Debuff
+)";
+
+struct ScenarioContent {
+    ItemId healthPotion, magicPotion;
+    WeaponId ironSword, woodenStaff, woodBow, flameBlade, acidBow;
+    ArmorId ironArmor, clothArmor, woodenArmor;
+    SpellId fireball;
+};
+
+const ScenarioContent& scenarioContent() {
+    static const ScenarioContent content = []() {
+        ContentCatalog& catalog = contentCatalog();
+        std::string error;
+        if (!catalog.loadText(BUILTIN_CONTENT, error)) std::cerr << "[Content] Built-in content: " << error << "\n";
+
+        ScenarioContent c;
+        c.healthPotion = static_cast<ItemId>(catalog.findItem("Health Potion"));
+        c.magicPotion = static_cast<ItemId>(catalog.findItem("Magic Potion"));
+        c.ironSword = static_cast<WeaponId>(catalog.findWeapon("Iron Sword"));
+        c.woodenStaff = static_cast<WeaponId>(catalog.findWeapon("Wooden Staff"));
+        c.woodBow = static_cast<WeaponId>(catalog.findWeapon("Wood Bow"));
+        c.flameBlade = static_cast<WeaponId>(catalog.findWeapon("Flame Blade"));
+        c.acidBow = static_cast<WeaponId>(catalog.findWeapon("Acid Bow"));
+        c.ironArmor = static_cast<ArmorId>(catalog.findArmor("Iron Armor"));
+        c.clothArmor = static_cast<ArmorId>(catalog.findArmor("Cloth Armor"));
+        c.woodenArmor = static_cast<ArmorId>(catalog.findArmor("Wooden Armor"));
+        c.fireball = static_cast<SpellId>(catalog.findSpell("Fireball"));
+        return c;
+    }();
+    return content;
+}
+
+} // namespace
+
+Battle::Battle(int w, int h, std::pmr::memory_resource* memory)
+    : memory(memory), units(memory), grid(w, h, memory), manager(0, 0, memory) {
+}
+
+Battle::~Battle() {
+    for (Combatant* unit : units) deleteObject(memory, unit);
+}
+
+Combatant* Battle::spawn(std::string_view name, std::string_view team, int hp, int mp, int init, int mor) {
+    Combatant* c = newObject<Combatant>(memory, name, team, hp, mp, init, mor, memory);
+    units.push_back(c);
+    manager.addParticipant(c);
+    return c;
+}
+
+void Battle::saveState(BattleState& state) const {
+    manager.saveState(state);
+    grid.saveState(state);
+    state.itemQuantities.clear();
+    for (const auto& unit : units) {
+        for (const auto& stack : unit->getInventory()) state.itemQuantities.push_back(stack.quantity);
+    }
+}
+
+void Battle::restoreState(const BattleState& state) {
+    manager.restoreState(state);
+    grid.restoreState(state, manager.getParticipants());
+    size_t next = 0;
+    for (auto& unit : units) {
+        int count = static_cast<int>(unit->getInventory().size());
+        for (int i = 0; i < count; ++i) unit->setItemQuantity(i, state.itemQuantities[next++]);
+    }
+}
+
+std::unique_ptr<Battle> Battle::clone() const {
+    auto copy = std::make_unique<Battle>(grid.getWidth(), grid.getHeight());
+    for (const auto& unit : units) {
+        Combatant* c = copy->spawn(unit->getName(), unit->getTeam(), unit->getMaxHP(), unit->getMaxMP(),
+            unit->getInitiative(), unit->getMorale());
+        c->equipWeapon(unit->getWeaponId());
+        c->equipArmor(unit->getArmorId());
+        for (SpellId spell : unit->getSpells()) c->learnSpell(spell);
+        for (const auto& stack : unit->getInventory()) c->addItem(stack.item, stack.quantity);
+    }
+    for (int y = 0; y < grid.getHeight(); ++y) {
+        for (int x = 0; x < grid.getWidth(); ++x) copy->grid.setTerrain(x, y, grid.getTerrain(x, y));
+    }
+    BattleState state;
+    saveState(state);
+    copy->restoreState(state);
+    return copy;
+}
+
+namespace {
+
+void populateDefaultScenario(Battle* battle) {
+    const ScenarioContent& content = scenarioContent();
+
+    // 2. Combatants (Good Guys)
+    Combatant* dwayne = battle->spawn("Dwayne", "Good Guys", 200, 0, 5, 100);
+    dwayne->equipWeapon(content.ironSword);
+    dwayne->equipArmor(content.ironArmor);
+    dwayne->addItem(content.healthPotion, 1);
+
+    Combatant* elizabeth = battle->spawn("Elizabeth", "Good Guys", 100, 75, 7, 70);
+    elizabeth->equipWeapon(content.woodenStaff);
+    elizabeth->equipArmor(content.clothArmor);
+    elizabeth->addItem(content.magicPotion, 1);
+    elizabeth->learnSpell(content.fireball);
+
+    // 3. Combatants (Bad Guys)
+    Combatant* goblin1 = battle->spawn("Goblin Archer A", "Bad Guys", 90, 0, 9, 40);
+    goblin1->equipWeapon(content.woodBow);
+    goblin1->equipArmor(content.woodenArmor);
+
+    Combatant* goblin2 = battle->spawn("Goblin Archer B", "Bad Guys", 90, 0, 9, 40);
+    goblin2->equipWeapon(content.woodBow);
+    goblin2->equipArmor(content.woodenArmor);
+
+    battle->grid.placeCombatant(dwayne, 0, 0);
+    battle->grid.placeCombatant(elizabeth, 2, 0);
+    battle->grid.placeCombatant(goblin1, 10, 0);
+    battle->grid.placeCombatant(goblin2, 0, 10);
+}
+
+} // namespace
+
+std::unique_ptr<Battle> buildDefaultScenario() {
+    // 1. Grid Setup (12x12 to fit 10,0 and 0,10)
+    auto battle = std::make_unique<Battle>(12, 12);
+    populateDefaultScenario(battle.get());
+    return battle;
+}
+
+Battle* buildDefaultScenario(BattleArena& arena) {
+    Battle* battle = arena.create<Battle>(12, 12, &arena);
+    populateDefaultScenario(battle);
+    return battle;
+}
+
+std::unique_ptr<Battle> buildSkirmishScenario(int unitsPerTeam) {
+    const ScenarioContent& content = scenarioContent();
+
+    int side = 4;
+    while (side * side < unitsPerTeam * 8) side++;
+    auto battle = std::make_unique<Battle>(side, side);
+
+    // A broken wall across the middle with rough ground and woods either side.
+    int mid = side / 2;
+    for (int y = 1; y < side - 1; ++y) {
+        if (y % 4 == 0) continue;
+        battle->grid.setTerrain(mid, y, Terrain::Wall);
+        battle->grid.setTerrain(mid - 1, y, (y % 3 == 0) ? Terrain::Forest : Terrain::Rough);
+        if (y % 5 == 0) battle->grid.setTerrain(mid + 1, y, Terrain::Water);
+    }
+
+    const char* teams[] = { "Good Guys", "Bad Guys" };
+    for (int t = 0; t < 2; ++t) {
+        for (int i = 0; i < unitsPerTeam; ++i) {
+            std::string name = std::string(t == 0 ? "Knight " : "Raider ") + std::to_string(i + 1);
+            Combatant* c;
+            switch (i % 4) {
+            case 0:
+                c = battle->spawn(name, teams[t], 200, 0, 5 + i % 3, 100);
+                c->equipWeapon(content.ironSword);
+                c->equipArmor(content.ironArmor);
+                c->addItem(content.healthPotion, 2);
+                break;
+            case 1:
+                c = battle->spawn(name, teams[t], 150, 0, 6 + i % 3, 80);
+                c->equipWeapon(content.flameBlade);
+                c->equipArmor(content.woodenArmor);
+                break;
+            case 2:
+                c = battle->spawn(name, teams[t], 90, 0, 8 + i % 3, 40);
+                c->equipWeapon(content.acidBow);
+                c->equipArmor(content.woodenArmor);
+                break;
+            default:
+                c = battle->spawn(name, teams[t], 100, 75, 7 + i % 3, 70);
+                c->equipWeapon(content.woodenStaff);
+                c->equipArmor(content.clothArmor);
+                c->addItem(content.magicPotion, 1);
+                c->learnSpell(content.fireball);
+                break;
+            }
+            // Fill columns inward from each team's edge.
+            int column = i / side;
+            int x = (t == 0) ? column : side - 1 - column;
+            battle->grid.placeCombatant(c, x, i % side);
+        }
+    }
+    return battle;
+}
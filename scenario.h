@@ -0,0 +1,48 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include "rpg_system.h"
+#include "battle_state.h"
+#include "battle_arena.h"
+
+// ==========================================
+// Battle: owns one fight's units, grid and turn order
+// ==========================================
+// Every allocation the battle makes comes from `memory`: the default heap
+// unless the battle is built in a BattleArena.
+struct Battle {
+    std::pmr::memory_resource* memory;
+    std::pmr::vector<Combatant*> units;
+    Grid grid;
+    BattleManager manager;
+
+    Battle(int w, int h, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    ~Battle();
+    Battle(const Battle&) = delete;
+    Battle& operator=(const Battle&) = delete;
+
+    // Creates a combatant owned by this battle and registers it with the manager.
+    Combatant* spawn(std::string_view name, std::string_view team, int hp, int mp, int init, int mor);
+
+    // Snapshot / rewind the whole fight. Restoring only touches state that
+    // changes during play, so units must not be added after a save.
+    void saveState(BattleState& state) const;
+    void restoreState(const BattleState& state);
+
+    // Independent copy of this battle in its current state, without event sinks.
+    std::unique_ptr<Battle> clone() const;
+};
+
+// Dwayne & Elizabeth vs Two Goblin Archers on a 12x12 grid.
+std::unique_ptr<Battle> buildDefaultScenario();
+// The same built inside `arena`; it lives until the arena is reset.
+Battle* buildDefaultScenario(BattleArena& arena);
+
+// `unitsPerTeam` mixed melee, archers and casters per side, lined up on
+// opposite edges of a square grid. Used for benchmarks and search.
+std::unique_ptr<Battle> buildSkirmishScenario(int unitsPerTeam);
+
+#endif
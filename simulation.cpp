@@ -0,0 +1,307 @@
+#include "simulation.h"
+#include "battle_ai.h"
+#include "heap_counter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const long long BATTLES_PER_CLAIM = 64;
+
+} // namespace
+
+double SimulationResult::battlesPerSecond() const {
+    return seconds > 0.0 ? battles / seconds : 0.0;
+}
+
+void SimulationResult::merge(const SimulationResult& other) {
+    battles += other.battles;
+    goodWins += other.goodWins;
+    badWins += other.badWins;
+    draws += other.draws;
+    stalemates += other.stalemates;
+    heapAllocations += other.heapAllocations;
+    arenaPeakBytes = std::max(arenaPeakBytes, other.arenaPeakBytes);
+}
+
+void SimulationResult::print() const {
+    auto pct = [this](long long n) { return battles > 0 ? (100.0 * n) / battles : 0.0; };
+    std::cout << "=== SIMULATION RESULTS ===\n"
+        << "Battles:    " << battles << " in " << seconds << "s ("
+        << battlesPerSecond() << " battles/s)\n"
+        << "Good Guys:  " << goodWins << " (" << pct(goodWins) << "%)\n"
+        << "Bad Guys:   " << badWins << " (" << pct(badWins) << "%)\n"
+        << "Draws:      " << draws << " (" << pct(draws) << "%)\n"
+        << "Stalemates: " << stalemates << " (" << pct(stalemates) << "%)\n"
+        << "Heap allocs: ";
+    if (heapAllocations >= 0) std::cout << heapAllocations << " after warm-up";
+    else std::cout << "not counted, configure with RPG_COUNT_HEAP_ALLOCATIONS=ON";
+    std::cout << " (arena peak " << (arenaPeakBytes + 1023) / 1024 << " KiB)\n";
+}
+
+std::string runHeadlessBattle(Battle& battle, int maxTurns, ReplayRecorder* recorder, int* turnsPlayed) {
+    if (recorder) recorder->begin(battle);
+    std::string winner = "Stalemate";
+    int turn = 0;
+    for (; turn < maxTurns; ++turn) {
+        std::string current = battle.manager.getWinner();
+        if (current != "None") {
+            winner = current;
+            break;
+        }
+
+        Combatant* actor = battle.manager.getNextActiveCombatant();
+        if (!actor) {
+            winner = "Draw";
+            break;
+        }
+
+        actor->startTurn();
+        BattleAction action = actor->isBroken() ? choosePanicAction(actor, battle.grid)
+            : chooseAIAction(actor, battle.grid);
+        playTurn(actor, action, battle.manager, battle.grid);
+        if (recorder) recorder->recordTurn(actor, action, battle);
+    }
+    if (recorder) recorder->finish(battle);
+    if (turnsPlayed) *turnsPlayed = turn;
+    return winner;
+}
+
+SimulationResult runSimulation(long long battles, int threads, uint64_t seed, const BattleFileView* scenario,
+    BattleAnalytics* analytics) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    std::atomic<long long> nextBattle(0);
+    std::vector<SimulationResult> perThread(threads);
+    std::vector<BattleAnalytics> perThreadAnalytics(analytics ? threads : 0);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            SimulationResult& local = perThread[t];
+            BattleAnalytics* localAnalytics = analytics ? &perThreadAnalytics[t] : nullptr;
+            BattleArena arena;
+
+            // Instantiating a file interns its content by name, so a file
+            // scenario is built once and rewound to its opening state instead.
+            std::unique_ptr<Battle> fileBattle;
+            BattleState opening;
+            if (scenario) {
+                fileBattle = scenario->instantiate();
+                fileBattle->saveState(opening);
+            }
+
+            long long heapBefore = -1;
+            while (true) {
+                long long first = nextBattle.fetch_add(BATTLES_PER_CLAIM);
+                if (first >= battles) break;
+                long long last = std::min(first + BATTLES_PER_CLAIM, battles);
+
+                for (long long i = first; i < last; ++i) {
+                    Battle* battle;
+                    if (fileBattle) {
+                        fileBattle->restoreState(opening);
+                        battle = fileBattle.get();
+                    }
+                    else {
+                        battle = buildDefaultScenario(arena);
+                    }
+                    battle->manager.getRng().reseed(seed, static_cast<uint64_t>(i));
+                    if (localAnalytics) {
+                        battle->manager.setEventSink(localAnalytics);
+                        localAnalytics->beginBattle(*battle);
+                    }
+                    int turns = 0;
+                    std::string winner = runHeadlessBattle(*battle, 10000, nullptr, &turns);
+                    if (localAnalytics) localAnalytics->endBattle(winner, turns);
+
+                    local.battles++;
+                    if (winner == "Good Guys") local.goodWins++;
+                    else if (winner == "Bad Guys") local.badWins++;
+                    else if (winner == "Draw") local.draws++;
+                    else local.stalemates++;
+
+                    arena.reset();
+                    // The first battle sizes the arena and every reused buffer.
+                    if (local.battles == 1) heapBefore = heapAllocationCount();
+                }
+            }
+            if (heapBefore >= 0) local.heapAllocations = heapAllocationCount() - heapBefore;
+            local.arenaPeakBytes = arena.peakBytes();
+        });
+    }
+    for (auto& w : workers) w.join();
+    auto end = std::chrono::steady_clock::now();
+
+    SimulationResult total;
+    for (const auto& r : perThread) total.merge(r);
+    for (const auto& a : perThreadAnalytics) analytics->merge(a);
+    total.seconds = std::chrono::duration<double>(end - start).count();
+    if (heapAllocationCount() < 0) total.heapAllocations = -1;
+    return total;
+}
+
+void SnapshotBenchmark::print() const {
+    std::cout << "=== SNAPSHOT BENCHMARK (" << units << " units) ===\n"
+        << "Saves:    " << saves << " in " << saveSeconds << "s ("
+        << (saveSeconds > 0.0 ? saves / saveSeconds : 0.0) << " snapshots/s)\n"
+        << "Restores: " << restores << " in " << restoreSeconds << "s ("
+        << (restoreSeconds > 0.0 ? restores / restoreSeconds : 0.0) << " restores/s)\n";
+}
+
+SnapshotBenchmark runSnapshotBenchmark(int units, double seconds) {
+    auto battle = buildSkirmishScenario((units + 1) / 2);
+    battle->manager.getRng().reseed(0, 0);
+    runHeadlessBattle(*battle, units * 2);
+
+    SnapshotBenchmark result;
+    result.units = static_cast<int>(battle->units.size());
+    BattleState state;
+    battle->saveState(state);
+
+    // Time in batches so the clock is read rarely.
+    const int batch = 256;
+    auto timeLoop = [&](auto&& body, long long& count, double& elapsed) {
+        auto start = std::chrono::steady_clock::now();
+        do {
+            for (int i = 0; i < batch; ++i) body();
+            count += batch;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < seconds);
+    };
+    timeLoop([&]() { battle->saveState(state); }, result.saves, result.saveSeconds);
+    timeLoop([&]() { battle->restoreState(state); }, result.restores, result.restoreSeconds);
+    return result;
+}
+
+void MctsEvaluation::print() const {
+    auto pct = [this](long long n) { return battles > 0 ? (100.0 * n) / battles : 0.0; };
+    std::cout << "=== MCTS EVALUATION ===\n"
+        << "Battles:      " << battles << "\n"
+        << "MCTS wins:    " << mctsWins << " (" << pct(mctsWins) << "%)\n"
+        << "Greedy wins:  " << greedyWins << " (" << pct(greedyWins) << "%)\n"
+        << "Rollouts:     " << search.rollouts << " in " << search.seconds << "s ("
+        << search.rolloutsPerSecond() << " rollouts/s)\n";
+}
+
+MctsEvaluation runMctsEvaluation(long long battles, int unitsPerTeam, const MctsConfig& config) {
+    static const int goodTeam = internTeam("Good Guys");
+    const int maxTurns = 10000;
+    MctsEvaluation result;
+
+    for (long long i = 0; i < battles; ++i) {
+        auto baseline = buildSkirmishScenario(unitsPerTeam);
+        baseline->manager.getRng().reseed(config.seed, static_cast<uint64_t>(i));
+        if (runHeadlessBattle(*baseline, maxTurns) == "Good Guys") result.greedyWins++;
+
+        auto battle = buildSkirmishScenario(unitsPerTeam);
+        battle->manager.getRng().reseed(config.seed, static_cast<uint64_t>(i));
+        MctsConfig battleConfig = config;
+        battleConfig.seed = config.seed ^ (static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15ull);
+        MctsPlanner planner(*battle, battleConfig);
+
+        std::string winner = "Stalemate";
+        for (int turn = 0; turn < maxTurns; ++turn) {
+            winner = battle->manager.getWinner();
+            if (winner != "None") break;
+            Combatant* actor = battle->manager.getNextActiveCombatant();
+            if (!actor) {
+                winner = "Draw";
+                break;
+            }
+            actor->startTurn();
+            if (actor->isBroken()) {
+                handleBrokenUnit(actor, battle->manager, battle->grid);
+            }
+            else if (actor->getTeamId() == goodTeam) {
+                runMctsTurn(actor, *battle, planner);
+                result.search.rollouts += planner.getLastStats().rollouts;
+                result.search.treeNodes += planner.getLastStats().treeNodes;
+                result.search.seconds += planner.getLastStats().seconds;
+            }
+            else {
+                runAITurn(actor, battle->manager, battle->grid);
+            }
+        }
+        if (winner == "Good Guys") result.mctsWins++;
+        result.battles++;
+    }
+    return result;
+}
+
+void ScenarioLoadBenchmark::print() const {
+    auto rate = [this](double seconds) { return seconds > 0.0 ? loads / seconds : 0.0; };
+    std::cout << "=== SCENARIO LOAD BENCHMARK ===\n"
+        << "Loads:    " << loads << "\n"
+        << "Open:     " << openSeconds << "s (" << rate(openSeconds) << " files/s)\n"
+        << "Build:    " << buildSeconds << "s (" << rate(buildSeconds) << " battles/s)\n"
+        << "Builder:  " << builderSeconds << "s (" << rate(builderSeconds) << " battles/s, buildDefaultScenario)\n";
+}
+
+ScenarioLoadBenchmark runScenarioLoadBenchmark(const std::string& path, long long loads) {
+    ScenarioLoadBenchmark result;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < loads; ++i) {
+        BattleFile file;
+        if (!file.open(path)) return result;
+    }
+    auto opened = std::chrono::steady_clock::now();
+
+    BattleFile file;
+    file.open(path);
+    for (long long i = 0; i < loads; ++i) file.instantiate();
+    auto built = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < loads; ++i) buildDefaultScenario();
+    auto end = std::chrono::steady_clock::now();
+
+    result.loads = loads;
+    result.openSeconds = std::chrono::duration<double>(opened - start).count();
+    result.buildSeconds = std::chrono::duration<double>(built - opened).count();
+    result.builderSeconds = std::chrono::duration<double>(end - built).count();
+    return result;
+}
+
+void ReplayBenchmark::print() const {
+    std::cout << "=== REPLAY BENCHMARK ===\n"
+        << "Battles:  " << battles << " (" << turns << " turns, " << bytes << " bytes, "
+        << (turns > 0 ? static_cast<double>(bytes) / turns : 0.0) << " bytes/turn)\n"
+        << "Record:   " << recordSeconds << "s\n"
+        << "Replay:   " << replaySeconds << "s (" << (replaySeconds > 0.0 ? turns / replaySeconds : 0.0)
+        << " turns/s), " << (verified ? "all checksums verified" : "VERIFICATION FAILED") << "\n";
+}
+
+ReplayBenchmark runReplayBenchmark(long long battles, uint64_t seed) {
+    ReplayBenchmark result;
+    std::vector<std::vector<uint8_t>> replays;
+    replays.reserve(static_cast<size_t>(battles));
+
+    ReplayRecorder recorder;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < battles; ++i) {
+        auto battle = buildDefaultScenario();
+        battle->manager.getRng().reseed(seed, static_cast<uint64_t>(i));
+        runHeadlessBattle(*battle, 10000, &recorder);
+        replays.push_back(recorder.getData());
+        result.bytes += static_cast<long long>(recorder.getData().size());
+    }
+    auto recorded = std::chrono::steady_clock::now();
+
+    result.verified = true;
+    for (const auto& replay : replays) {
+        ReplayResult played = playReplay(replay);
+        if (!played.ok) result.verified = false;
+        result.turns += played.turns;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result.battles = battles;
+    result.recordSeconds = std::chrono::duration<double>(recorded - start).count();
+    result.replaySeconds = std::chrono::duration<double>(end - recorded).count();
+    return result;
+}
@@ -0,0 +1,116 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <string>
+#include "scenario.h"
+#include "mcts_ai.h"
+#include "replay.h"
+#include "battle_file.h"
+#include "battle_analytics.h"
+
+// ==========================================
+// Headless Monte-Carlo Battle Runner
+// ==========================================
+struct SimulationResult {
+    long long battles = 0;
+    long long goodWins = 0;
+    long long badWins = 0;
+    long long draws = 0;
+    long long stalemates = 0;   // Hit the turn cap without a winner
+    double seconds = 0.0;
+    long long heapAllocations = 0;  // Global heap allocations after each worker's first battle, -1 = not counted
+    size_t arenaPeakBytes = 0;      // Largest battle held by any worker's arena
+
+    double battlesPerSecond() const;
+    void merge(const SimulationResult& other);
+    void print() const;
+};
+
+// Plays one battle to completion with the greedy AI controlling both teams.
+// Returns the winning team, "Draw", or "Stalemate" if maxTurns is reached.
+// With a recorder, the whole battle is captured as a replay; with
+// `turnsPlayed`, the number of turns taken is stored there.
+std::string runHeadlessBattle(Battle& battle, int maxTurns = 10000, ReplayRecorder* recorder = nullptr,
+    int* turnsPlayed = nullptr);
+
+// Runs `battles` independent battles spread across `threads` workers (0 = one
+// per hardware thread), each built from `scenario` or, without one, the
+// default scenario. Battle i draws from RNG stream i of `seed`, so totals do
+// not depend on the thread count and any single battle can be replayed from
+// (seed, i). Each worker builds default-scenario battles in its own
+// BattleArena and resets it between them; a scenario file is instantiated
+// once per worker and rewound with restoreState. Either way the loop stops
+// touching the global heap once the first battle has sized everything.
+// With `analytics`, every worker feeds its battles' events into its own
+// BattleAnalytics and the copies are merged into `analytics` at the end.
+SimulationResult runSimulation(long long battles, int threads = 0, uint64_t seed = 0,
+    const BattleFileView* scenario = nullptr, BattleAnalytics* analytics = nullptr);
+
+// ==========================================
+// Snapshot Throughput
+// ==========================================
+struct SnapshotBenchmark {
+    int units = 0;
+    long long saves = 0;
+    long long restores = 0;
+    double saveSeconds = 0.0;
+    double restoreSeconds = 0.0;
+
+    void print() const;
+};
+
+// Plays a skirmish of `units` combatants partway in, then times repeated
+// saveState and restoreState calls for about `seconds` each.
+SnapshotBenchmark runSnapshotBenchmark(int units, double seconds = 1.0);
+
+// ==========================================
+// MCTS vs Greedy Evaluation
+// ==========================================
+struct MctsEvaluation {
+    long long battles = 0;
+    long long mctsWins = 0;     // Good Guys searched, Bad Guys greedy
+    long long greedyWins = 0;   // Same seeds with both sides greedy
+    MctsStats search;           // Totals over every decision
+
+    void print() const;
+};
+
+// Plays `battles` skirmishes of `unitsPerTeam` a side twice from the same
+// seeds: once with the Good Guys on MCTS, once with both teams greedy.
+MctsEvaluation runMctsEvaluation(long long battles, int unitsPerTeam, const MctsConfig& config);
+
+// ==========================================
+// Scenario Load Throughput
+// ==========================================
+struct ScenarioLoadBenchmark {
+    long long loads = 0;
+    double openSeconds = 0.0;       // Map and validate the file
+    double buildSeconds = 0.0;      // Instantiate a Battle from the view
+    double builderSeconds = 0.0;    // buildDefaultScenario, for comparison
+
+    void print() const;
+};
+
+// Opens and instantiates the battle file at `path` `loads` times.
+ScenarioLoadBenchmark runScenarioLoadBenchmark(const std::string& path, long long loads);
+
+// ==========================================
+// Replay Throughput
+// ==========================================
+struct ReplayBenchmark {
+    long long battles = 0;
+    long long turns = 0;
+    long long bytes = 0;
+    double recordSeconds = 0.0;     // Greedy AI play plus recording
+    double replaySeconds = 0.0;     // Decoding and re-simulating every replay
+    bool verified = false;
+
+    void print() const;
+};
+
+// Records `battles` default-scenario battles (stream i of `seed`), then
+// replays them all and checks every checksum.
+ReplayBenchmark runReplayBenchmark(long long battles, uint64_t seed = 0);
+
+#endif
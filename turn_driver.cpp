@@ -0,0 +1,251 @@
+#include "turn_driver.h"
+#include <vector>
+#include "battle_ai.h"
+#include "battle_file.h"
+#include "replay.h"
+
+// ==========================================
+// Turn Input
+// ==========================================
+void TurnInput::provide(std::optional<int> answer) {
+    answers.push_back(answer);
+    if (waiter) std::exchange(waiter, nullptr).resume();
+}
+
+void TurnInput::discard() {
+    answers.clear();
+    discarded = true;
+}
+
+// ==========================================
+// Helper: Target Selection
+// ==========================================
+namespace {
+
+Task<Combatant*> selectTarget(Combatant* actor, const std::pmr::vector<Combatant*>& participants, bool enemiesOnly,
+    TurnInput& input, std::ostream& out) {
+    out << "\nSelect Target (" << (enemiesOnly ? "Enemies" : "Allies") << "):\n";
+    std::vector<Combatant*> validTargets;
+
+    int index = 1;
+    for (auto* p : participants) {
+        if (p->isAlive()) {
+            bool isSameTeam = (p->getTeamId() == actor->getTeamId());
+
+            // If we want enemies only, skip team members
+            if (enemiesOnly && isSameTeam) continue;
+
+            // If we want allies only (beneficial actions), skip enemies
+            if (!enemiesOnly && !isSameTeam) continue;
+
+            out << index << ". " << p->getName()
+                << " [" << p->getTeam() << "] (HP: " << p->getHP() << ")\n";
+            validTargets.push_back(p);
+            index++;
+        }
+    }
+
+    if (validTargets.empty()) {
+        out << "No valid targets found.\n";
+        co_return nullptr;
+    }
+
+    out << "Choice: ";
+    std::optional<int> choice = co_await input.next();
+    if (!choice || *choice < 1 || *choice > static_cast<int>(validTargets.size())) co_return nullptr;
+    co_return validTargets[*choice - 1];
+}
+
+} // namespace
+
+// ==========================================
+// Logic: Turn Handlers
+// ==========================================
+Task<BattleAction> humanTurn(Combatant* actor, Battle& scenario, TurnInput& input, std::ostream& out,
+    const std::string& checkpointPath) {
+    BattleManager& battle = scenario.manager;
+    Grid& grid = scenario.grid;
+    BattleAction action;
+    bool turnComplete = false;
+    while (!turnComplete) {
+        out << "\n[MENU] 1.Attack  2.Guard  3.Move 4.Spell  5.Item  6.Save\nChoice: ";
+        std::optional<int> choice = co_await input.next();
+        if (!choice) {
+            out << "Invalid input.\n";
+            continue;
+        }
+
+        if (*choice == 1) { // ATTACK
+            // Attack always targets enemies
+            Combatant* target = co_await selectTarget(actor, battle.getParticipants(), true, input, out);
+            action = BattleAction();
+            action.type = ActionType::Attack;
+            action.target = target ? target->getSlot() : -1;
+            turnComplete = target && applyAction(actor, action, battle, grid);
+        }
+        else if (*choice == 2) { // GUARD
+            action = BattleAction();
+            action.type = ActionType::Guard;
+            turnComplete = applyAction(actor, action, battle, grid);
+        }
+        else if (*choice == 3) { // MOVE
+            out << "Direction (Press 1 to go North, 2 to go South, 3 to go East, 4 to go West.): ";
+            std::optional<int> dir = co_await input.next();
+            if (!dir) {
+                out << "Invalid input.\n";
+                continue;
+            }
+            action = BattleAction();
+            action.type = ActionType::Move;
+            switch (*dir) {
+            case 1: action.dy = 1; break; // North is +Y
+            case 2: action.dy = -1; break; // South is -Y
+            case 3: action.dx = 1; break; // East is +X
+            case 4: action.dx = -1; break; // West is -X
+            default:
+                out << "Invalid direction.\n";
+                continue;
+            }
+            turnComplete = applyAction(actor, action, battle, grid);
+            if (!turnComplete) {
+                out << "Cannot move in that direction.\n";
+            }
+        }
+        else if (*choice == 4) { // SPELL
+            if (actor->getSpells().empty()) {
+                out << "No spells known!\n";
+                continue;
+            }
+            out << "Select Spell:\n";
+            for (size_t i = 0; i < actor->getSpells().size(); ++i) {
+                const Spell& spell = actor->getSpell(static_cast<int>(i));
+                out << (i + 1) << ". " << spell.name
+                    << " (AOE: " << spell.aoe
+                    << ", " << spellCategoryName(spell.category) << ")\n";
+            }
+            std::optional<int> sIdx = co_await input.next();
+            if (!sIdx || *sIdx < 1 || *sIdx > static_cast<int>(actor->getSpells().size())) {
+                if (sIdx) input.discard();
+                out << "Invalid spell selection.\n";
+                continue;
+            }
+            int spellIndex = *sIdx - 1; // 0-based
+
+            // Determine targeting based on category
+            bool enemiesOnly = (actor->getSpell(spellIndex).category == SpellCategory::Debuff);
+
+            Combatant* target = co_await selectTarget(actor, battle.getParticipants(), enemiesOnly, input, out);
+            action = BattleAction();
+            action.type = ActionType::Spell;
+            action.target = target ? target->getSlot() : -1;
+            action.index = spellIndex;
+            turnComplete = target && applyAction(actor, action, battle, grid);
+        }
+        else if (*choice == 5) { // ITEM
+            if (actor->getInventory().empty()) {
+                out << "Inventory empty!\n";
+                continue;
+            }
+            out << "Select Item:\n";
+            for (size_t i = 0; i < actor->getInventory().size(); ++i) {
+                const Item& item = actor->getItem(static_cast<int>(i));
+                out << (i + 1) << ". " << item.name << " (x" << actor->getInventory()[i].quantity
+                    << ", " << itemCategoryName(item.category) << ")\n";
+            }
+            std::optional<int> iIdx = co_await input.next();
+            if (!iIdx || *iIdx < 1 || *iIdx > static_cast<int>(actor->getInventory().size())) {
+                if (iIdx) input.discard();
+                out << "Invalid item selection.\n";
+                continue;
+            }
+            int itemIndex = *iIdx - 1;
+
+            // Determine targeting based on category
+            // Assuming Debuffs are the only offensive items, everything else (Healing/Buff/RestoreMP) is friendly
+            bool enemiesOnly = (actor->getItem(itemIndex).category == ItemCategory::Debuff);
+
+            Combatant* target = co_await selectTarget(actor, battle.getParticipants(), enemiesOnly, input, out);
+            action = BattleAction();
+            action.type = ActionType::Item;
+            action.target = target ? target->getSlot() : -1;
+            action.index = itemIndex;
+            turnComplete = target && applyAction(actor, action, battle, grid);
+        }
+        else if (*choice == 6) { // SAVE
+            if (saveBattleFile(checkpointPath, scenario))
+                out << "[Info] Checkpoint saved to " << checkpointPath << " (resume with --scenario)\n";
+            else
+                out << "[Info] Could not write " << checkpointPath << "\n";
+        }
+        else {
+            out << "Invalid input.\n";
+            input.discard();
+        }
+    }
+    co_return action;
+}
+
+Task<std::string> playBattle(Battle& scenario, TurnInput& input, std::ostream& out,
+    const std::string& checkpointPath, ReplayRecorder* recorder) {
+    BattleManager& battle = scenario.manager;
+    Grid& grid = scenario.grid;
+    while (true) {
+        // A. Victory Check
+        std::string winner = battle.getWinner();
+        if (winner != "None") {
+            out << "\n=================================\n";
+            out << "       " << winner << " TEAM WINS!       \n";
+            out << "=================================\n";
+            co_return winner;
+        }
+
+        // B. Get Next Actor
+        Combatant* actor = battle.getNextActiveCombatant();
+        if (!actor) co_return "Draw";
+
+        grid.drawGrid(out);
+        actor->startTurn();
+
+        out << "\n>>> TURN: " << actor->getName()
+            << " (HP:" << actor->getHP() << " MP:" << actor->getMP() << ")\n";
+
+        // C. Handle Turn Type
+        BattleAction action;
+        if (actor->isBroken()) {
+            action = choosePanicAction(actor, grid);
+            playTurn(actor, action, battle, grid);
+        }
+        else if (actor->getTeam() == "Good Guys") {
+            action = co_await humanTurn(actor, scenario, input, out, checkpointPath);
+        }
+        else {
+            action = chooseAIAction(actor, grid);
+            playTurn(actor, action, battle, grid);
+        }
+        if (recorder) recorder->recordTurn(actor, action, scenario);
+    }
+}
+
+// ==========================================
+// Console Adapter
+// ==========================================
+bool feedBattle(Task<std::string>& battle, TurnInput& input, std::istream& in) {
+    battle.start();
+    while (!battle.done()) {
+        int answer;
+        if (in >> answer) {
+            input.provide(answer);
+        }
+        else {
+            if (in.eof()) return false;
+            in.clear();
+            in.ignore(1000, '\n');
+            input.provide(std::nullopt);
+        }
+        if (input.takeDiscard()) {
+            in.clear();
+            in.ignore(1000, '\n');
+        }
+    }
+    return true;
+}
@@ -0,0 +1,147 @@
+#ifndef TURN_DRIVER_H
+#define TURN_DRIVER_H
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+#include "battle_action.h"
+#include "scenario.h"
+
+class ReplayRecorder;
+
+// ==========================================
+// Coroutine Task
+// ==========================================
+// A lazily started coroutine that produces a T. Awaiting a Task runs it and
+// resumes the awaiting coroutine once it returns. Whoever owns a top-level
+// Task calls start() once and then checks done(); destroying an unfinished
+// Task destroys it and every Task it is awaiting.
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct ResumeAwaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finished) noexcept {
+                    std::coroutine_handle<> next = finished.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return ResumeAwaiter{};
+        }
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { reset(); }
+
+    // Runs until the coroutine first waits (or finishes).
+    void start() { handle.resume(); }
+    bool done() const { return handle && handle.done(); }
+    // The returned value; rethrows what the coroutine threw.
+    T& result() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+        return *handle.promise().value;
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return std::move(result()); }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    void reset() {
+        if (handle) handle.destroy();
+        handle = nullptr;
+    }
+};
+
+// ==========================================
+// Turn Input
+// ==========================================
+// Where a human turn's answers come from. The turn co_awaits next() for
+// each number it needs (menu choice, direction, spell, item, target) and
+// is suspended until provide() supplies one; nullopt stands for an answer
+// that was not a number. provide() resumes the waiting turn on the calling
+// thread, so one thread can feed any number of battles, each with its own
+// TurnInput. Not thread-safe.
+class TurnInput {
+public:
+    struct NextAnswer {
+        TurnInput& input;
+
+        bool await_ready() const noexcept { return !input.answers.empty(); }
+        void await_suspend(std::coroutine_handle<> turn) noexcept { input.waiter = turn; }
+        std::optional<int> await_resume() {
+            std::optional<int> answer = input.answers.front();
+            input.answers.pop_front();
+            return answer;
+        }
+    };
+
+    NextAnswer next() { return NextAnswer{ *this }; }
+    void provide(std::optional<int> answer);
+    bool waiting() const { return static_cast<bool>(waiter); }
+
+    // Called by the turn after a bad answer: drops answers already queued,
+    // and tells a line-based source to skip the rest of its line.
+    void discard();
+    bool takeDiscard() { return std::exchange(discarded, false); }
+
+private:
+    std::deque<std::optional<int>> answers;
+    std::coroutine_handle<> waiter;
+    bool discarded = false;
+};
+
+// ==========================================
+// Turn Driver
+// ==========================================
+
+// The console menu for one human turn: asks until the player picks an
+// action that succeeds, performs it and returns it. Save writes a
+// checkpoint to `checkpointPath` and keeps the turn open.
+Task<BattleAction> humanTurn(Combatant* actor, Battle& scenario, TurnInput& input, std::ostream& out,
+    const std::string& checkpointPath);
+
+// Plays `scenario` to the end, narrating to `out`: the Good Guys take human
+// turns from `input`, everyone else the greedy AI, and broken units panic.
+// Every turn goes to `recorder` when given. Returns the winner, or "Draw"
+// when nobody is left to act.
+Task<std::string> playBattle(Battle& scenario, TurnInput& input, std::ostream& out,
+    const std::string& checkpointPath, ReplayRecorder* recorder = nullptr);
+
+// Console adapter: starts `battle` and answers it from whitespace-separated
+// numbers on `in` (std::cin, or a script file for headless runs). Returns
+// false if `in` ran out first, leaving the battle suspended mid-turn.
+bool feedBattle(Task<std::string>& battle, TurnInput& input, std::istream& in);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ==========================================
+// LEB128 Varints
+// ==========================================
+// Unsigned values go out 7 bits per byte, low bits first, with the top bit
+// set on every byte but the last. Signed values are zigzag-mapped first so
+// small negatives stay short. Floats and checksums are written as fixed
+// little-endian words.
+inline uint64_t zigzagEncode(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline void writeSignedVarint(std::vector<uint8_t>& out, int64_t v) {
+    writeVarint(out, zigzagEncode(v));
+}
+
+inline void writeFixed(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+inline void writeFloat(std::vector<uint8_t>& out, float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    writeFixed(out, bits, 4);
+}
+
+inline void writeString(std::vector<uint8_t>& out, std::string_view s) {
+    writeVarint(out, s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// Reads back what the writers above produce. Running off the end (or a
+// varint longer than 64 bits) sets failed() and returns zeros from then on,
+// so callers can decode a whole record and check once.
+class VarintReader {
+private:
+    const uint8_t* cur;
+    const uint8_t* end;
+    bool bad = false;
+
+public:
+    VarintReader(const uint8_t* data, size_t size) : cur(data), end(data + size) {}
+
+    bool failed() const { return bad; }
+    // Marks the stream bad, e.g. when a decoded value is out of range.
+    void fail() { bad = true; }
+    bool atEnd() const { return cur == end; }
+    size_t remaining() const { return static_cast<size_t>(end - cur); }
+
+    uint64_t read() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64 && !bad; shift += 7) {
+            if (cur == end) break;
+            uint8_t b = *cur++;
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        bad = true;
+        return 0;
+    }
+
+    int64_t readSigned() { return zigzagDecode(read()); }
+
+    uint64_t readFixed(int bytes) {
+        if (bad || remaining() < static_cast<size_t>(bytes)) {
+            bad = true;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(*cur++) << (8 * i);
+        return v;
+    }
+
+    uint8_t readByte() { return static_cast<uint8_t>(readFixed(1)); }
+
+    float readFloat() {
+        uint32_t bits = static_cast<uint32_t>(readFixed(4));
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    std::string readString() {
+        uint64_t size = read();
+        if (bad || size > remaining()) {
+            bad = true;
+            return std::string();
+        }
+        std::string s(reinterpret_cast<const char*>(cur), static_cast<size_t>(size));
+        cur += size;
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "work_stealing_pool.h"
+
+namespace {
+
+// Which pool and worker the calling thread belongs to, if any.
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(int threads, Handler handler) : handler(std::move(handler)) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+    for (int i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < threads; ++i) workers.emplace_back([this, i]() { run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() { finish(); }
+
+void WorkStealingPool::finish() {
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void WorkStealingPool::submit(uint32_t task) {
+    int target = currentPool == this ? currentWorker
+        : static_cast<int>(nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size());
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(task);
+    }
+    // Paired with the sleeper count a worker raises before its last check,
+    // so either it sees this task or this sees it asleep and wakes it.
+    pending.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> guard(idleLock);
+        idle.notify_one();
+    }
+}
+
+bool WorkStealingPool::take(int worker, uint32_t& task) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    int count = static_cast<int>(queues.size());
+    for (int i = 1; i < count; ++i) {
+        Queue& victim = *queues[(worker + i) % count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int worker) {
+    currentPool = this;
+    currentWorker = worker;
+    for (;;) {
+        uint32_t task;
+        if (take(worker, task)) {
+            pending.fetch_sub(1);
+            handler(worker, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(idleLock);
+        sleepers.fetch_add(1);
+        idle.wait(guard, [this]() { return pending.load() > 0 || stopping; });
+        sleepers.fetch_sub(1);
+        if (stopping && pending.load() == 0) return;
+    }
+}
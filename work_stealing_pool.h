@@ -0,0 +1,66 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ==========================================
+// Work-Stealing Thread Pool
+// ==========================================
+// Runs small integer tasks through one handler. Every worker owns a deque:
+// it pushes and pops its own tasks at the back (newest first, still warm in
+// cache) and, when that runs dry, steals the oldest task from the front of
+// another worker's deque. Tasks submitted from outside the pool are dealt
+// round-robin. Idle workers sleep until a task arrives.
+class WorkStealingPool {
+public:
+    using Handler = std::function<void(int worker, uint32_t task)>;
+
+    // Starts `threads` workers (0 = one per hardware thread).
+    WorkStealingPool(int threads, Handler handler);
+    // Calls finish().
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Safe from any thread; from one of this pool's workers the task goes
+    // onto that worker's own deque.
+    void submit(uint32_t task);
+    // Runs every queued task, including any the tasks themselves submit,
+    // then joins the workers. The pool stays valid for tasks to submit into
+    // until this returns; nothing may be submitted afterwards.
+    void finish();
+
+    int threadCount() const { return static_cast<int>(workers.size()); }
+    long long stealCount() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<uint32_t> tasks;
+    };
+
+    Handler handler;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<long long> pending{ 0 };
+    std::atomic<int> sleepers{ 0 };
+    std::atomic<unsigned> nextQueue{ 0 };
+    std::atomic<long long> steals{ 0 };
+    std::mutex idleLock;
+    std::condition_variable idle;
+    bool stopping = false;
+
+    void run(int worker);
+    bool take(int worker, uint32_t& task);
+};
+
+#endif